@@ -0,0 +1,294 @@
+
+#include "common.h"
+
+/** This is the benchmark harness behind 'make bench'. It runs the program over
+ *  the same input files once for every combination of thread count, chunk
+ *  size, and mode it is given, and prints a single tab-separated line for
+ *  every combination, under a header line, so the results can be fed straight
+ *  into whatever is comparing them, be it a spreadsheet, awk, or a plotting
+ *  script.
+ * 
+ *  A mode is just a comma-separated list of options to pass along to the
+ *  program, such as '--table=local,--join', which is also how it is printed,
+ *  so any option the program has can be benchmarked without the harness
+ *  having to know about it. Every combination is run a number of times, and
+ *  only the fastest run is reported, since anything slower than that was slowed
+ *  down by something other than the program itself.
+ * 
+ *  The wall time is measured around the whole run, from the fork to the wait,
+ *  and the throughput is simply the total size of the input files over that
+ *  time. The peak resident set size comes from the kernel's accounting for
+ *  the child, which 'wait4' hands back along with its exit status.
+ * 
+ */
+struct benchmark_t {
+    const char* program;
+    char** threads;
+    size_t number_of_threads;
+    char** chunk_sizes;
+    size_t number_of_chunk_sizes;
+    char** modes;
+    size_t number_of_modes;
+    size_t repeat;
+    char** filenames;
+    size_t number_of_files;
+};
+
+/** This is the outcome of a single run of the program.
+ * 
+ */
+struct measurement_t {
+    double seconds;
+    long max_rss_kib;
+};
+
+/** This function appends an element to a growing array of strings.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+static void append_string(char*** strings, size_t* count, char* string) {
+    char** grown = realloc(*strings, (*count + 1) * sizeof (char *));
+
+    if (grown == NULL) {
+        fatal_error("Memory allocation failure in append_string()");
+    }
+
+    grown[(*count)++] = string;
+
+    *strings = grown;
+}
+
+/** This function splits a comma-separated list into its elements, appending
+ *  each of them to the array. The list itself is split in place, which is
+ *  fine, since the arguments are never needed whole again.
+ * 
+ */
+__attribute__((nonnull(1,2,3)))
+static void split_list(char*** strings, size_t* count, char* list) {
+    char* state = NULL;
+
+    for (char* element = strtok_r(list, ",", &state); element; element = strtok_r(NULL, ",", &state)) {
+        append_string(strings, count, element);
+    }
+}
+
+/** This function returns the total size of the input files, in bytes.
+ * 
+ */
+__attribute__((nonnull(1)))
+static size_t total_input_size(const struct benchmark_t* benchmark) {
+    size_t total = 0;
+
+    for (size_t i = 0; i < benchmark->number_of_files; ++i) {
+        struct stat file_info;
+
+        if (stat(benchmark->filenames[i], &file_info) == -1) {
+            fprintf(stderr, "[Error] %s (%s)\n", strerror(errno), benchmark->filenames[i]);
+            exit(EXIT_FAILURE);
+        }
+
+        total += (size_t) file_info.st_size;
+    }
+
+    return total;
+}
+
+/** This function builds the argument vector for a single run, which is the
+ *  thread count, the chunk size unless it is left to the program's default,
+ *  the mode's options, unless there are none, and then the input files. The
+ *  options are split out of the given copy of the mode.
+ * 
+ */
+__attribute__((nonnull(1,2,3), returns_nonnull))
+static char** build_arguments(const struct benchmark_t* benchmark, char* threads, char* chunk_size, char* options) {
+    char** arguments = NULL;
+    size_t count = 0;
+
+    append_string(&arguments, &count, (char *) benchmark->program);
+    append_string(&arguments, &count, "--threads");
+    append_string(&arguments, &count, threads);
+
+    if (!strings_match(chunk_size, "default")) {
+        append_string(&arguments, &count, "--chunk-size");
+        append_string(&arguments, &count, chunk_size);
+    }
+
+    if (options) {
+        split_list(&arguments, &count, options);
+    }
+
+    for (size_t i = 0; i < benchmark->number_of_files; ++i) {
+        append_string(&arguments, &count, benchmark->filenames[i]);
+    }
+
+    append_string(&arguments, &count, NULL);
+
+    return arguments;
+}
+
+/** This function runs the program once, with its output thrown away, and
+ *  measures how long it took and how much memory it needed at its peak. A run
+ *  that fails is a fatal error, since its time would mean nothing.
+ * 
+ */
+__attribute__((nonnull(1)))
+static struct measurement_t run_once(char** arguments) {
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pid_t child = fork();
+
+    if (child == -1) {
+        fatal_error("Could not fork benchmark process");
+    }
+
+    if (child == 0) {
+        int null_device = open("/dev/null", O_WRONLY);
+
+        if ((null_device == -1) || (dup2(null_device, STDOUT_FILENO) == -1)) {
+            _exit(127);
+        }
+
+        execv(arguments[0], arguments);
+
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+
+    while (wait4(child, &status, 0, &usage) == -1) {
+        if (errno != EINTR) {
+            fatal_error("Could not wait for benchmark process");
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS)) {
+        fprintf(stderr, "[Error] %s (%s)\n", "Benchmark run failed", arguments[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    struct measurement_t measurement = {
+        (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9,
+        usage.ru_maxrss
+    };
+
+    return measurement;
+}
+
+/** This function runs a single combination as many times as it was asked to,
+ *  and prints the fastest of them, along with the largest peak it saw.
+ * 
+ */
+__attribute__((nonnull(1,2,3,4)))
+static void run_combination(const struct benchmark_t* benchmark, char* threads, char* chunk_size, const char* mode, size_t input_size) {
+    char* options = NULL;
+
+    if (!strings_match(mode, "default") && ((options = strdup(mode)) == NULL)) {
+        fatal_error("Memory allocation failure in run_combination()");
+    }
+
+    char** arguments = build_arguments(benchmark, threads, chunk_size, options);
+
+    struct measurement_t best = run_once(arguments);
+
+    for (size_t i = 1; i < benchmark->repeat; ++i) {
+        struct measurement_t measurement = run_once(arguments);
+
+        best.seconds     = MIN(best.seconds, measurement.seconds);
+        best.max_rss_kib = MAX(best.max_rss_kib, measurement.max_rss_kib);
+    }
+
+    printf("%s\t%s\t%s\t%.4f\t%.3f\t%ld\n", threads, chunk_size, mode, best.seconds, (double) input_size / best.seconds / 1e9, best.max_rss_kib);
+    fflush(stdout);
+
+    FREE(arguments);
+    FREE(options);
+}
+
+static const char* usage_str = "Usage: benchmark [--program PATH] [--threads LIST] [--chunk-sizes LIST] [--mode OPTIONS]... [--repeat N] FILE...";
+
+int main(int argc, char *argv[])
+{
+    struct benchmark_t benchmark;
+
+    memset(&benchmark, 0, sizeof (benchmark));
+
+    benchmark.program = "./common";
+    benchmark.repeat  = 3;
+
+    for (int i = 1; i < argc; ++i) {
+        char* argument = argv[i];
+        char* value    = NULL;
+
+        if (strncmp(argument, "--", 2) == 0) {
+            char* equals_sign = strchr(argument, '=');
+
+            if (equals_sign) {
+                *equals_sign = NUL;
+                value = equals_sign + 1;
+            } else if (i + 1 < argc) {
+                value = argv[++i];
+            } else {
+                fprintf(stderr, "%s\n", usage_str);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (value == NULL) {
+            append_string(&benchmark.filenames, &benchmark.number_of_files, argument);
+        } else if (strings_match(argument, "--program")) {
+            benchmark.program = value;
+        } else if (strings_match(argument, "--threads")) {
+            split_list(&benchmark.threads, &benchmark.number_of_threads, value);
+        } else if (strings_match(argument, "--chunk-sizes")) {
+            split_list(&benchmark.chunk_sizes, &benchmark.number_of_chunk_sizes, value);
+        } else if (strings_match(argument, "--mode")) {
+            append_string(&benchmark.modes, &benchmark.number_of_modes, value);
+        } else if (strings_match(argument, "--repeat")) {
+            benchmark.repeat = MAX(parse_size(value), 1);
+        } else {
+            fprintf(stderr, "[Error] %s (%s)\n", "Unknown option", argument);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (benchmark.number_of_files == 0) {
+        fprintf(stderr, "%s\n", usage_str);
+        exit(EXIT_FAILURE);
+    }
+
+    if (benchmark.number_of_threads == 0) {
+        append_string(&benchmark.threads, &benchmark.number_of_threads, "1");
+    }
+
+    if (benchmark.number_of_chunk_sizes == 0) {
+        append_string(&benchmark.chunk_sizes, &benchmark.number_of_chunk_sizes, "default");
+    }
+
+    if (benchmark.number_of_modes == 0) {
+        append_string(&benchmark.modes, &benchmark.number_of_modes, "default");
+    }
+
+    const size_t input_size = total_input_size(&benchmark);
+
+    printf("threads\tchunk_size\tmode\tseconds\tgb_per_second\tmax_rss_kib\n");
+
+    for (size_t m = 0; m < benchmark.number_of_modes; ++m) {
+        for (size_t c = 0; c < benchmark.number_of_chunk_sizes; ++c) {
+            for (size_t t = 0; t < benchmark.number_of_threads; ++t) {
+                run_combination(&benchmark, benchmark.threads[t], benchmark.chunk_sizes[c], benchmark.modes[m], input_size);
+            }
+        }
+    }
+
+    FREE(benchmark.threads);
+    FREE(benchmark.chunk_sizes);
+    FREE(benchmark.modes);
+    FREE(benchmark.filenames);
+
+    return EXIT_SUCCESS;
+}
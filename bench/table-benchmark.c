@@ -0,0 +1,575 @@
+
+#include "common.h"
+
+/** This is a microbenchmark of the hash table on its own, without any input
+ *  files, tokenizing, or I/O in the way. It generates a set of distinct keys
+ *  up front, then has a number of threads add words drawn from them to the
+ *  table, with 'add_word_to_table', exactly as the program's own threads do,
+ *  and once the table has been sealed, has the same threads look words up in
+ *  it with 'count_word_in_table', as the probe phase of join mode does. It
+ *  reports the throughput of either phase, along with the 99th percentile of
+ *  the latency of a single operation, as a single tab-separated line under a
+ *  header line, like the benchmark harness does.
+ * 
+ *  The table keeps its state in globals, so every run of this tool measures a
+ *  single configuration, and 'make bench-table' runs it once for every one.
+ * 
+ *  The skew is how the words are drawn from the keys. A uniform skew draws
+ *  every key just as often, the Zipf skew draws them the way words are drawn
+ *  in natural language, and the hot skew draws the same key every single time,
+ *  which is the worst case for every kind of contention on a single entry. The
+ *  lengths of the keys are uniformly distributed between a minimum and a
+ *  maximum, so that words longer than the inline size can be included or not.
+ * 
+ */
+typedef enum {
+    SKEW_UNIFORM,
+    SKEW_ZIPF,
+    SKEW_HOT
+} skew_t;
+
+static const char* skew_names[] = { "uniform", "zipf", "hot" };
+
+static const char* table_mode_names[] = { "locked", "lockfree", "local", "partitioned" };
+
+static const char* hash_algorithm_names[] = { "wyhash", "murmur", "weinberger", "sedgewick", "trivial" };
+
+#ifndef LATENCY_SAMPLE_INTERVAL
+/** Reading the clock costs about as much as a table operation does, so only
+ *  one operation in this many is timed on its own, which keeps the timing from
+ *  dominating the throughput while still leaving plenty of samples.
+ * 
+ */
+#define LATENCY_SAMPLE_INTERVAL (16)
+#else
+#error "LATENCY_SAMPLE_INTERVAL already defined."
+#endif // LATENCY_SAMPLE_INTERVAL
+
+#ifndef TABLE_ACCESS_BATCH
+/** The program's threads bracket every chunk of input with a call to
+ *  'begin_table_access' and 'end_table_access', so the benchmark's threads
+ *  do the same for every batch of this many operations.
+ * 
+ */
+#define TABLE_ACCESS_BATCH (4096)
+#else
+#error "TABLE_ACCESS_BATCH already defined."
+#endif // TABLE_ACCESS_BATCH
+
+/** The keys all live in a single buffer, one after the other, and are found by
+ *  their offsets and lengths.
+ * 
+ */
+struct keys_t {
+    char* buffer;
+    size_t* offsets;
+    size_t* lengths;
+    size_t count;
+};
+
+struct configuration_t {
+    int threads;
+    size_t operations;
+    size_t number_of_keys;
+    skew_t skew;
+    double exponent;
+    size_t min_length;
+    size_t max_length;
+    uint64_t seed;
+    int header;
+};
+
+/** Every thread draws the keys for both of its phases before the clock starts,
+ *  so that drawing them is never part of what is measured, and keeps its own
+ *  latency samples, in nanoseconds, which are only merged once it has been
+ *  joined. It also notes when it started and finished each phase, since only
+ *  the threads themselves know when they were actually let go.
+ * 
+ */
+struct worker_t {
+    pthread_t thread;
+    size_t operations;
+    uint64_t insert_start;
+    uint64_t insert_end;
+    uint64_t lookup_start;
+    uint64_t lookup_end;
+    uint32_t* insert_keys;
+    uint32_t* lookup_keys;
+    uint64_t* insert_latencies;
+    uint64_t* lookup_latencies;
+    size_t number_of_samples;
+};
+
+static struct keys_t keys;
+
+static pthread_barrier_t phase_barrier;
+
+/** This is the splitmix64 generator, the same one the corpus generator uses.
+ * 
+ */
+__attribute__((nonnull(1)))
+static inline uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+__attribute__((nonnull(1)))
+static inline double next_uniform(uint64_t* state) {
+    return (double) (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static inline uint64_t current_nanoseconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+/** This function returns the index of the given name in a table of names, and
+ *  exits with the given error message if it is not in it.
+ * 
+ */
+__attribute__((nonnull(1,3,4)))
+static int find_name(const char** names, size_t number_of_names, const char* name, const char* error_message) {
+    for (size_t i = 0; i < number_of_names; ++i) {
+        if (strings_match(names[i], name)) {
+            return (int) i;
+        }
+    }
+
+    fprintf(stderr, "[Error] %s (%s)\n", error_message, name);
+    exit(EXIT_FAILURE);
+}
+
+/** Every key begins with its own index, spelled out in base 26 with as many
+ *  letters as the largest index needs, which is what makes the keys distinct,
+ *  and is padded out with random letters to a random length. A key is never
+ *  shorter than its index, though, whatever the minimum length.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void generate_keys(const struct configuration_t* configuration) {
+    size_t width = 1;
+
+    for (size_t limit = 26; limit < configuration->number_of_keys; limit *= 26) {
+        ++width;
+    }
+
+    const size_t longest = MAX(width, configuration->max_length);
+
+    keys.count   = configuration->number_of_keys;
+    keys.buffer  = malloc(keys.count * longest);
+    keys.offsets = malloc(keys.count * sizeof (size_t));
+    keys.lengths = malloc(keys.count * sizeof (size_t));
+
+    if ((keys.buffer == NULL) || (keys.offsets == NULL) || (keys.lengths == NULL)) {
+        fatal_error("Memory allocation failure in generate_keys()");
+    }
+
+    uint64_t state = configuration->seed;
+
+    size_t offset = 0;
+
+    for (size_t i = 0; i < keys.count; ++i) {
+        const size_t span = configuration->max_length - configuration->min_length + 1;
+        const size_t length = MAX(width, configuration->min_length + (size_t) (next_random(&state) % span));
+
+        char* key = keys.buffer + offset;
+
+        size_t index = i;
+
+        for (size_t j = 0; j < width; ++j, index /= 26) {
+            key[j] = (char) ('a' + (index % 26));
+        }
+
+        for (size_t j = width; j < length; ++j) {
+            key[j] = (char) ('a' + (next_random(&state) % 26));
+        }
+
+        keys.offsets[i] = offset;
+        keys.lengths[i] = length;
+
+        offset += length;
+    }
+}
+
+/** This function builds the cumulative distribution of the key ranks for the
+ *  Zipf skew, in which the key of rank r is drawn with a probability
+ *  proportional to 1 / (r + 1)^s. Since the keys are random to begin with, a
+ *  key's rank is simply its index.
+ * 
+ */
+__attribute__((malloc, returns_nonnull))
+static double* create_distribution(size_t number_of_keys, double exponent) {
+    double* distribution = malloc(number_of_keys * sizeof (double));
+
+    if (distribution == NULL) {
+        fatal_error("Memory allocation failure in create_distribution()");
+    }
+
+    double total = 0.0;
+
+    for (size_t rank = 0; rank < number_of_keys; ++rank) {
+        total += 1.0 / pow((double) (rank + 1), exponent);
+        distribution[rank] = total;
+    }
+
+    for (size_t rank = 0; rank < number_of_keys; ++rank) {
+        distribution[rank] /= total;
+    }
+
+    return distribution;
+}
+
+__attribute__((nonnull(1,3)))
+static uint32_t draw_zipf_key(const double* distribution, size_t number_of_keys, uint64_t* state) {
+    const double u = next_uniform(state);
+
+    size_t low = 0;
+    size_t high = number_of_keys - 1;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (distribution[middle] < u) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return (uint32_t) low;
+}
+
+/** This function draws the given number of keys according to the skew.
+ * 
+ */
+__attribute__((nonnull(1,3,4)))
+static void draw_keys(const struct configuration_t* configuration, const double* distribution, uint32_t* drawn, uint64_t* state, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        switch (configuration->skew) {
+            case SKEW_UNIFORM: {
+                drawn[i] = (uint32_t) (next_random(state) % keys.count);
+            } break;
+
+            case SKEW_ZIPF: {
+                drawn[i] = draw_zipf_key(distribution, keys.count, state);
+            } break;
+
+            case SKEW_HOT: {
+                drawn[i] = 0;
+            } break;
+        }
+    }
+}
+
+__attribute__((always_inline))
+static inline void insert_key(uint32_t key) {
+    add_word_to_table(keys.buffer + keys.offsets[key], keys.lengths[key], 1);
+}
+
+__attribute__((always_inline))
+static inline void lookup_key(uint32_t key) {
+    count_word_in_table(keys.buffer + keys.offsets[key], keys.lengths[key], 2);
+}
+
+/** Every thread inserts its keys in batches, each bracketed by a table access,
+ *  timing every few operations on their own, then waits for the table to be
+ *  sealed, and looks its other keys up the same way. Every thread reads the
+ *  clock itself, as soon as a barrier lets it go and as soon as its loop is
+ *  done, since the main thread, released by the same barrier, may well not
+ *  get to read the clock until the threads are partway through the phase.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void* table_benchmark_thread(void* arg) {
+    struct worker_t* worker = (struct worker_t *) arg;
+
+    pthread_barrier_wait(&phase_barrier);
+
+    worker->insert_start = current_nanoseconds();
+
+    size_t sample = 0;
+
+    for (size_t start = 0; start < worker->operations; start += TABLE_ACCESS_BATCH) {
+        const size_t end = MIN(start + TABLE_ACCESS_BATCH, worker->operations);
+
+        begin_table_access();
+
+        for (size_t i = start; i < end; ++i) {
+            if (i % LATENCY_SAMPLE_INTERVAL) {
+                insert_key(worker->insert_keys[i]);
+            } else {
+                const uint64_t before = current_nanoseconds();
+                insert_key(worker->insert_keys[i]);
+                worker->insert_latencies[sample++] = current_nanoseconds() - before;
+            }
+        }
+
+        end_table_access();
+    }
+
+    worker->insert_end = current_nanoseconds();
+
+    pthread_barrier_wait(&phase_barrier);
+    pthread_barrier_wait(&phase_barrier);
+
+    worker->lookup_start = current_nanoseconds();
+
+    sample = 0;
+
+    for (size_t i = 0; i < worker->operations; ++i) {
+        if (i % LATENCY_SAMPLE_INTERVAL) {
+            lookup_key(worker->lookup_keys[i]);
+        } else {
+            const uint64_t before = current_nanoseconds();
+            lookup_key(worker->lookup_keys[i]);
+            worker->lookup_latencies[sample++] = current_nanoseconds() - before;
+        }
+    }
+
+    worker->lookup_end = current_nanoseconds();
+
+    return NULL;
+}
+
+static int compare_latencies(const void* a, const void* b) {
+    const uint64_t x = *(const uint64_t *) a;
+    const uint64_t y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/** A phase lasts from the moment the first thread started it to the moment
+ *  the last thread finished it, which is what its throughput is measured by.
+ * 
+ */
+__attribute__((nonnull(1)))
+static double phase_seconds(const struct worker_t* workers, int threads, int lookups) {
+    uint64_t start = UINT64_MAX;
+    uint64_t end   = 0;
+
+    for (int i = 0; i < threads; ++i) {
+        start = MIN(start, (lookups) ? workers[i].lookup_start : workers[i].insert_start);
+        end   = MAX(end, (lookups) ? workers[i].lookup_end : workers[i].insert_end);
+    }
+
+    return (double) (end - start) / 1e9;
+}
+
+/** This function gathers every thread's latency samples for either the insert
+ *  phase or the lookup phase, and returns their 99th percentile.
+ * 
+ */
+__attribute__((nonnull(1)))
+static uint64_t latency_percentile(const struct worker_t* workers, int threads, int lookups) {
+    size_t total = 0;
+
+    for (int i = 0; i < threads; ++i) {
+        total += workers[i].number_of_samples;
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t* samples = malloc(total * sizeof (uint64_t));
+
+    if (samples == NULL) {
+        fatal_error("Memory allocation failure in latency_percentile()");
+    }
+
+    size_t count = 0;
+
+    for (int i = 0; i < threads; ++i) {
+        const uint64_t* latencies = (lookups) ? workers[i].lookup_latencies : workers[i].insert_latencies;
+
+        memcpy(samples + count, latencies, workers[i].number_of_samples * sizeof (uint64_t));
+
+        count += workers[i].number_of_samples;
+    }
+
+    qsort(samples, total, sizeof (uint64_t), compare_latencies);
+
+    const uint64_t percentile = samples[(size_t) ceil(0.99 * (double) total) - 1];
+
+    FREE(samples);
+
+    return percentile;
+}
+
+static const char* usage_str = "Usage: table-benchmark [--threads N] [--table MODE] [--hash NAME] [--operations N] [--keys N] [--skew uniform|zipf|hot] [--exponent S] [--min-length N] [--max-length N] [--seed N] [--combine] [--no-header]";
+
+int main(int argc, char *argv[])
+{
+    struct configuration_t configuration = { 1, 4 * 1024 * 1024, 1024 * 1024, SKEW_UNIFORM, 1.0, 4, 12, 42, TRUE };
+
+    for (int i = 1; i < argc; ++i) {
+        if (strings_match(argv[i], "--no-header")) {
+            configuration.header = FALSE;
+            continue;
+        }
+
+        if (strings_match(argv[i], "--combine")) {
+            settings_set_combine(TRUE);
+            continue;
+        }
+
+        if ((i + 1 == argc) || (strncmp(argv[i], "--", 2) != 0)) {
+            fprintf(stderr, "%s\n", usage_str);
+            exit(EXIT_FAILURE);
+        }
+
+        const char* option = argv[i];
+        const char* value  = argv[++i];
+
+        if (strings_match(option, "--threads")) {
+            configuration.threads = (int) MAX(parse_size(value), 1);
+        } else if (strings_match(option, "--table")) {
+            settings_set_table_mode((table_mode_t) find_name(table_mode_names, 4, value, "Unknown table mode"));
+        } else if (strings_match(option, "--hash")) {
+            settings_set_hash_algorithm((hash_algorithm_t) find_name(hash_algorithm_names, 5, value, "Unknown hash function"));
+        } else if (strings_match(option, "--operations")) {
+            configuration.operations = parse_size(value);
+        } else if (strings_match(option, "--keys")) {
+            configuration.number_of_keys = MAX(MIN(parse_size(value), UINT32_MAX), 1);
+        } else if (strings_match(option, "--skew")) {
+            configuration.skew = (skew_t) find_name(skew_names, 3, value, "Unknown skew");
+        } else if (strings_match(option, "--exponent")) {
+            configuration.exponent = atof(value);
+        } else if (strings_match(option, "--min-length")) {
+            configuration.min_length = parse_size(value);
+        } else if (strings_match(option, "--max-length")) {
+            configuration.max_length = parse_size(value);
+        } else if (strings_match(option, "--seed")) {
+            configuration.seed = strtoull(value, NULL, 10);
+        } else {
+            fprintf(stderr, "[Error] %s (%s)\n", "Unknown option", option);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if ((configuration.min_length > configuration.max_length) || (configuration.exponent <= 0.0)) {
+        fprintf(stderr, "%s\n", usage_str);
+        exit(EXIT_FAILURE);
+    }
+
+    /** Only the locked and lock-free modes have a shared table to put the
+     *  combining cache in front of. Rather than refuse '--combine' in the
+     *  others, as the program itself does, the benchmark simply runs them
+     *  without it, so that 'make bench-table' can pass it to every mode, and
+     *  the combine column says which runs actually used it.
+     * 
+     */
+    if ((settings_get_table_mode() != TABLE_LOCKED) && (settings_get_table_mode() != TABLE_LOCKFREE)) {
+        settings_set_combine(FALSE);
+    }
+
+    /** The table is set up just as it is for a join of two inputs, which is
+     *  what allows it to be probed once it has been sealed.
+     *
+     */
+    settings_set_threads(configuration.threads);
+    settings_set_number_of_inputs(2);
+    settings_set_join(TRUE);
+
+    generate_keys(&configuration);
+
+    double* distribution = (configuration.skew == SKEW_ZIPF) ? create_distribution(keys.count, configuration.exponent) : NULL;
+
+    struct worker_t* workers = calloc((size_t) configuration.threads, sizeof (struct worker_t));
+
+    if (workers == NULL) {
+        fatal_error("Memory allocation failure in main()");
+    }
+
+    const size_t operations_per_thread = configuration.operations / (size_t) configuration.threads;
+
+    for (int i = 0; i < configuration.threads; ++i) {
+        struct worker_t* worker = &workers[i];
+
+        worker->operations        = operations_per_thread;
+        worker->number_of_samples = (operations_per_thread + LATENCY_SAMPLE_INTERVAL - 1) / LATENCY_SAMPLE_INTERVAL;
+        worker->insert_keys       = malloc(operations_per_thread * sizeof (uint32_t));
+        worker->lookup_keys       = malloc(operations_per_thread * sizeof (uint32_t));
+        worker->insert_latencies  = malloc(worker->number_of_samples * sizeof (uint64_t));
+        worker->lookup_latencies  = malloc(worker->number_of_samples * sizeof (uint64_t));
+
+        if (!worker->insert_keys || !worker->lookup_keys || !worker->insert_latencies || !worker->lookup_latencies) {
+            fatal_error("Memory allocation failure in main()");
+        }
+
+        uint64_t state = configuration.seed ^ (0xD1B54A32D192ED03ULL * (uint64_t) (i + 1));
+
+        draw_keys(&configuration, distribution, worker->insert_keys, &state, operations_per_thread);
+        draw_keys(&configuration, distribution, worker->lookup_keys, &state, operations_per_thread);
+    }
+
+    initialize_table_resources();
+
+    if (pthread_barrier_init(&phase_barrier, NULL, (unsigned int) configuration.threads + 1)) {
+        fatal_error("Failed to initialize phase barrier");
+    }
+
+    for (int i = 0; i < configuration.threads; ++i) {
+        if (pthread_create(&workers[i].thread, NULL, table_benchmark_thread, &workers[i])) {
+            fatal_error("Could not create benchmark thread");
+        }
+    }
+
+    pthread_barrier_wait(&phase_barrier);
+    pthread_barrier_wait(&phase_barrier);
+
+    seal_table();
+
+    pthread_barrier_wait(&phase_barrier);
+
+    for (int i = 0; i < configuration.threads; ++i) {
+        if (pthread_join(workers[i].thread, NULL)) {
+            fatal_error("Could not rejoin benchmark thread");
+        }
+    }
+
+    const size_t total_operations = operations_per_thread * (size_t) configuration.threads;
+
+    const double inserts_per_second = (double) total_operations / phase_seconds(workers, configuration.threads, FALSE);
+    const double lookups_per_second = (double) total_operations / phase_seconds(workers, configuration.threads, TRUE);
+
+    const uint64_t insert_p99 = latency_percentile(workers, configuration.threads, FALSE);
+    const uint64_t lookup_p99 = latency_percentile(workers, configuration.threads, TRUE);
+
+    if (configuration.header) {
+        printf("table\tcombine\thash\tthreads\tskew\tkeys\tmin_length\tmax_length\toperations\tinserts_per_second\tlookups_per_second\tinsert_p99_ns\tlookup_p99_ns\n");
+    }
+
+    printf("%s\t%d\t%s\t%d\t%s\t%zu\t%zu\t%zu\t%zu\t%.0f\t%.0f\t%" PRIu64 "\t%" PRIu64 "\n",
+           table_mode_names[settings_get_table_mode()], settings_get_combine(), hash_algorithm_names[settings_get_hash_algorithm()],
+           configuration.threads, skew_names[configuration.skew], keys.count,
+           configuration.min_length, configuration.max_length, total_operations,
+           inserts_per_second, lookups_per_second, insert_p99, lookup_p99);
+
+    finalize_table_resources();
+    release_table_resources();
+
+    pthread_barrier_destroy(&phase_barrier);
+
+    for (int i = 0; i < configuration.threads; ++i) {
+        FREE(workers[i].insert_keys);
+        FREE(workers[i].lookup_keys);
+        FREE(workers[i].insert_latencies);
+        FREE(workers[i].lookup_latencies);
+    }
+
+    FREE(workers);
+    FREE(distribution);
+    FREE(keys.buffer);
+    FREE(keys.offsets);
+    FREE(keys.lengths);
+
+    return EXIT_SUCCESS;
+}
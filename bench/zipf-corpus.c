@@ -0,0 +1,268 @@
+
+#include "common.h"
+
+/** This is the corpus generator behind 'make bench'. It writes any number of
+ *  files of words drawn from a Zipf distribution, the way words are
+ *  distributed in natural language, so the benchmarks see a few very common
+ *  words and a long tail of rare ones, just like real input would have. The
+ *  files are completely determined by the options and the seed, so every run
+ *  of the benchmark sees exactly the same input.
+ * 
+ *  Each file has a vocabulary of its own, ranked from its most common word
+ *  down. Only a fraction of every vocabulary, given by the overlap, is shared
+ *  by every file, and the rest of it is unique to the file, so the overlap
+ *  controls how many of the words in the table are ever shared at all. Every
+ *  file shuffles its vocabulary with a seed of its own before ranking it, so
+ *  the most common words in one file are not the most common in the others.
+ * 
+ */
+struct corpus_t {
+    size_t size;
+    size_t vocabulary;
+    double exponent;
+    double overlap;
+    uint64_t seed;
+};
+
+/** This is the splitmix64 generator, which is tiny, fast, and passes every
+ *  statistical test that matters here, and more importantly, gives the same
+ *  sequence everywhere for a given seed.
+ * 
+ */
+__attribute__((nonnull(1)))
+static inline uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/** This function returns a uniformly distributed number in [0, 1).
+ * 
+ */
+__attribute__((nonnull(1)))
+static inline double next_uniform(uint64_t* state) {
+    return (double) (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/** This function builds the cumulative distribution of the word ranks, in
+ *  which the word of rank r is drawn with a probability proportional to
+ *  1 / (r + 1)^s, for an exponent s.
+ * 
+ */
+__attribute__((malloc, returns_nonnull))
+static double* create_distribution(size_t vocabulary, double exponent) {
+    double* distribution = malloc(vocabulary * sizeof (double));
+
+    if (distribution == NULL) {
+        fatal_error("Memory allocation failure in create_distribution()");
+    }
+
+    double total = 0.0;
+
+    for (size_t rank = 0; rank < vocabulary; ++rank) {
+        total += 1.0 / pow((double) (rank + 1), exponent);
+        distribution[rank] = total;
+    }
+
+    for (size_t rank = 0; rank < vocabulary; ++rank) {
+        distribution[rank] /= total;
+    }
+
+    return distribution;
+}
+
+/** This function draws a rank from the distribution, by finding the first rank
+ *  whose cumulative probability is at least a uniformly distributed number.
+ * 
+ */
+__attribute__((nonnull(1,3)))
+static size_t draw_rank(const double* distribution, size_t vocabulary, uint64_t* state) {
+    const double u = next_uniform(state);
+
+    size_t low = 0;
+    size_t high = vocabulary - 1;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (distribution[middle] < u) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/** This function builds the vocabulary of the given file, as word numbers
+ *  indexed by rank. The shared words are numbered the same in every file, and
+ *  the rest are numbered past the words of every file before it.
+ * 
+ */
+__attribute__((nonnull(1), malloc, returns_nonnull))
+static size_t* create_vocabulary(const struct corpus_t* corpus, size_t file) {
+    size_t* words = malloc(corpus->vocabulary * sizeof (size_t));
+
+    if (words == NULL) {
+        fatal_error("Memory allocation failure in create_vocabulary()");
+    }
+
+    const size_t shared = (size_t) (corpus->overlap * (double) corpus->vocabulary);
+
+    for (size_t i = 0; i < corpus->vocabulary; ++i) {
+        words[i] = (i < shared) ? i : i + file * (corpus->vocabulary - shared);
+    }
+
+    uint64_t state = corpus->seed ^ (0xD1B54A32D192ED03ULL * (file + 1));
+
+    for (size_t i = corpus->vocabulary - 1; i > 0; --i) {
+        size_t j = (size_t) (next_random(&state) % (i + 1));
+
+        size_t word = words[i];
+        words[i] = words[j];
+        words[j] = word;
+    }
+
+    return words;
+}
+
+/** Every word number is spelled out in base 26, with the letters a through z
+ *  as its digits, which gives every number a word of its own, and the lower
+ *  the number, the shorter the word.
+ * 
+ */
+__attribute__((nonnull(2)))
+static size_t spell_word(size_t number, char* word) {
+    size_t length = 0;
+
+    do {
+        word[length++] = (char) ('a' + (number % 26));
+        number /= 26;
+    } while (number);
+
+    return length;
+}
+
+/** This function writes a single file of the corpus, a word at a time, with a
+ *  line break after every sixteenth word, until it reaches the corpus size.
+ * 
+ */
+__attribute__((nonnull(1,2,3)))
+static void write_corpus_file(const struct corpus_t* corpus, const double* distribution, const char* filename, size_t file) {
+    size_t* words = create_vocabulary(corpus, file);
+
+    FILE* output = open_file(filename, "w");
+
+    uint64_t state = corpus->seed + file;
+
+    char word[32];
+
+    for (size_t written = 0, count = 1; written < corpus->size; ++count) {
+        size_t length = spell_word(words[draw_rank(distribution, corpus->vocabulary, &state)], word);
+
+        word[length++] = (count % 16) ? ' ' : '\n';
+
+        fwrite(word, 1, length, output);
+
+        written += length;
+    }
+
+    close_file(output);
+
+    FREE(words);
+}
+
+/** The exponent and the overlap are real numbers, and the seed is any unsigned
+ *  64-bit number, so neither goes through 'parse_size'. Both functions reject
+ *  anything that is not entirely a number, rather than taking whatever prefix
+ *  of it happens to be one.
+ * 
+ */
+__attribute__((nonnull(1)))
+static double parse_real(const char* argument) {
+    char* end = NULL;
+
+    errno = 0;
+
+    const double value = strtod(argument, &end);
+
+    if (errno || (end == argument) || (*end != NUL) || !isfinite(value)) {
+        fprintf(stderr, "[Error] %s (%s)\n", "Invalid number", argument);
+        exit(EXIT_FAILURE);
+    }
+
+    return value;
+}
+
+__attribute__((nonnull(1)))
+static uint64_t parse_seed(const char* argument) {
+    char* end = NULL;
+
+    errno = 0;
+
+    const unsigned long long value = strtoull(argument, &end, 10);
+
+    if (errno || (end == argument) || (*end != NUL) || (*argument == '-')) {
+        fprintf(stderr, "[Error] %s (%s)\n", "Invalid seed", argument);
+        exit(EXIT_FAILURE);
+    }
+
+    return (uint64_t) value;
+}
+
+static const char* usage_str = "Usage: zipf-corpus [--size SIZE] [--vocabulary N] [--exponent S] [--overlap F] [--seed N] FILE...";
+
+int main(int argc, char *argv[])
+{
+    struct corpus_t corpus = { 64 * 1024 * 1024, 1000000, 1.0, 0.5, 42 };
+
+    int i = 1;
+
+    /** Every option takes a value, so an option with nothing after it is an
+     *  error, rather than the name of a file to write the corpus to.
+     * 
+     */
+    for (; (i < argc) && (strncmp(argv[i], "--", 2) == 0); i += 2) {
+        if (i + 1 == argc) {
+            fprintf(stderr, "%s\n", usage_str);
+            exit(EXIT_FAILURE);
+        }
+
+        const char* option = argv[i];
+        const char* value  = argv[i + 1];
+
+        if (strings_match(option, "--size")) {
+            corpus.size = parse_size(value);
+        } else if (strings_match(option, "--vocabulary")) {
+            corpus.vocabulary = parse_size(value);
+        } else if (strings_match(option, "--exponent")) {
+            corpus.exponent = parse_real(value);
+        } else if (strings_match(option, "--overlap")) {
+            corpus.overlap = parse_real(value);
+        } else if (strings_match(option, "--seed")) {
+            corpus.seed = parse_seed(value);
+        } else {
+            fprintf(stderr, "[Error] %s (%s)\n", "Unknown option", option);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if ((i == argc) || (corpus.exponent <= 0.0) || (corpus.overlap < 0.0) || (corpus.overlap > 1.0)) {
+        fprintf(stderr, "%s\n", usage_str);
+        exit(EXIT_FAILURE);
+    }
+
+    double* distribution = create_distribution(corpus.vocabulary, corpus.exponent);
+
+    for (size_t file = 0; i < argc; ++i, ++file) {
+        write_corpus_file(&corpus, distribution, argv[i], file);
+    }
+
+    FREE(distribution);
+
+    return EXIT_SUCCESS;
+}
@@ -18,46 +18,58 @@
 #include <limits.h>
 #include <inttypes.h>
 
+#include <sys/auxv.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/param.h>
 #include <sys/resource.h>
 #include <sys/shm.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
 
 #include <fcntl.h>
 #include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
 #include <signal.h>
 #include <syslog.h>
 #include <termios.h>
 
 #include <unistd.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif // __x86_64__ || __i386__
+
 #if !defined(FALSE) || !defined(TRUE)
 enum { FALSE = 0, TRUE = !FALSE };
 #endif // FALSE || TRUE
 
-#ifndef BUFFER_SIZE
-/** The initial buffer size of 4096 was chosen because to align with most
- *  modern hard drives, which have sectors exactly that long. That is the most
- *  efficient atomic unit, but profiling showed the sequential reads being
- *  performed here mean a much larger buffer size, 64Kb in this case, is
- *  actually beneficial.
- * 
- */
-#define BUFFER_SIZE (4096)
-#else
-#error "BUFFER_SIZE already defined."
-#endif // BUFFER_SIZE
-
 #include "err.h"
 #include "file.h"
 #include "hash-table.h"
+#include "input.h"
 #include "mem.h"
 #include "opt.h"
+#include "perf.h"
+#include "progress.h"
+#include "schedule.h"
+#include "selection.h"
 #include "settings.h"
+#include "stats.h"
 #include "str.h"
+#include "stream.h"
+#include "table-combine.h"
+#include "table-local.h"
+#include "table-matrix.h"
+#include "table-partition.h"
+#include "table-stats.h"
+#include "tokenize.h"
+#include "trace.h"
+#include "uring.h"
 
 #endif // PROJECT_INCLUDES_COMMON_H
@@ -46,6 +46,16 @@ void close_file(FILE* file);
 __attribute__((nonnull(1)))
 int open_file_descriptor(const char* filename, int flags);
 
+/** This function opens the named file for reading with O_DIRECT, which reads
+ *  straight from the device into the caller's buffers, without going through
+ *  the page cache. Not every file system supports it, so just like mapping a
+ *  file, a failure to open the file this way is not fatal, and the return
+ *  value is -1 in that case.
+ * 
+ */
+__attribute__((nonnull(1)))
+int open_direct_file_descriptor(const char* filename);
+
 /** This function is a wrapper around the 'close' function, implicitly handling
  *  error-checking and return code validation. Just as with the previous
  *  functions, the caller may be assured that execution of any code after this
@@ -55,4 +65,20 @@ int open_file_descriptor(const char* filename, int flags);
 __attribute__((flatten))
 void close_file_descriptor(int file_descriptor);
 
+/** This function maps the first 'length' bytes of an open file into memory
+ *  for reading, optionally prefaulting every page of the mapping up front.
+ *  Unlike the other wrappers in this file, a failure here is not fatal, since
+ *  not every file can be mapped, and the caller is expected to fall back to
+ *  reading the file instead. The return value is NULL in that case.
+ * 
+ */
+void* map_file_descriptor(int file_descriptor, size_t length, int populate);
+
+/** This function is a wrapper around 'munmap', with the usual guarantee that
+ *  execution continues past the call if and only if it succeeds.
+ * 
+ */
+__attribute__((nonnull(1)))
+void unmap_file(const void* address, size_t length);
+
 #endif // PROJECT_INCLUDES_FILE_H
@@ -3,8 +3,8 @@
 #define PROJECT_INCLUDES_HASH_TABLE_H
 
 /** This is the function that our application will query last once everything
- *  has finished to determine whether a common string between the two input
- *  files does exist, and if it does, what it is. The purpose of this function
+ *  has finished to determine whether a string common to every input file does
+ *  exist, and if it does, what it is. The purpose of this function
  *  is to add some modicum of encapsulation and allow the 'most_common_word'
  *  variable to have internal linkage within the hash-table implementation
  *  file.
@@ -12,19 +12,74 @@
  */
 const char volatile* most_common_shared_word(void);
 
+/** This is a single line of the top K output: a shared word, its count in
+ *  each file, and its commonality score. The counts point straight into the
+ *  word's entry, one for every input, so they are only valid until the table
+ *  is released.
+ * 
+ */
+struct shared_word_t {
+    const char* word;
+    const size_t* counts;
+    double score;
+};
+
+/** This function copies out up to 'capacity' of the most common shared words,
+ *  from the most common down, and returns how many it copied. Only as many
+ *  words as the top setting asked for are kept, and none are kept in the live
+ *  winner mode, which never scans the table. Ties are broken in favor of the
+ *  word that sorts first, so the order never depends on the thread count.
+ * 
+ */
+__attribute__((nonnull(1)))
+size_t most_common_shared_words(struct shared_word_t* words, size_t capacity);
+
+typedef unsigned long long int hash_t;
+
+#ifndef INLINE_WORD_SIZE
+/** Words shorter than this are stored inside the entry itself, NUL terminator
+ *  and all, rather than in a separate allocation. Nearly every English word is
+ *  short enough, and sixteen bytes can be compared with two 64-bit loads.
+ * 
+ */
+#define INLINE_WORD_SIZE (16)
+#else
+#error "INLINE_WORD_SIZE already defined."
+#endif // INLINE_WORD_SIZE
+
 /** This is the struct that represents each hash table entry in memory. The
- *  reason for the separate reference counts for files 1 and 2 is because I
+ *  reason for the separate reference counts for every file is because I
  *  defined the "most common shared string" as being the string with the
- *  highest geometric mean based on the two datapoints of its reference count
- *  in file one and its reference count in file two.
+ *  highest mean of its reference counts in each of the files. There used to be
+ *  exactly two of them, 'count1' and 'count2', but any number of files can now
+ *  be compared at once, so the counts are a vector at the end of the entry,
+ *  with one count per input file and nothing more, and the entry is allocated
+ *  with exactly as much room as the vector needs.
+ * 
+ *  The entry keeps the full hash of its word, which lets the table both reject
+ *  most non-matching entries without comparing strings and rebuild itself
+ *  without rehashing every word whenever it grows. The length of the word is
+ *  kept alongside it, so that an entry whose hash happens to match can still
+ *  be rejected without touching the word.
+ * 
+ *  Short words live in 'inline_word', zero-padded, and 'word' simply points
+ *  at it. Comparing a short word is then just a matter of comparing the two
+ *  halves of 'inline_word', which are on the same cache line as the hash, and
+ *  the pointer is never followed. Longer words are stored elsewhere, and the
+ *  inline copy is left zeroed.
+ * 
+ *  The entry used to carry a reader-writer lock as well, which took up nearly
+ *  as much room as everything else put together, and which only the locked
+ *  table mode ever uses. In that mode, the table now places the lock right
+ *  after the counts, and in every other mode, entries have no lock at all.
  * 
  */
 struct table_entry_t {
+    hash_t hash;
+    size_t length;
+    uint64_t inline_word[INLINE_WORD_SIZE / sizeof (uint64_t)];
     char* word;
-    size_t count1;
-    size_t count2;
-    pthread_rwlock_t lock;
-    struct table_entry_t* next;
+    size_t counts[];
 };
 
 /** This is where most of the magic happens. The bulk of the application is
@@ -33,12 +88,236 @@ struct table_entry_t {
  *  care of adding new entries to the hash table as we encounter them, as well
  *  as incrementing reference counts if the given entry already exists in the
  *  hash table. The file integer is what allows for the distinction between
- *  files 1 and 2.
+ *  the files, which are numbered from one.
+ * 
+ *  The word is given by its length rather than by a NUL terminator, so that
+ *  tokens can be added straight out of the input buffer. The return value is
+ *  the word's entry, except in partitioned mode, where the word is counted
+ *  later, by another thread, and the return value is a NULL pointer.
  * 
  */
-__attribute__((hot, nonnull(1), returns_nonnull))
-struct table_entry_t* add_word_to_table(const char* word, int file);
+__attribute__((hot, nonnull(1)))
+struct table_entry_t* add_word_to_table(const char* word, size_t length, int file);
+
+/** This is the probe phase of join mode. Once the table has been built from
+ *  the smaller input and sealed, each word of the larger input is looked up
+ *  without taking any locks, and counted only if it is already in the table.
+ *  The return value is the word's entry, or a NULL pointer if it had none.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+struct table_entry_t* count_word_in_table(const char* word, size_t length, int file);
+
+/** This function prepares the table for use according to the current settings,
+ *  so it must be called after the command-line options have been parsed and
+ *  before any thread starts adding words.
+ * 
+ */
+void initialize_table_resources(void);
+
+/** This function must be called once every thread that adds words to the
+ *  table has been joined, and before asking for the most common shared word,
+ *  since in every mode but the locked one, that word is only determined here.
+ * 
+ */
+void finalize_table_resources(void);
+
+/** In join mode, this function must be called between the two phases, once
+ *  every thread that adds words to the table has been joined, and before any
+ *  thread starts counting words of the larger input.
+ * 
+ */
+void seal_table(void);
+
+/** This function prints the provisional leader and the table statistics to
+ *  standard error while the threads are still counting, without stopping
+ *  them. It may be called from any thread that is not itself counting words.
+ * 
+ */
+void report_table_snapshot(void);
+
+/** Every stretch of calls to 'add_word_to_table' must be bracketed by these two
+ *  functions. In lock-free mode, they are what allows the table to be grown
+ *  safely without any locks being taken for individual words, and a thread
+ *  must not block on anything else in between them. The table can only be
+ *  grown once every thread is outside of such a stretch, so they should cover
+ *  no more than a single buffer of input at a time.
+ * 
+ */
+void begin_table_access(void);
+void end_table_access(void);
 
+/** This function frees the table along with every entry and word in it. The
+ *  entries are allocated in large blocks, so this takes time proportional to
+ *  the number of blocks, not the number of distinct words.
+ * 
+ */
 void release_table_resources(void);
 
+/** Everything from here on is shared between the modules the table is made up
+ *  of: the table itself, in 'hash-table.c', and the selection of the most
+ *  common words, the pair matrix, the combining caches, the local tables, the
+ *  partitions, and the table statistics, each in a file of its own. Nothing
+ *  outside of them has any business using any of it.
+ * 
+ */
+#ifndef TABLE_INITIAL_CAPACITY
+/** The number of slots allocated the first time a word is added to the table.
+ *  This must be a power of two, since the slot index is taken directly from
+ *  the top bits of the hash. The table doubles every time it reaches its
+ *  maximum load factor, so this value only matters for small inputs.
+ * 
+ */
+#define TABLE_INITIAL_CAPACITY (1 << 16)
+#else
+#error "TABLE_INITIAL_CAPACITY already defined."
+#endif // TABLE_INITIAL_CAPACITY
+
+#ifndef GROUP_WIDTH
+/** The control bytes are probed sixteen at a time, which is exactly the width
+ *  of a single SSE2 register. The scalar fallback uses the same group width so
+ *  both versions of the probe visit the slots in the same order.
+ * 
+ */
+#define GROUP_WIDTH (16)
+#else
+#error "GROUP_WIDTH already defined."
+#endif // GROUP_WIDTH
+
+/** Every slot in the table has a matching control byte. A control byte with
+ *  the high bit set marks an empty slot, while a full slot stores the bottom
+ *  seven bits of its entry's hash. Probing compares sixteen control bytes at a
+ *  time against those seven bits, so the vast majority of non-matching slots
+ *  are rejected without ever touching the entries themselves.
+ * 
+ */
+typedef signed char control_t;
+
+enum { CONTROL_EMPTY = -128 };
+
+/** This is the hash table for the strings in the input files. It is an
+ *  open-addressing table in the style of Google's Swiss tables: a flat array
+ *  of control bytes, and a parallel array of pointers to the entries. The
+ *  control array is over-allocated by one group, and the first group is
+ *  mirrored at the end, so a group can be loaded starting at any slot without
+ *  having to worry about wrapping around.
+ * 
+ *  Entries are placed at the first empty slot at or after their home slot,
+ *  which is taken from the top bits of the hash. Because nothing is ever
+ *  removed from the table, a lookup can stop at the first empty slot it sees.
+ *  The entries themselves never move, even when the table grows, which means
+ *  the pointers returned by 'add_word_to_table' remain valid for the lifetime
+ *  of the table.
+ * 
+ *  Every table hashes its words with its own seed, and the hashes stored in
+ *  its entries are always the ones for its current seed. A table that is
+ *  allowed to reseed itself may do so once per capacity, whenever its probe
+ *  lengths show the current seed is a poor fit for the input, and records the
+ *  capacity it last did so at.
+ * 
+ */
+struct hash_table_t {
+    size_t capacity;
+    size_t mask;
+    unsigned int shift;
+    hash_t scale;
+    hash_t seed;
+    int reseedable;
+    size_t reseeded_capacity;
+    size_t size;
+    size_t growth_limit;
+    control_t* control;
+    struct table_entry_t** slots;
+};
+
+/** A key is a word that is looking for its entry in the table, along with
+ *  everything about it an entry is compared against: its hash, its length,
+ *  and, for a short word, a zero-padded copy laid out exactly like the inline
+ *  copy in an entry. The word itself is not NUL-terminated.
+ * 
+ */
+struct table_key_t {
+    const char* word;
+    size_t length;
+    hash_t hash;
+    hash_t seed;
+    uint64_t inline_word[INLINE_WORD_SIZE / sizeof (uint64_t)];
+};
+
+
+/** This function hashes a word with the hash function chosen in the settings
+ *  and the given seed, which must be the seed of the table it is meant for.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+hash_t hash_word(const char* word, size_t length, hash_t seed);
+
+/** These functions give the home slot of a hash in the given table, and the
+ *  control byte of a full slot holding an entry with that hash.
+ * 
+ */
+__attribute__((hot, pure, nonnull(1)))
+size_t home_slot(const struct hash_table_t* table, hash_t hash);
+
+__attribute__((hot, const))
+control_t control_byte(hash_t hash);
+
+/** These functions split the hash space into the given number of ranges,
+ *  which is how the merged tables and the partitions divide up the words.
+ * 
+ */
+__attribute__((hot, const))
+size_t hash_range(hash_t hash, size_t ranges);
+
+__attribute__((const))
+hash_t first_hash_in_range(size_t range, size_t ranges);
+
+/** This function returns a bitmask of the empty slots in the group of sixteen
+ *  control bytes starting at the given one.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+unsigned int match_empty_slots(const control_t* group);
+
+/** These are the basic operations on a single table, none of which take any
+ *  locks. See their definitions for the details.
+ * 
+ */
+__attribute__((nonnull(1)))
+void allocate_table_storage(struct hash_table_t* table, size_t capacity);
+
+__attribute__((nonnull(1)))
+void grow_table(struct hash_table_t* table);
+
+__attribute__((hot, nonnull(1,2,3)))
+size_t probe_table(const struct hash_table_t* table, const struct table_key_t* key, int* found);
+
+__attribute__((nonnull(1)))
+void set_control_byte(struct hash_table_t* table, size_t slot, control_t value);
+
+__attribute__((hot, nonnull(1,2), returns_nonnull))
+struct table_entry_t* find_or_insert_local_word(struct hash_table_t* table, struct table_key_t* key);
+
+/** These functions find or insert a word in the shared table, and add a count
+ *  to its entry, in whichever way the locked or the lock-free mode calls for.
+ * 
+ */
+__attribute__((hot, nonnull(1), returns_nonnull))
+struct table_entry_t* find_or_insert_shared_word(struct table_key_t* key);
+
+__attribute__((hot, nonnull(1)))
+void add_reference_counts(struct table_entry_t* entry, int file, size_t count);
+
+/** This function turns a file number, which starts at one, into the index of
+ *  the file's count in an entry's count vector.
+ * 
+ */
+__attribute__((hot))
+size_t count_index(int file);
+
+/** This function returns the number of times any table has been reseeded.
+ * 
+ */
+size_t table_reseeds(void);
+
 #endif // PROJECT_INCLUDES_HASH_TABLE_H
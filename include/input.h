@@ -0,0 +1,109 @@
+
+#ifndef PROJECT_INCLUDES_INPUT_H
+#define PROJECT_INCLUDES_INPUT_H
+
+/** An input is one of the files named on the command line, opened once and
+ *  shared by every thread processing it. Threads claim chunks of the input by
+ *  advancing its offset under its lock; this is what used to be the f1_offset
+ *  and f2_offset variables in main.c, along with their mutexes.
+ * 
+ *  Whenever possible, the whole file is mapped into memory when it is opened,
+ *  and threads tokenize their chunks directly out of the mapping. Otherwise,
+ *  'data' is NULL, and each chunk has to be read into a buffer with 'pread'.
+ *  The size is -1 if the file is not a regular file, in which case it cannot
+ *  be read at an offset at all, and is read as a stream instead, by a thread
+ *  of its own.
+ * 
+ */
+struct input_t {
+    const char* filename;
+    int file;
+    int file_descriptor;
+    off_t size;
+    const char* data;
+    struct stream_t* stream;
+    off_t offset;
+    pthread_mutex_t lock;
+};
+
+/** A chunk is simply a range of bytes in an input that a single thread has
+ *  claimed for itself. Chunks always begin and end on a word boundary, so
+ *  every word in the input lies entirely within exactly one chunk.
+ * 
+ */
+struct chunk_t {
+    off_t start;
+    size_t length;
+};
+
+/** This is the buffer a thread reads its chunks into when the input is not
+ *  mapped into memory. Chunks are only roughly the chunk size, since they are
+ *  extended to the end of the word they would otherwise cut in half, so the
+ *  buffer grows whenever a chunk does not fit. It starts out empty, and must
+ *  be released by the thread that owns it once it is done.
+ * 
+ */
+struct input_buffer_t {
+    char* data;
+    size_t capacity;
+};
+
+/** This function works out the default chunk size, which is half the size of
+ *  the processor's L2 cache, so that a chunk read into a buffer is still in
+ *  the cache by the time the tokenizer and the hash table get to it, with room
+ *  to spare for the table itself. If the size of the cache cannot be found,
+ *  the default is 256 KB, half of a common L2 size.
+ * 
+ */
+size_t default_chunk_size(void);
+
+/** This function opens the named file as input number 'file', mapping it into
+ *  memory if the input mode allows it and the file can be mapped. Mapped files
+ *  are advised for sequential access and asked to be read ahead. The name '-'
+ *  stands for standard input.
+ * 
+ */
+__attribute__((nonnull(1), returns_nonnull))
+struct input_t* open_input(const char* filename, int file);
+
+/** This function claims the next chunk of the input, returning FALSE once
+ *  there is nothing left to claim. The chunk is the chunk size long, plus
+ *  however many bytes it takes to reach the end of the word the chunk would
+ *  otherwise end in the middle of. Claiming a chunk of a stream waits for the
+ *  stream's reader to get to it.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+int claim_input_chunk(struct input_t* input, struct chunk_t* chunk);
+
+/** This function returns a pointer to the contents of a claimed chunk. For a
+ *  mapped input, that is simply a pointer into the mapping, and the buffer is
+ *  untouched. Otherwise, the chunk is read into the buffer, which is grown
+ *  first if it is too small to hold it, and the chunk's length is updated to
+ *  the number of bytes actually read, which is zero at the end of the file.
+ * 
+ */
+__attribute__((nonnull(1,2,3)))
+const char* read_input_chunk(struct input_t* input, struct chunk_t* chunk, struct input_buffer_t* buffer);
+
+/** This function is called once a claimed chunk has been processed. Only a
+ *  stream's chunks need to be handed back, so that their buffers can be filled
+ *  again, but every chunk should be released all the same.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+void release_input_chunk(struct input_t* input, const struct chunk_t* chunk);
+
+/** This function frees the memory held by an input buffer.
+ * 
+ */
+__attribute__((nonnull(1)))
+void release_input_buffer(struct input_buffer_t* buffer);
+
+/** This function unmaps and closes the input, and frees the object itself.
+ * 
+ */
+__attribute__((nonnull(1)))
+void close_input(struct input_t* input);
+
+#endif // PROJECT_INCLUDES_INPUT_H
@@ -23,4 +23,49 @@ void safe_free(void** ptr);
 #define FREE(ptr) safe_free((void **) &ptr)
 #endif
 
+/** An arena is a bump allocator for objects that all live until the arena
+ *  itself is released. Memory is handed out of large blocks, one after the
+ *  other, with no header of any kind in front of each object, so consecutive
+ *  allocations are contiguous in memory, and releasing the arena frees its
+ *  blocks without ever visiting the objects in them.
+ * 
+ *  An arena is not synchronized in any way. It is meant to be owned by a
+ *  single thread, which is the only thread that may allocate from it, though
+ *  the memory it hands out may be shared freely.
+ * 
+ */
+struct arena_block_t;
+
+struct arena_t {
+    struct arena_block_t* blocks;
+    unsigned char* next;
+    unsigned char* end;
+    size_t block_size;
+};
+
+/** This function prepares an empty arena that will allocate its memory in
+ *  blocks of 'block_size' bytes. No memory is allocated until the first call
+ *  to 'arena_allocate'.
+ * 
+ */
+__attribute__((nonnull(1)))
+void initialize_arena(struct arena_t* arena, size_t block_size);
+
+/** This function returns 'size' bytes out of the arena, aligned to the given
+ *  alignment, which must be a power of two. Allocations larger than the block
+ *  size get a block of their own, without disturbing the current block.
+ * 
+ */
+__attribute__((hot, malloc, nonnull(1), returns_nonnull))
+void* arena_allocate(struct arena_t* arena, size_t size, size_t alignment);
+
+/** This function frees every block in the arena, which invalidates everything
+ *  ever allocated from it, and leaves the arena empty but ready for reuse. It
+ *  takes time proportional to the number of blocks, not the number of
+ *  allocations.
+ * 
+ */
+__attribute__((nonnull(1)))
+void release_arena(struct arena_t* arena);
+
 #endif // PROJECT_INCLUDES_MEM_H
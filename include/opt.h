@@ -7,7 +7,23 @@ typedef enum {
     OPTION_HELP,
     OPTION_VERSION,
     OPTION_VERBOSE,
-    OPTION_THREADS
+    OPTION_THREADS,
+    OPTION_TABLE,
+    OPTION_IO,
+    OPTION_POPULATE,
+    OPTION_CHUNK_SIZE,
+    OPTION_WINNER,
+    OPTION_HASH,
+    OPTION_JOIN,
+    OPTION_TOP,
+    OPTION_METRIC,
+    OPTION_MATRIX,
+    OPTION_QUEUE_DEPTH,
+    OPTION_STATS,
+    OPTION_PERF_COUNTERS,
+    OPTION_TRACE,
+    OPTION_PROGRESS,
+    OPTION_COMBINE
 } option_id_t;
 
 struct option_t {
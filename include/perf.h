@@ -0,0 +1,92 @@
+
+#ifndef PROJECT_INCLUDES_PERF_H
+#define PROJECT_INCLUDES_PERF_H
+
+/** These are the hardware events counted with '--perf-counters'. Cycles and
+ *  instructions give the IPC, and the three kinds of misses are what tell a
+ *  phase that is waiting on memory from one that is simply doing a lot of
+ *  work. Not every processor can count every one of them, and any event that
+ *  cannot be counted is simply left out of the report.
+ * 
+ */
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_DTLB_MISSES,
+    NUMBER_OF_PERF_EVENTS
+} perf_event_t;
+
+/** These are the phases the events are attributed to. Reading is whatever it
+ *  takes to get a chunk into memory, tokenizing is splitting it into words,
+ *  inserting is adding the words to the table, or probing it in join mode,
+ *  and scanning is everything it takes to get the table into its final state
+ *  once every thread has been joined, including any merging. Anything else a
+ *  thread does, such as claiming its next chunk, belongs to no phase at all.
+ * 
+ */
+typedef enum {
+    PERF_PHASE_NONE,
+    PERF_PHASE_READ,
+    PERF_PHASE_TOKENIZE,
+    PERF_PHASE_INSERT,
+    PERF_PHASE_SCAN,
+    NUMBER_OF_PERF_PHASES
+} perf_phase_t;
+
+/** These are one thread's event counts in every phase, along with the number
+ *  of tokens it processed, which is what the misses are reported per. Every
+ *  thread has its own, on cache lines of their own, like the other counters.
+ * 
+ */
+struct perf_counts_t {
+    uint64_t counts[NUMBER_OF_PERF_PHASES][NUMBER_OF_PERF_EVENTS];
+    size_t tokens;
+} __attribute__((aligned(64)));
+
+/** This function checks which of the events can be counted at all, and if any
+ *  can, allocates the counts for the given number of threads. It returns FALSE
+ *  if none of them can, in which case every function below does nothing.
+ * 
+ */
+int initialize_perf_counters(size_t number_of_threads);
+
+/** Every thread processing the inputs opens its own group of counters with
+ *  this function once it starts, with its worker number, and closes it again
+ *  before it exits. The events are only counted for the thread itself.
+ * 
+ */
+void open_thread_perf_counters(size_t worker);
+void close_thread_perf_counters(void);
+
+/** This function ends whatever phase the calling thread was in, attributing
+ *  the events since it began to it, and begins the given one.
+ * 
+ */
+void switch_perf_phase(perf_phase_t phase);
+
+/** This function counts the tokens the calling thread processed.
+ * 
+ */
+void count_perf_tokens(size_t tokens);
+
+/** These two functions bracket the scan phase, which the main thread counts
+ *  along with every thread it starts in the meantime.
+ * 
+ */
+void begin_perf_scan(void);
+void end_perf_scan(void);
+
+/** This function prints the counts for every phase, and the IPC and the misses
+ *  per token that come out of them, to standard error.
+ * 
+ */
+void report_perf_counters(void);
+
+/** This function frees the counts.
+ * 
+ */
+void release_perf_counters(void);
+
+#endif // PROJECT_INCLUDES_PERF_H
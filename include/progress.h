@@ -0,0 +1,63 @@
+
+#ifndef PROJECT_INCLUDES_PROGRESS_H
+#define PROJECT_INCLUDES_PROGRESS_H
+
+/** This is how often the progress line is redrawn with '--progress'.
+ * 
+ */
+#ifndef PROGRESS_INTERVAL_MILLISECONDS
+#define PROGRESS_INTERVAL_MILLISECONDS (1000)
+#else
+#error "PROGRESS_INTERVAL_MILLISECONDS already defined."
+#endif // PROGRESS_INTERVAL_MILLISECONDS
+
+/** This is the number of bytes one thread has processed so far. Only the
+ *  thread itself ever writes to it, and the monitor only ever reads it, both
+ *  with relaxed atomics, so counting a chunk costs no more than an ordinary
+ *  add. Every thread's counter sits on a cache line of its own, so the
+ *  threads never write to a line another thread is writing to.
+ * 
+ */
+struct progress_counter_t {
+    size_t bytes;
+} __attribute__((aligned(64)));
+
+/** This function starts the monitor thread, which prints a progress line at
+ *  every interval if the progress setting asked for one, and a snapshot of the
+ *  table whenever the process receives SIGUSR1. It must be called before any
+ *  other thread is started, including the readers of any streams, since it
+ *  blocks SIGUSR1 in the calling thread, so that every thread started
+ *  afterwards has it blocked as well and the monitor is the only one that ever
+ *  receives it.
+ * 
+ */
+void start_monitor(size_t number_of_threads);
+
+/** This function sets the total every progress line is measured against,
+ *  which is the number of bytes in every input once they have been opened, or
+ *  zero if any of them is a stream, whose size is never known ahead of time,
+ *  in which case there is no ETA.
+ * 
+ */
+void set_progress_total(size_t total_bytes);
+
+/** Every thread processing the inputs calls this function once it starts,
+ *  with its worker number, to claim its counter.
+ * 
+ */
+void register_progress_thread(size_t worker);
+
+/** This function counts a chunk's worth of bytes processed by the calling
+ *  thread.
+ * 
+ */
+void count_progress(size_t bytes);
+
+/** This function stops the monitor thread, which prints its last progress
+ *  line on the way out, and frees the counters. Any SIGUSR1 received after it
+ *  has returned stays blocked, and is simply ignored.
+ * 
+ */
+void stop_monitor(void);
+
+#endif // PROJECT_INCLUDES_PROGRESS_H
@@ -0,0 +1,85 @@
+
+#ifndef PROJECT_INCLUDES_SCHEDULE_H
+#define PROJECT_INCLUDES_SCHEDULE_H
+
+#ifndef TASK_DEQUE_CAPACITY
+/** This is the most chunks a worker can have queued up at once, which also
+ *  bounds how many it claims from an input at a time. A handful is enough to
+ *  take the pressure off the inputs' locks while still leaving something for
+ *  idle workers to steal.
+ * 
+ */
+#define TASK_DEQUE_CAPACITY (8)
+#else
+#error "TASK_DEQUE_CAPACITY already defined."
+#endif // TASK_DEQUE_CAPACITY
+
+/** A task is a chunk of one of the inputs, claimed but not yet processed.
+ * 
+ */
+struct task_t {
+    struct input_t* input;
+    struct chunk_t chunk;
+};
+
+/** Every worker owns a deque of tasks. The owner pushes and pops tasks at the
+ *  bottom, while other workers steal them from the top. Tasks are pushed in
+ *  reverse, so the owner still works through its chunks in file order, and
+ *  thieves take the chunks furthest from where the owner is working. Each
+ *  deque has its own lock, which the owner only ever contends for with a
+ *  thief, and sits on its own cache line.
+ * 
+ */
+struct task_deque_t {
+    pthread_mutex_t lock;
+    size_t top;
+    size_t bottom;
+    struct task_t tasks[TASK_DEQUE_CAPACITY];
+} __attribute__((aligned(64)));
+
+/** The scheduler hands out chunks from any number of inputs to a fixed number
+ *  of workers, numbered from zero. A worker with nothing left to do refills its
+ *  deque from its own input first, then from any other input with something
+ *  left in it, and only once every input has been claimed in full does it
+ *  steal from the other workers. No worker is ever tied to a single input, so
+ *  no worker sits idle while there is still work to be done anywhere.
+ * 
+ */
+struct scheduler_t {
+    struct input_t** inputs;
+    size_t number_of_inputs;
+    struct task_deque_t* deques;
+    size_t number_of_workers;
+};
+
+/** This function returns the number of processors the process is allowed to
+ *  run on, according to its CPU affinity mask, which is what '-j auto' uses
+ *  as its thread count. If the mask cannot be read, it falls back on the
+ *  number of processors online.
+ * 
+ */
+int available_processors(void);
+
+/** This function creates a scheduler over the given inputs for the given
+ *  number of workers. The inputs must stay open until the scheduler has been
+ *  freed, but the array itself is copied.
+ * 
+ */
+__attribute__((nonnull(1), returns_nonnull))
+struct scheduler_t* create_scheduler(struct input_t** inputs, size_t number_of_inputs, size_t number_of_workers);
+
+/** This function gives the calling worker its next task, returning FALSE once
+ *  there is nothing left to do anywhere. Once it has returned FALSE, it will
+ *  keep doing so for every worker.
+ * 
+ */
+__attribute__((hot, nonnull(1,3)))
+int next_task(struct scheduler_t* scheduler, size_t worker, struct task_t* task);
+
+/** This function frees the scheduler, but leaves its inputs open.
+ * 
+ */
+__attribute__((nonnull(1)))
+void free_scheduler(struct scheduler_t* scheduler);
+
+#endif // PROJECT_INCLUDES_SCHEDULE_H
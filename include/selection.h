@@ -0,0 +1,79 @@
+
+#ifndef PROJECT_INCLUDES_SELECTION_H
+#define PROJECT_INCLUDES_SELECTION_H
+
+/** Whenever the most common word is found by scanning the table, the scan
+ *  keeps the best K entries it sees rather than just the one, where K is the
+ *  number of words the user asked for, or one if they didn't ask. These are
+ *  the entries along with their scores, which are computed in bulk while
+ *  scanning, and kept so they never have to be computed again.
+ * 
+ */
+struct scored_entry_t {
+    struct table_entry_t* entry;
+    double score;
+};
+
+struct selection_t {
+    struct scored_entry_t* entries;
+    size_t size;
+    size_t capacity;
+};
+
+
+/** This function copies the metric and the number of inputs out of the
+ *  settings, and must be called before any entry is scored.
+ * 
+ */
+void initialize_metric(void);
+
+/** These functions score an entry, or a count vector of any length, with
+ *  whichever metric '--metric' chose. A word missing from any of the files
+ *  always scores zero.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+double commonality(const struct table_entry_t* entry);
+
+__attribute__((hot, nonnull(1)))
+double score_counts(const size_t* counts, size_t n);
+
+/** This function decides whether one scored entry ranks above another, with
+ *  ties broken in favor of the word that sorts first.
+ * 
+ */
+__attribute__((nonnull(1,2), pure))
+int ranks_higher(const struct scored_entry_t* a, const struct scored_entry_t* b);
+
+/** A selection keeps the best 'capacity' entries it has been offered. Offering
+ *  it an entry costs O(log K) at most, and merging one selection into another
+ *  is just offering it every entry of the other.
+ * 
+ */
+__attribute__((nonnull(1)))
+void initialize_selection(struct selection_t* selection, size_t capacity);
+
+__attribute__((nonnull(1)))
+void release_selection(struct selection_t* selection);
+
+__attribute__((nonnull(1,2)))
+void select_entry(struct selection_t* selection, struct table_entry_t* entry, double score);
+
+__attribute__((nonnull(1,2)))
+void merge_selection(struct selection_t* selection, const struct selection_t* other);
+
+/** This function sorts the entries of a selection from the highest rank down,
+ *  after which nothing more may be selected into it.
+ * 
+ */
+__attribute__((nonnull(1)))
+void sort_selection(struct selection_t* selection);
+
+/** This function offers every entry in the given range of slots of a table to
+ *  the selection. Both ends of the range must be multiples of the group width.
+ * 
+ */
+__attribute__((hot, nonnull(1,4)))
+void find_best_entries(const struct hash_table_t* table, size_t first_slot, size_t last_slot, struct selection_t* selection);
+
+#endif // PROJECT_INCLUDES_SELECTION_H
@@ -2,24 +2,172 @@
 #ifndef PROJECT_INCLUDES_SETTINGS_H
 #define PROJECT_INCLUDES_SETTINGS_H
 
-/** There are two command-line options at the moment that affect the operation
- *  of the application. The first controls the verbosity of the output during
- *  program execution. It has been implemented in a limited capacity so far,
- *  but the option itself is fully operational. The threads setting controls
- *  how many threads the program creates to operate on the input files. At the
- *  moment, the number of threads is expected to be even to be cleanly divided
- *  up into the two input files, and if it isn't, it is incremented by one.
+/** The table mode determines how threads synchronize their access to the
+ *  shared hash table. The locked mode is the original design, with a global
+ *  reader-writer lock around the table, a reader-writer lock per entry, and a
+ *  mutex around the running maximum. The lock-free mode publishes new entries
+ *  with a compare-and-swap, increments the counts atomically, and leaves
+ *  finding the most common word until every thread has finished. The local
+ *  mode gives every thread a private table, and merges them all at the end.
+ *  The partitioned mode splits the hash space into partitions, each of which
+ *  belongs to a single thread, and has every thread hand the words it reads
+ *  over to the owners of their partitions in blocks, so no table is ever
+ *  shared at all.
+ * 
+ */
+typedef enum {
+    TABLE_LOCKED,
+    TABLE_LOCKFREE,
+    TABLE_LOCAL,
+    TABLE_PARTITIONED
+} table_mode_t;
+
+/** The input mode determines how the input files are read. By default, each
+ *  file is mapped into memory and tokenized in place, but the original method
+ *  of reading each chunk into a buffer with 'pread' remains available, and is
+ *  what any file that cannot be mapped falls back to regardless. The uring
+ *  mode reads chunks into buffers too, but asynchronously, through io_uring,
+ *  so that a thread can tokenize one chunk while the next ones are still being
+ *  read. The direct mode leaves the reading to a thread per file, which reads
+ *  it with O_DIRECT into a pool of buffers for the other threads to tokenize.
+ * 
+ */
+typedef enum {
+    IO_MMAP,
+    IO_PREAD,
+    IO_URING,
+    IO_DIRECT
+} io_mode_t;
+
+/** The winner mode determines when the most common word is found. In the
+ *  default scan mode, counting words never touches the running maximum at all,
+ *  and the most common word is found by a parallel scan over the table once
+ *  every thread has finished. The live mode is the original design, where
+ *  every single word updates the running maximum under a global mutex, which
+ *  is only possible in the locked table mode.
+ * 
+ */
+typedef enum {
+    WINNER_SCAN,
+    WINNER_LIVE
+} winner_mode_t;
+
+/** The hash algorithm selects the family of hash functions the table uses.
+ *  Every one of them is seeded, so the table can switch to a different member
+ *  of the family whenever its probe lengths degrade. The first two consume the
+ *  word eight bytes at a time, while the other three are the original byte at
+ *  a time hash functions, kept around for comparison.
+ * 
+ */
+typedef enum {
+    HASH_WYHASH,
+    HASH_MURMUR,
+    HASH_WEINBERGER,
+    HASH_SEDGEWICK,
+    HASH_TRIVIAL
+} hash_algorithm_t;
+
+/** The metric is how a word's counts in each of the files are combined into
+ *  its commonality score. Every metric scores a word missing from any of the
+ *  files as zero. The harmonic mean favors words that are about as common in
+ *  every file, the geometric mean is a little more forgiving of imbalance, and
+ *  the minimum simply scores a word by the file it is least common in.
+ * 
+ */
+typedef enum {
+    METRIC_HARMONIC,
+    METRIC_GEOMETRIC,
+    METRIC_MINIMUM
+} metric_t;
+
+/** These are the command-line options that affect the operation of the
+ *  application. The first controls the verbosity of the output during program
+ *  execution. It has been implemented in a limited capacity so far, but the
+ *  option itself is fully operational. The threads setting controls how many
+ *  threads the program creates to operate on the input files. Every thread
+ *  takes its chunks from any of the files, so any number of threads will do.
+ *  The table mode selects how those threads share the hash table, and the
+ *  input mode how they read the files, with 'populate' asking for mapped files
+ *  to be prefaulted in their entirety when they are mapped. The chunk size is
+ *  the number of bytes a thread claims from an input at a time, which used to
+ *  be the compile-time BUFFER_SIZE. The winner mode selects when the most
+ *  common word is determined, and the hash algorithm which hash functions the
+ *  table uses. The 'join' setting asks for the table to be built from the
+ *  smallest input alone, with the rest of the inputs only ever probing it, and
+ *  'top' is the number of shared words to list, or zero to print just the most
+ *  common one. The number of inputs is however many files were named on the
+ *  command line, the metric is how their counts are scored, and 'matrix' asks
+ *  for the most common word shared by every pair of files. The queue depth is
+ *  how many reads each thread keeps in flight in the uring input mode. Then
+ *  there are the settings that report on the run itself: 'stats' asks for
+ *  every thread's counters, the lock waits, and the table statistics, the perf
+ *  counters setting for the hardware events of every phase, the trace for the
+ *  name of the file to write a timeline of every thread's work to, or NULL for
+ *  no trace at all, and 'progress' for the throughput and the time left as the
+ *  run goes on. Finally, 'combine' asks for every thread to combine the counts
+ *  of the words it sees most often before adding them to the shared table.
  * 
  */
 struct settings_t {
     int verbose;
     int threads;
+    table_mode_t table_mode;
+    io_mode_t io_mode;
+    int populate;
+    size_t chunk_size;
+    winner_mode_t winner_mode;
+    hash_algorithm_t hash_algorithm;
+    int join;
+    size_t top;
+    size_t number_of_inputs;
+    metric_t metric;
+    int matrix;
+    unsigned int queue_depth;
+    int stats;
+    int perf_counters;
+    const char* trace;
+    int progress;
+    int combine;
 };
 
 void settings_set_verbose(int setting);
 void settings_set_threads(int setting);
+void settings_set_table_mode(table_mode_t setting);
+void settings_set_io_mode(io_mode_t setting);
+void settings_set_populate(int setting);
+void settings_set_chunk_size(size_t setting);
+void settings_set_winner_mode(winner_mode_t setting);
+void settings_set_hash_algorithm(hash_algorithm_t setting);
+void settings_set_join(int setting);
+void settings_set_top(size_t setting);
+void settings_set_number_of_inputs(size_t setting);
+void settings_set_metric(metric_t setting);
+void settings_set_matrix(int setting);
+void settings_set_queue_depth(unsigned int setting);
+void settings_set_stats(int setting);
+void settings_set_perf_counters(int setting);
+void settings_set_trace(const char* setting);
+void settings_set_progress(int setting);
+void settings_set_combine(int setting);
 
 int settings_get_verbose(void);
 int settings_get_threads(void);
+table_mode_t settings_get_table_mode(void);
+io_mode_t settings_get_io_mode(void);
+int settings_get_populate(void);
+size_t settings_get_chunk_size(void);
+winner_mode_t settings_get_winner_mode(void);
+hash_algorithm_t settings_get_hash_algorithm(void);
+int settings_get_join(void);
+size_t settings_get_top(void);
+size_t settings_get_number_of_inputs(void);
+metric_t settings_get_metric(void);
+int settings_get_matrix(void);
+unsigned int settings_get_queue_depth(void);
+int settings_get_stats(void);
+int settings_get_perf_counters(void);
+const char* settings_get_trace(void);
+int settings_get_progress(void);
+int settings_get_combine(void);
 
 #endif // PROJECT_INCLUDES_SETTINGS_H
@@ -0,0 +1,142 @@
+
+#ifndef PROJECT_INCLUDES_STATS_H
+#define PROJECT_INCLUDES_STATS_H
+
+/** These are the locks whose waits are timed with '--stats'. The table lock
+ *  and the entry locks are the reader-writer locks of the locked table mode,
+ *  and the max lock is the one around the running maximum of the live winner
+ *  mode. The access locks are the per-thread locks of the lock-free mode,
+ *  which a thread growing the table has to take all of. The input and
+ *  scheduler locks are what used to be the two per-file locks, back when every
+ *  file had a lock around its offset and every thread was tied to one file.
+ * 
+ */
+typedef enum {
+    LOCK_TABLE,
+    LOCK_ENTRY,
+    LOCK_MAX,
+    LOCK_ACCESS,
+    LOCK_INPUT,
+    LOCK_SCHEDULER,
+    NUMBER_OF_LOCK_KINDS
+} lock_kind_t;
+
+/** These are the phases of a run. The count phase is the single pass over
+ *  every input, or the build pass in join mode, and the seal and probe phases
+ *  only happen in join mode. Finalizing is whatever it takes to get the table
+ *  into its final state once every thread has been joined.
+ * 
+ */
+typedef enum {
+    PHASE_COUNT,
+    PHASE_SEAL,
+    PHASE_PROBE,
+    PHASE_FINALIZE,
+    NUMBER_OF_PHASES
+} phase_t;
+
+/** These are one thread's counters. Every thread has its own, on cache lines
+ *  of its own, so that counting never has any thread write to a line another
+ *  thread is writing to, which would slow down the very work being counted.
+ *  Only the threads processing the inputs have counters of their own; the
+ *  main thread and the threads the table starts to scan or merge it have
+ *  none, and only their allocations are counted, in a set shared among them.
+ * 
+ *  A lock is only timed when it is contended, which is to say when trying to
+ *  take it fails, so the clock is never read for a lock that was free.
+ * 
+ */
+struct thread_stats_t {
+    size_t bytes;
+    size_t tokens;
+    size_t new_entries;
+    size_t allocations;
+    size_t allocated_bytes;
+    double phase_seconds[NUMBER_OF_PHASES];
+    size_t lock_acquisitions[NUMBER_OF_LOCK_KINDS];
+    size_t lock_contentions[NUMBER_OF_LOCK_KINDS];
+    uint64_t lock_wait_nanoseconds[NUMBER_OF_LOCK_KINDS];
+} __attribute__((aligned(64)));
+
+/** This function allocates the counters for the given number of threads, and
+ *  is what turns counting on at all. Until it is called, every one of the
+ *  functions below does nothing but take the lock, if it was asked to.
+ * 
+ */
+void initialize_stats(size_t number_of_threads);
+
+/** Every thread processing the inputs calls this function once it starts,
+ *  with its worker number, to claim its counters.
+ * 
+ */
+void register_stats_thread(size_t worker);
+
+/** This function has the calling thread's lock waits timed even though it has
+ *  no counters of its own, which is what tracing them calls for.
+ * 
+ */
+void time_thread_locks(void);
+
+/** These functions return the names the lock kinds and the phases go by in
+ *  every report.
+ * 
+ */
+const char* lock_kind_name(lock_kind_t kind);
+const char* phase_name(phase_t phase);
+
+/** These functions return the time on the monotonic clock, in nanoseconds for
+ *  timing lock waits and anything else brief, or in seconds for timing phases.
+ *  Every module timing anything reads the same clock through them.
+ * 
+ */
+uint64_t stats_nanoseconds(void);
+double stats_clock(void);
+
+/** This function adds the time since 'start' to the given phase, for the
+ *  calling thread if it has counters of its own, and for the run as a whole
+ *  if it does not, as is the case for the main thread.
+ * 
+ */
+void record_phase(phase_t phase, double start);
+
+/** This function counts a chunk of input read and tokenized.
+ * 
+ */
+void count_input(size_t bytes, size_t tokens);
+
+/** This function counts a new entry in the table.
+ * 
+ */
+void count_new_entry(void);
+
+/** This function counts a single allocation of the given size.
+ * 
+ */
+void count_allocation(size_t size);
+
+/** These functions take the given lock, timing how long it took if it had to
+ *  be waited for.
+ * 
+ */
+__attribute__((nonnull(1)))
+void timed_mutex_lock(pthread_mutex_t* lock, lock_kind_t kind);
+
+__attribute__((nonnull(1)))
+void timed_rwlock_rdlock(pthread_rwlock_t* lock, lock_kind_t kind);
+
+__attribute__((nonnull(1)))
+void timed_rwlock_wrlock(pthread_rwlock_t* lock, lock_kind_t kind);
+
+/** This function prints every thread's counters, their totals, the time spent
+ *  waiting on each kind of lock, and the time each phase took, all to
+ *  standard error, so they never get mixed up with the answer.
+ * 
+ */
+void report_stats(void);
+
+/** This function frees the counters.
+ * 
+ */
+void release_stats(void);
+
+#endif // PROJECT_INCLUDES_STATS_H
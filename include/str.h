@@ -18,6 +18,17 @@
 __attribute__((hot, nonnull(1,2)))
 int strings_match(const char* a, const char* b);
 
+/** parse_size
+ * 
+ *  This function parses a size given on the command line, which is a positive
+ *  number of bytes, optionally followed by a K, M, or G suffix to multiply it
+ *  by the corresponding power of 1024. Anything else is a fatal error. It is
+ *  shared by the program's own options and the benchmark tools.
+ * 
+ */
+__attribute__((nonnull(1)))
+size_t parse_size(const char* argument);
+
 #ifndef NUL
 /** This is a more semantically intuitive synonym for the null character, 
  *  represented by a decimal value of 0 or an ASCII value of '\0'.
@@ -0,0 +1,98 @@
+
+#ifndef PROJECT_INCLUDES_STREAM_H
+#define PROJECT_INCLUDES_STREAM_H
+
+#ifndef STREAM_RING_SIZE
+/** This is the number of buffers in a stream's ring. The reader can get this
+ *  many chunks ahead of the slowest thread before it has to wait, and this
+ *  many threads can be tokenizing chunks of the stream at the same time.
+ * 
+ */
+#define STREAM_RING_SIZE (16)
+#else
+#error "STREAM_RING_SIZE already defined."
+#endif // STREAM_RING_SIZE
+
+/** A slot is one buffer in a stream's ring. The reader waits for a slot to be
+ *  emptied before filling it, and a thread waits for it to be filled before
+ *  tokenizing it. A filled slot with a length of zero marks the end of the
+ *  stream, and is never emptied again. Each slot sits on its own cache line,
+ *  since the reader and the threads are all writing to them. The chunk in a
+ *  slot begins 'begin' bytes into its buffer, which is only ever anywhere but
+ *  the start of the buffer for direct reads, since those have to be read into
+ *  an aligned address, with the carried-over word just before it.
+ * 
+ */
+struct stream_slot_t {
+    char* data;
+    size_t begin;
+    size_t length;
+    size_t capacity;
+    sem_t filled;
+    sem_t emptied;
+} __attribute__((aligned(64)));
+
+/** A stream is an input that cannot be mapped into memory or read at an
+ *  arbitrary offset, such as a pipe or a terminal. A single reader thread
+ *  reads it from start to finish into a ring of buffers, each ending on a word
+ *  boundary, and the threads take the buffers from the ring as if they were
+ *  chunks of any other input. The part of the last word that did not fit in a
+ *  buffer is carried over to the start of the next one.
+ * 
+ *  The threads claim their place in the ring with an atomic increment rather
+ *  than a lock, and then simply wait on that slot's semaphore, so claiming a
+ *  chunk of a stream never makes one thread wait on another.
+ * 
+ *  In the direct input mode, regular files are read as streams too, but with
+ *  O_DIRECT, which bypasses the page cache, and so requires every read to be
+ *  aligned to the given alignment, in its address, its length, and its offset
+ *  in the file. For anything else, the alignment is one.
+ * 
+ */
+struct stream_t {
+    const char* filename;
+    int file_descriptor;
+    size_t alignment;
+    pthread_t reader;
+    size_t next_slot;
+    struct stream_slot_t slots[STREAM_RING_SIZE];
+};
+
+/** This function starts reading the given file descriptor into a new stream
+ *  in the background, with every read aligned to the given power of two. The
+ *  file descriptor is left open when the stream is closed.
+ * 
+ */
+__attribute__((nonnull(2), returns_nonnull))
+struct stream_t* open_stream(int file_descriptor, const char* filename, size_t alignment);
+
+/** This function claims the next buffer of the stream, waiting for the reader
+ *  to fill it if it has not already, and returns FALSE once the stream has
+ *  ended. The chunk's start is the buffer's slot in the ring, rather than an
+ *  offset, and every claimed chunk must be released once it has been
+ *  processed, so the reader can fill it again.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+int claim_stream_chunk(struct stream_t* stream, struct chunk_t* chunk);
+
+/** This function returns the contents of a claimed chunk of the stream.
+ * 
+ */
+__attribute__((nonnull(1,2), returns_nonnull))
+const char* stream_chunk_data(const struct stream_t* stream, const struct chunk_t* chunk);
+
+/** This function hands a processed chunk of the stream back to the reader.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+void release_stream_chunk(struct stream_t* stream, const struct chunk_t* chunk);
+
+/** This function reads whatever is left of the stream, waits for the reader
+ *  to finish, and frees the stream.
+ * 
+ */
+__attribute__((nonnull(1)))
+void close_stream(struct stream_t* stream);
+
+#endif // PROJECT_INCLUDES_STREAM_H
@@ -0,0 +1,33 @@
+
+#ifndef PROJECT_INCLUDES_TABLE_COMBINE_H
+#define PROJECT_INCLUDES_TABLE_COMBINE_H
+
+/** With '--combine', every thread counting into the shared table has a small
+ *  cache of the short words it has seen most recently, and their counts, which
+ *  only reach the table in batches. These functions allocate one cache for
+ *  every thread, and let each thread claim its own.
+ * 
+ */
+void initialize_combining_caches(int number_of_threads);
+
+__attribute__((returns_nonnull))
+struct combining_cache_t* claim_combining_cache(int thread);
+
+/** This function counts a short word through the given cache, and returns the
+ *  word's entry, whose counts may not include this one until the cache is
+ *  next flushed.
+ * 
+ */
+__attribute__((hot, nonnull(1,2), returns_nonnull))
+struct table_entry_t* combine_word(struct combining_cache_t* cache, struct table_key_t* key, int file);
+
+/** This function adds every count still pending in the given cache to its
+ *  entry, which its thread does at the end of every stretch of table access.
+ * 
+ */
+__attribute__((nonnull(1)))
+void flush_combining_cache(struct combining_cache_t* cache);
+
+void release_combining_caches(void);
+
+#endif // PROJECT_INCLUDES_TABLE_COMBINE_H
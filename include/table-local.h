@@ -0,0 +1,31 @@
+
+#ifndef PROJECT_INCLUDES_TABLE_LOCAL_H
+#define PROJECT_INCLUDES_TABLE_LOCAL_H
+
+/** In local mode, every thread counts into a table of its own. This function
+ *  sets aside one for every thread, and each thread then claims its own,
+ *  which starts out with the given seed.
+ * 
+ */
+void initialize_local_tables(int number_of_threads);
+
+__attribute__((returns_nonnull))
+struct hash_table_t* claim_local_table(int thread, hash_t seed);
+
+/** This function returns the number of entries in every local table, while
+ *  their threads may still be adding to them.
+ * 
+ */
+size_t local_table_entries(void);
+
+/** This function merges the local tables into one table for every range of
+ *  hashes, and may only be called once every thread counting into them has
+ *  been joined. The merged tables are returned, and belong to the caller.
+ * 
+ */
+__attribute__((nonnull(2,4), returns_nonnull))
+struct hash_table_t* merge_local_tables(hash_t seed, struct selection_t* best, int find_words, size_t* number_of_merged_tables);
+
+void release_local_tables(void);
+
+#endif // PROJECT_INCLUDES_TABLE_LOCAL_H
@@ -0,0 +1,36 @@
+
+#ifndef PROJECT_INCLUDES_TABLE_MATRIX_H
+#define PROJECT_INCLUDES_TABLE_MATRIX_H
+
+/** This function allocates the pair matrix, which only exists if the matrix
+ *  setting asked for it, so it must only be called if it did.
+ * 
+ */
+void initialize_pair_matrix(void);
+
+/** The threads scanning the tables each fill in a pair matrix of their own,
+ *  which is then merged into the final one. Every cell of a new matrix is
+ *  empty, and the cell for the files numbered i and j, from zero, with i less
+ *  than j, is at row i and column j.
+ * 
+ */
+__attribute__((malloc, returns_nonnull))
+struct scored_entry_t* allocate_pair_matrix(void);
+
+__attribute__((hot, nonnull(1,4)))
+void find_best_pairs(const struct hash_table_t* table, size_t first_slot, size_t last_slot, struct scored_entry_t* pairs);
+
+__attribute__((nonnull(1)))
+void merge_pair_matrix(const struct scored_entry_t* pairs);
+
+/** This function looks up the most common word shared by the two given files,
+ *  numbered from one, which is only kept track of if the matrix setting asked
+ *  for it. The return value is FALSE if the files have no word in common.
+ * 
+ */
+__attribute__((nonnull(3)))
+int most_common_pair_word(int first_file, int second_file, struct shared_word_t* word);
+
+void release_pair_matrix(void);
+
+#endif // PROJECT_INCLUDES_TABLE_MATRIX_H
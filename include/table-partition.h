@@ -0,0 +1,41 @@
+
+#ifndef PROJECT_INCLUDES_TABLE_PARTITION_H
+#define PROJECT_INCLUDES_TABLE_PARTITION_H
+
+/** In partitioned mode, the hash space is split into partitions, each of which
+ *  is owned and counted by a single thread. This function sets up a worker for
+ *  every thread and the partition tables, all of which start out with the
+ *  given seed, and returns the tables, which belong to the caller.
+ * 
+ */
+__attribute__((nonnull(3), returns_nonnull))
+struct hash_table_t* initialize_partitions(int number_of_threads, hash_t seed, size_t* number_of_tables);
+
+__attribute__((returns_nonnull))
+struct partition_worker_t* claim_partition_worker(int thread);
+
+/** This function sends a word off to the owner of its partition, which counts
+ *  it the next time it drains its inbox. The key's hash must be the one for
+ *  the partition tables' seed.
+ * 
+ */
+__attribute__((hot, nonnull(1,2)))
+void scatter_word(struct partition_worker_t* worker, const struct table_key_t* key, int file);
+
+/** This function counts every word sent to the given worker so far, which its
+ *  thread does at the end of every stretch of table access.
+ * 
+ */
+__attribute__((nonnull(1)))
+void drain_partition_inbox(struct partition_worker_t* worker);
+
+/** This function counts whatever words are left over once every thread has
+ *  been joined, at which point every partition table is complete.
+ * 
+ */
+__attribute__((nonnull(1)))
+void drain_partitions(struct selection_t* best, int find_words);
+
+void release_partitions(void);
+
+#endif // PROJECT_INCLUDES_TABLE_PARTITION_H
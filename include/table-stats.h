@@ -0,0 +1,14 @@
+
+#ifndef PROJECT_INCLUDES_TABLE_STATS_H
+#define PROJECT_INCLUDES_TABLE_STATS_H
+
+/** This function prints the load factor, group occupancy, and probe lengths of
+ *  the given tables, summed over all of them, to standard error. It reads the
+ *  tables without taking any lock, so whoever calls it must make sure none of
+ *  them is being grown in the meantime.
+ * 
+ */
+__attribute__((nonnull(1)))
+void report_table_statistics(const struct hash_table_t* tables, size_t number_of_tables);
+
+#endif // PROJECT_INCLUDES_TABLE_STATS_H
@@ -0,0 +1,69 @@
+
+#ifndef PROJECT_INCLUDES_TOKENIZE_H
+#define PROJECT_INCLUDES_TOKENIZE_H
+
+/** A token is simply a word located somewhere in an input buffer. Tokens are
+ *  not NUL-terminated, since the tokenizer never modifies the buffer it is
+ *  given, which is what allows it to work on read-only memory.
+ * 
+ */
+struct token_t {
+    const char* start;
+    size_t length;
+};
+
+/** The tokenizer classifies its buffer sixty-four bytes at a time, so this is
+ *  the state it needs to carry from one block to the next: where the next
+ *  block starts, and whether a word runs across the boundary between the two,
+ *  along with where that word starts if so.
+ * 
+ */
+struct tokenizer_t {
+    const char* buffer;
+    size_t length;
+    size_t position;
+    size_t word_start;
+    int in_word;
+};
+
+#ifndef TOKEN_BATCH_SIZE
+/** This is the number of tokens the tokenizer's callers collect in between
+ *  processing them. It must be larger than the largest number of tokens a
+ *  single block can produce, which is thirty-two, plus one for a word ending
+ *  at the very end of the buffer.
+ * 
+ */
+#define TOKEN_BATCH_SIZE (128)
+#else
+#error "TOKEN_BATCH_SIZE already defined."
+#endif // TOKEN_BATCH_SIZE
+
+/** This function returns whether the given byte can be part of a word, which
+ *  per the program spec means whether it is an ASCII letter or digit. It is
+ *  the one-byte-at-a-time version of what the tokenizer does in bulk, for
+ *  callers that only need to look at a handful of bytes.
+ * 
+ */
+__attribute__((const))
+int is_word_character(char c);
+
+/** This function prepares a tokenizer to split the given buffer into words.
+ *  Per the program spec, a word is any run of ASCII letters and digits, and
+ *  every other byte is a delimiter. The start and end of the buffer always
+ *  delimit words, so the caller is responsible for not splitting the input in
+ *  the middle of one.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+void initialize_tokenizer(struct tokenizer_t* tokenizer, const char* buffer, size_t length);
+
+/** This function fills the tokens array with up to 'capacity' of the next
+ *  tokens in the buffer, in order, and returns how many it found. A return
+ *  value of zero means the whole buffer has been tokenized. The capacity must
+ *  be at least thirty-three, for the reason given above TOKEN_BATCH_SIZE.
+ * 
+ */
+__attribute__((hot, nonnull(1,2)))
+size_t next_tokens(struct tokenizer_t* tokenizer, struct token_t* tokens, size_t capacity);
+
+#endif // PROJECT_INCLUDES_TOKENIZE_H
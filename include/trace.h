@@ -0,0 +1,125 @@
+
+#ifndef PROJECT_INCLUDES_TRACE_H
+#define PROJECT_INCLUDES_TRACE_H
+
+/** This is the number of events every thread has room for with '--trace'.
+ *  The buffers are allocated and touched up front, so recording an event never
+ *  allocates or faults in a page in the middle of the run it is recording, and
+ *  any events past the end of a full buffer are dropped, and counted, instead.
+ *  At forty-eight bytes an event, that is three megabytes a thread.
+ * 
+ */
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS (1 << 16)
+#else
+#error "TRACE_BUFFER_EVENTS already defined."
+#endif // TRACE_BUFFER_EVENTS
+
+/** Only lock waits at least this many nanoseconds long make it into the
+ *  trace. A trace of every brief wait would fill the buffers with events too
+ *  short to see, while the waits worth seeing are the long ones, and above all
+ *  the convoys of them that build up behind a single lock.
+ * 
+ */
+#ifndef TRACE_LOCK_WAIT_THRESHOLD
+#define TRACE_LOCK_WAIT_THRESHOLD (10000)
+#else
+#error "TRACE_LOCK_WAIT_THRESHOLD already defined."
+#endif // TRACE_LOCK_WAIT_THRESHOLD
+
+/** These are the kinds of events in the trace. Claiming is the time it takes
+ *  a thread to get its next chunk from the scheduler, reading is the time it
+ *  takes to get the chunk into memory, or to wait for its read to complete in
+ *  the uring input mode, and tokenizing is splitting the chunk into words and
+ *  adding them to the table. Lock waits are the contended acquisitions of any
+ *  of the timed locks, and phases are the phases of the run as a whole, which
+ *  only the main thread records.
+ * 
+ */
+typedef enum {
+    TRACE_CLAIM,
+    TRACE_READ,
+    TRACE_TOKENIZE,
+    TRACE_LOCK_WAIT,
+    TRACE_PHASE
+} trace_kind_t;
+
+/** This is a single event, from its start to its end in nanoseconds. Chunk
+ *  events record the chunk's input, offset and length, while lock waits and
+ *  phases record which lock or phase they were in 'detail'.
+ * 
+ */
+struct trace_event_t {
+    uint64_t start;
+    uint64_t end;
+    const char* filename;
+    off_t offset;
+    size_t length;
+    uint32_t kind;
+    uint32_t detail;
+};
+
+/** These are one thread's events. Every thread has its own buffer, on cache
+ *  lines of its own, so recording an event never takes a lock or touches a
+ *  line any other thread is writing to.
+ * 
+ */
+struct trace_buffer_t {
+    struct trace_event_t* events;
+    size_t number_of_events;
+    size_t dropped;
+} __attribute__((aligned(64)));
+
+/** This function allocates a buffer for each of the given number of threads,
+ *  and one more for the main thread, which it registers right away. Until it
+ *  is called, every one of the functions below does nothing.
+ * 
+ */
+void initialize_trace(size_t number_of_threads);
+
+/** Every thread processing the inputs calls this function once it starts,
+ *  with its worker number, to claim its buffer. Doing so also has its lock
+ *  waits timed, whether or not '--stats' asked for them.
+ * 
+ */
+void register_trace_thread(size_t worker);
+
+/** This function returns the current time in nanoseconds, for the start of an
+ *  event, or zero if the calling thread is not being traced, in which case
+ *  the clock is never read at all.
+ * 
+ */
+uint64_t trace_clock(void);
+
+/** This function records an event that began at 'start' and ends now. The
+ *  filename, offset and length are only meaningful for the chunk events.
+ * 
+ */
+void trace_event(trace_kind_t kind, uint64_t start, const char* filename, off_t offset, size_t length);
+
+/** This function records a phase of the run, for the main thread.
+ * 
+ */
+void trace_phase(phase_t phase, uint64_t start);
+
+/** This function records a wait for the given kind of lock, from 'start' to
+ *  'end', provided it was at least TRACE_LOCK_WAIT_THRESHOLD long.
+ * 
+ */
+void trace_lock_wait(lock_kind_t kind, uint64_t start, uint64_t end);
+
+/** This function writes every thread's events to the given file, in the
+ *  Chrome trace event format that both chrome://tracing and Perfetto load.
+ *  It is only called once every thread has been joined, so none of the work
+ *  of formatting the events ever lands in the middle of the run.
+ * 
+ */
+__attribute__((nonnull(1)))
+void write_trace(const char* filename);
+
+/** This function frees the buffers.
+ * 
+ */
+void release_trace(void);
+
+#endif // PROJECT_INCLUDES_TRACE_H
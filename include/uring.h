@@ -0,0 +1,98 @@
+
+#ifndef PROJECT_INCLUDES_URING_H
+#define PROJECT_INCLUDES_URING_H
+
+#ifndef URING_BUFFER_SLACK
+/** This is how much longer than the chunk size every buffer is, to make room
+ *  for the end of the word a chunk is extended to. A chunk that still does not
+ *  fit is read synchronously instead.
+ * 
+ */
+#define URING_BUFFER_SLACK (4096)
+#else
+#error "URING_BUFFER_SLACK already defined."
+#endif // URING_BUFFER_SLACK
+
+/** A uring is a single thread's io_uring instance, set up with nothing but
+ *  the raw system calls, along with one buffer for every read the thread can
+ *  have in flight at once. The buffers are one allocation, and are registered
+ *  with the kernel whenever it allows it, so that it does not have to map
+ *  them in and out for every read. Should registration fail, say because of
+ *  the locked memory limit, the buffers are used unregistered.
+ * 
+ *  The submission and completion queues are shared with the kernel, which is
+ *  why their heads and tails are read and written with atomics. The kernel
+ *  only ever writes to the submission queue's head and the completion queue's
+ *  tail, while the thread only ever writes to the other two.
+ * 
+ */
+struct uring_t {
+    int ring_descriptor;
+    unsigned int depth;
+    unsigned int pending;
+
+    void* submission_ring;
+    size_t submission_ring_size;
+    unsigned int* submission_head;
+    unsigned int* submission_tail;
+    unsigned int* submission_mask;
+    unsigned int* submission_array;
+    struct io_uring_sqe* submission_entries;
+    size_t submission_entries_size;
+
+    void* completion_ring;
+    size_t completion_ring_size;
+    unsigned int* completion_head;
+    unsigned int* completion_tail;
+    unsigned int* completion_mask;
+    struct io_uring_cqe* completion_entries;
+
+    char* buffers;
+    size_t buffer_size;
+    int registered;
+};
+
+/** This function checks whether the kernel supports io_uring at all, which it
+ *  may not, either because it is too old, or because io_uring has been
+ *  disabled, as it commonly is in containers.
+ * 
+ */
+int uring_supported(void);
+
+/** This function sets up a uring with room for 'depth' reads in flight, each
+ *  into a buffer of 'buffer_size' bytes, returning FALSE if it cannot.
+ * 
+ */
+__attribute__((nonnull(1)))
+int create_uring(struct uring_t* uring, unsigned int depth, size_t buffer_size);
+
+/** This function returns the buffer with the given index.
+ * 
+ */
+__attribute__((nonnull(1), returns_nonnull))
+char* uring_buffer(const struct uring_t* uring, unsigned int index);
+
+/** This function queues a read of 'length' bytes at 'offset' in the file into
+ *  the buffer with the given index, which identifies the read once it has
+ *  completed. The read is only submitted to the kernel on the next wait.
+ * 
+ */
+__attribute__((nonnull(1)))
+void uring_prepare_read(struct uring_t* uring, unsigned int index, int file_descriptor, off_t offset, size_t length);
+
+/** This function submits every queued read and waits for one of the reads in
+ *  flight to complete, returning the index of its buffer, and storing the
+ *  number of bytes read, or the negated error number, in 'result'.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+unsigned int uring_wait_for_read(struct uring_t* uring, ssize_t* result);
+
+/** This function tears the uring down and frees its buffers. There must be no
+ *  reads left in flight.
+ * 
+ */
+__attribute__((nonnull(1)))
+void destroy_uring(struct uring_t* uring);
+
+#endif // PROJECT_INCLUDES_URING_H
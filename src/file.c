@@ -91,6 +91,23 @@ int open_file_descriptor(const char* filename, int flags) {
     return file_descriptor;
 }
 
+/** A file system without O_DIRECT support refuses to open the file with
+ *  EINVAL, which is the one failure the caller can recover from, by reading
+ *  the file through the page cache after all. Anything else is just as fatal
+ *  as it is for open_file_descriptor.
+ * 
+ */
+int open_direct_file_descriptor(const char* filename) {
+    int file_descriptor = open(filename, O_RDONLY | O_DIRECT);
+
+    if ((file_descriptor == -1) && (errno != EINVAL)) {
+        fprintf(stderr, "[Error] %s (%s)\n", strerror(errno), filename);
+        exit(EXIT_FAILURE);
+    }
+
+    return file_descriptor;
+}
+
 /** This function is a wrapper around the 'close' function, implicitly handling
  *  error-checking and return code validation. Just as with the previous
  *  functions, the caller may be assured that execution of any code after this
@@ -105,3 +122,39 @@ void close_file_descriptor(int file_descriptor) {
         exit(EXIT_FAILURE);
     }
 }
+
+/** This function maps the first 'length' bytes of an open file into memory
+ *  for reading, optionally prefaulting every page of the mapping up front.
+ *  Unlike the other wrappers in this file, a failure here is not fatal, since
+ *  not every file can be mapped, and the caller is expected to fall back to
+ *  reading the file instead. The return value is NULL in that case.
+ * 
+ */
+void* map_file_descriptor(int file_descriptor, size_t length, int populate) {
+    int flags = MAP_PRIVATE;
+
+    if (populate) {
+        flags |= MAP_POPULATE;
+    }
+
+    void* address = mmap(NULL, length, PROT_READ, flags, file_descriptor, 0);
+
+    if (address == MAP_FAILED) {
+        return NULL;
+    }
+
+    return address;
+}
+
+/** This function is a wrapper around 'munmap', with the usual guarantee that
+ *  execution continues past the call if and only if it succeeds.
+ * 
+ */
+void unmap_file(const void* address, size_t length) {
+    errno = 0;
+
+    if (munmap((void *) address, length) == -1) {
+        fprintf(stderr, "[Error] %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
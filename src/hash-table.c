@@ -1,54 +1,105 @@
-
 #include "common.h"
 
-typedef unsigned long long int hash_t;
+/** Every hash function takes the word, its length, and a seed. The seed is
+ *  what allows the table to pick a different hash function out of the same
+ *  family whenever its probe lengths suggest the current one is doing a poor
+ *  job on the input at hand.
+ * 
+ */
+typedef hash_t (*hash_function)(const char*, size_t, hash_t);
+
+#ifndef PROBE_LENGTH_LIMIT
+/** An insertion that has to probe more than this many slots past its home slot
+ *  to find an empty one is taken as a sign that the hash function is doing a
+ *  poor job on this particular input, and the table is rehashed with a new
+ *  seed. Even at the table's maximum load factor, runs of full slots this long
+ *  are vanishingly rare with a hash function that is doing its job.
+ * 
+ */
+#define PROBE_LENGTH_LIMIT (4096)
+#else
+#error "PROBE_LENGTH_LIMIT already defined."
+#endif // PROBE_LENGTH_LIMIT
 
-typedef hash_t (*hash_function)(const char*);
+#ifndef MEAN_PROBE_LENGTH_LIMIT
+/** Right after the table has grown, it is less than half full, and a good
+ *  hash function leaves the average entry well under a slot away from its home
+ *  slot. If the average is more than this many slots instead, the table is
+ *  rehashed with a new seed on the spot.
+ * 
+ */
+#define MEAN_PROBE_LENGTH_LIMIT (8)
+#else
+#error "MEAN_PROBE_LENGTH_LIMIT already defined."
+#endif // MEAN_PROBE_LENGTH_LIMIT
 
-#ifndef HASH_MODULUS
-#define HASH_MODULUS (52379)
+#ifndef ARENA_BLOCK_SIZE
+/** Table entries and the words they point to are carved out of arena blocks of
+ *  this size rather than being individually allocated. See 'table_arenas_t'.
+ * 
+ */
+#define ARENA_BLOCK_SIZE (1 << 20)
 #else
-#error "HASH_MODULUS already defined."
-#endif // HASH_MODULUS
+#error "ARENA_BLOCK_SIZE already defined."
+#endif // ARENA_BLOCK_SIZE
+
+/** None of the original hash functions below were designed to produce good
+ *  high bits, and the Weinberger hash in particular always leaves the top byte
+ *  clear. Since the table takes the slot index from the top bits of the hash
+ *  and the control byte from the bottom seven, each of them finishes by
+ *  passing its hash through this finalizer (the one from MurmurHash3) to
+ *  spread each input bit across the whole word.
+ * 
+ *  The original hash functions have no notion of a seed, so the seed is mixed
+ *  in along with their hash. That changes where every word lands in the table,
+ *  which is enough to break up clusters, but two words whose unmixed hashes
+ *  collide outright will still collide under every seed.
+ * 
+ */
+__attribute__((const))
+static inline hash_t mix_hash(hash_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
 
 /** The most basic hash function known to man. Used literally just for getting
- *  the prototype going. It is marked with the 'unused' attribute because I
- *  haven't implemented the ability to switch hash functions after compilation,
- *  and the weinberg hash function has proven much more robust, with a
- *  negligible amount of hash collisions during testing.
+ *  the prototype going, and still available through '--hash trivial' for
+ *  comparison's sake.
  * 
  */
-__attribute__((hot, nonnull(1), unused))
-static hash_t trivial_hash(const char* str) {
+__attribute__((hot, nonnull(1)))
+static hash_t trivial_hash(const char* str, size_t length, hash_t seed) {
     hash_t hash = 0;
 
-    while (*str) {
-        hash = (*str++) + 211 * hash;
+    for (size_t i = 0; i < length; ++i) {
+        hash = str[i] + 211 * hash;
     }
 
-    return hash % HASH_MODULUS;
+    return mix_hash(hash ^ seed);
 }
 
 /** Professor Robert Sedgewick's universal hash function for string keys, from
- *  Algorithms in C page 579. I elided the length argument, as it isn't
- *  necessary to iterate over the string to hash.
- * 
- *  This function is also marked 'unused' to indicate that I have not yet
- *  implemented the functionality to switch hash functions after compilation.
+ *  Algorithms in C page 579. The length argument I originally elided is back,
+ *  since the words handed to the table are no longer NUL-terminated.
  * 
  */
-__attribute__((nonnull(1), unused))
-static hash_t basic_hash(const char* str) {
+__attribute__((hot, nonnull(1)))
+static hash_t sedgewick_hash(const char* str, size_t length, hash_t seed) {
     hash_t hash = 0;
     hash_t    a = 63689;
     hash_t    b = 378551;
 
-    while (*str) {
-        hash = (*str++) + a * hash;
+    for (size_t i = 0; i < length; ++i) {
+        hash = str[i] + a * hash;
         a = a * b;
     }
 
-    return hash % HASH_MODULUS;
+    return mix_hash(hash ^ seed);
 }
 
 /** Hashing algorithm developed by Dr. Peter Weinberger and discussed at length
@@ -56,72 +107,228 @@ static hash_t basic_hash(const char* str) {
  * 
  */
 __attribute__((hot, nonnull(1)))
-static hash_t weinberger_hash(const char* str) {
+static hash_t weinberger_hash(const char* str, size_t length, hash_t seed) {
     hash_t hash = 0;
     hash_t bits = 8 * sizeof (hash_t);
     hash_t three_fourths = (bits * 3) / 4;
     hash_t one_eighth = bits / 8;
     hash_t high_bits = 0xffffffff << (bits - one_eighth);
 
-    while (*str) {
+    for (size_t i = 0; i < length; ++i) {
         hash_t test = 0;
-        hash = (hash << one_eighth) + (*str++);
+        hash = (hash << one_eighth) + str[i];
 
         if ((test = hash & high_bits) != 0) {
             hash = ((hash ^ (test >> three_fourths)) & (~high_bits));
         }
     }
 
-    return hash % HASH_MODULUS;
+    return mix_hash(hash ^ seed);
+}
+
+/** These functions read unaligned little-endian words out of the input for the
+ *  word-at-a-time hash functions below. Going through 'memcpy' is the portable
+ *  way of doing an unaligned load, and compiles down to a single instruction.
+ * 
+ */
+__attribute__((pure, nonnull(1)))
+static inline uint64_t read64(const char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof (value));
+    return value;
+}
+
+__attribute__((pure, nonnull(1)))
+static inline uint64_t read32(const char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof (value));
+    return value;
+}
+
+/** This is the 64x64-bit multiply at the heart of wyhash. The full 128-bit
+ *  product is folded back into 64 bits by XORing its two halves, so every bit
+ *  of both operands affects every bit of the result.
+ * 
+ */
+__attribute__((const))
+static inline uint64_t multiply_and_fold(uint64_t a, uint64_t b) {
+    __extension__ unsigned __int128 product = (unsigned __int128) a * b;
+
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+}
+
+/** This is Wang Yi's wyhash (final version 4), which consumes the input eight
+ *  or sixteen bytes at a time and mixes with 128-bit multiplies. Any word of
+ *  up to sixteen bytes, which is nearly every word, is read with at most four
+ *  overlapping loads and hashed with two multiplies, with no loop at all. The
+ *  loads never stray outside the word, so it is safe to hash a word sitting at
+ *  the very end of a memory-mapped file.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+static hash_t wyhash(const char* str, size_t length, hash_t seed) {
+    static const uint64_t secret[4] = {
+        0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+    };
+
+    const char* p = str;
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+
+    seed ^= multiply_and_fold(seed ^ secret[0], secret[1]);
+
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (read32(p) << 32) | read32(p + ((length >> 3) << 2));
+            b = (read32(p + length - 4) << 32) | read32(p + length - 4 - ((length >> 3) << 2));
+        } else if (length > 0) {
+            a = ((uint64_t) (unsigned char) p[0] << 16) | ((uint64_t) (unsigned char) p[length >> 1] << 8) | (uint64_t) (unsigned char) p[length - 1];
+        }
+    } else {
+        size_t remaining = length;
+
+        if (remaining > 48) {
+            uint64_t seed1 = seed;
+            uint64_t seed2 = seed;
+
+            do {
+                seed  = multiply_and_fold(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                seed1 = multiply_and_fold(read64(p + 16) ^ secret[2], read64(p + 24) ^ seed1);
+                seed2 = multiply_and_fold(read64(p + 32) ^ secret[3], read64(p + 40) ^ seed2);
+
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+
+            seed ^= seed1 ^ seed2;
+        }
+
+        while (remaining > 16) {
+            seed = multiply_and_fold(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+
+            p += 16;
+            remaining -= 16;
+        }
+
+        a = read64(p + remaining - 16);
+        b = read64(p + remaining - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+
+    __extension__ unsigned __int128 product = (unsigned __int128) a * b;
+
+    a = (uint64_t) product;
+    b = (uint64_t) (product >> 64);
+
+    return multiply_and_fold(a ^ secret[0] ^ length, b ^ secret[1]);
+}
+
+/** This is Austin Appleby's MurmurHash64A, which consumes the input eight bytes
+ *  at a time with a multiply-shift mix per word. It is a little slower than
+ *  wyhash on short words, since it needs a multiply per word and a switch for
+ *  the tail, but it only needs 64-bit multiplies, and its finalizer is the
+ *  same one used by 'mix_hash'.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+static hash_t murmur_hash(const char* str, size_t length, hash_t seed) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const unsigned int r = 47;
+
+    uint64_t hash = seed ^ (length * m);
+
+    const char* end = str + (length & ~(size_t) 7);
+
+    for (const char* p = str; p != end; p += 8) {
+        uint64_t k = read64(p);
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        hash ^= k;
+        hash *= m;
+    }
+
+    const unsigned char* tail = (const unsigned char *) end;
+
+    switch (length & 7) {
+        case 7: hash ^= (uint64_t) tail[6] << 48; /* Falls through. */
+        case 6: hash ^= (uint64_t) tail[5] << 40; /* Falls through. */
+        case 5: hash ^= (uint64_t) tail[4] << 32; /* Falls through. */
+        case 4: hash ^= (uint64_t) tail[3] << 24; /* Falls through. */
+        case 3: hash ^= (uint64_t) tail[2] << 16; /* Falls through. */
+        case 2: hash ^= (uint64_t) tail[1] << 8;  /* Falls through. */
+        case 1: hash ^= (uint64_t) tail[0];
+                hash *= m;
+                break;
+        default: break;
+    }
+
+    hash ^= hash >> r;
+    hash *= m;
+    hash ^= hash >> r;
+
+    return hash;
 }
 
 /** This function pointer determines the hashing algorithm to use for the
- *  table. Crucially, there is no mechanism in place right now to modify the
- *  algorithm at runtime, nor is there a way to rebuild the table as is
- *  necessary when changing hash functions once the table already exists. This
- *  will have to be implemented before dynamic algorithm selection can occur.
+ *  table. It is set from the settings when the table is initialized, before
+ *  any word is hashed, and never changes after that. What does change is the
+ *  seed each table hashes its words with; see 'reseed_table'.
  * 
  */
-static hash_function calculate_hash = weinberger_hash;
+static hash_function calculate_hash = wyhash;
+
+static const hash_function hash_functions[] = { wyhash, murmur_hash, weinberger_hash, sedgewick_hash, trivial_hash };
+
+__attribute__((hot, nonnull(1)))
+hash_t hash_word(const char* word, size_t length, hash_t seed) {
+    return calculate_hash(word, length, seed);
+}
 
 static double volatile current_max = 0.0;
 
 static char volatile* most_common_word = NULL;
 
+/** These are the best K entries found by scanning or merging the tables, where
+ *  K is the number of words the user asked for, or one if they didn't ask.
+ * 
+ */
+static struct selection_t top_words = { NULL, 0, 0 };
+
 /** This mutex prevents multiple threads clobbering the current max due to race
- *  conditions. The choice to use of a mutex over a reader-writer lock was made
- *  in light of the fact that a reader-writer lock would need to be locked in
- *  read mode to check the max and then re-locked in write mode if the max
- *  required modification. I'm not 100% sure if the rw-lock requires an
- *  intermediate unlock before re-locking in write mode, but if it doesn't I'll
- *  change this to a reader-writer lock to enhance throughput. After all, most
- *  threads presumably won't need to modify the max, as the current count will
- *  be too low, especially towards the end of execution. When the time comes
- *  I'll be sure to profile to verify.
+ *  conditions. It is only ever taken in the live winner mode, where every
+ *  counted word checks the running maximum, and by snapshots in that mode. In
+ *  the default scan mode, the most common word is found once every thread has
+ *  finished, and no thread touches this mutex at all, which is what took it
+ *  off the path of every word rather than a switch to a reader-writer lock.
  * 
  */
 static pthread_mutex_t max_lock = PTHREAD_MUTEX_INITIALIZER;
 
-/** This function returns the most common word shared by the two input files.
- *  The most_common_word variable is initially zero, so if there is no common
- *  word, maybe because the two input files are empty, the return value will be
- *  a NULL pointer. 
+/** This is the table every thread counts into in the locked and lock-free
+ *  modes. The other modes count into tables of their own, which are merged,
+ *  or simply kept, as the merged tables below once every thread is done.
  * 
  */
-const char volatile* most_common_shared_word(void) {
-    return most_common_word;
-}
+static struct hash_table_t hash_table = { 0 };
 
-/** This is the hash table for the strings in the input files. The hash table
- *  employs lock-based synchronization in the form of reader-writer locks to
- *  ensure data coherence in spite of being manipulated by multiple threads
- *  concurrently.
+/** This is the seed every table starts out with. It comes from the random
+ *  bytes the kernel hands every new process, so it differs from run to run,
+ *  and an input cannot be crafted ahead of time to collide under it.
  * 
- *  Each entry in the hash table has its own reader-writer lock to allow for
- *  more granular control over memory resources.
+ */
+static hash_t initial_seed = 0;
+
+/** This is the number of times any table has been rehashed with a new seed,
+ *  which is reported along with the rest of the table statistics.
  * 
  */
-static struct table_entry_t *hash_table[HASH_MODULUS];
+static size_t number_of_reseeds = 0;
 
 /** This is the lock-based synchronization tool to ensure data coherence within
  *  the hash table. The benefit of employing a reader-writer lock instead of a
@@ -134,243 +341,1567 @@ static struct table_entry_t *hash_table[HASH_MODULUS];
  */
 static pthread_rwlock_t hash_table_lock = PTHREAD_RWLOCK_INITIALIZER;
 
-/** This function's only purpose is to allocate the memory required by the
- *  'struct table_entry_t' object, verifying the pointer returned by 'malloc',
- *  and taking the appropriate steps if an invalid pointer is detected.
+/** The table mode is copied out of the settings when the table is initialized,
+ *  since it is checked for every single word.
+ * 
+ */
+static table_mode_t table_mode = TABLE_LOCKED;
+
+/** The winner mode is copied out of the settings for the same reason. Unless
+ *  it is live, nothing about the running maximum is touched while counting.
  * 
- *  In the current implementation, 'taking the appropriate steps' simply means
- *  printing an error to standard error and exiting with an error status of
- *  EXIT_FAILURE (usually defined as '1' by convention).
+ */
+static winner_mode_t winner_mode = WINNER_SCAN;
+
+/** The number of inputs is copied out of the settings as well, since it is the
+ *  length of every entry's count vector, and with it the size of every entry.
  * 
  */
-__attribute__((hot, returns_nonnull))
-static inline struct table_entry_t* allocate_table_entry(void) {
-    struct table_entry_t* entry = malloc(sizeof (struct table_entry_t));
+static size_t number_of_inputs = 2;
 
-    if (entry == NULL) {
-        fatal_error("Memory allocation failure in allocate_table_entry()");
-    }
+static size_t table_entry_size = 0;
 
-    return entry;
+/** Only locked mode gives every entry a reader-writer lock of its own. The
+ *  lock is not part of 'table_entry_t' at all; in locked mode, it is tacked on
+ *  after the counts, at this offset from the start of the entry, and in every
+ *  other mode, the entry simply ends with its counts, which keeps as many
+ *  entries as possible on every cache line.
+ * 
+ */
+static size_t entry_lock_offset = 0;
+
+__attribute__((hot, const, nonnull(1), returns_nonnull))
+static inline pthread_rwlock_t* entry_lock(struct table_entry_t* entry) {
+    return (pthread_rwlock_t *) ((char *) entry + entry_lock_offset);
 }
 
-/** This function initializes the table entry object returned by
- *  'allocate_table_entry'. The allocation function will exit if an invalid
- *  allocation is detected, so 'create_table_entry' can assume program
- *  execution will continue if and only if entry allocation was successful. The
- *  word counts are initialized by being set to zero, and a deep copy of the
- *  string is made, as the input buffer in the process_file function will be
- *  rewritten once it has been fully processed.
+/** In join mode, the table is sealed once the smaller input has been counted,
+ *  and from then on the larger input only ever probes it. Sealing a local
+ *  table means merging it, so the merge has to know not to bother looking for
+ *  the most common word, since the counts it would be looking at are only
+ *  half done.
  * 
- *  The table entry's reader-writer lock must be dynamically initialized by
- *  calling pthread_rwlock_init, passing the lock by reference, along with the
- *  reader-writer lock attributes. At the moment, these attributes are being
- *  left as the default, specified with NULL.
+ */
+static int join_mode = FALSE;
+
+static int table_sealed = FALSE;
+
+/** This mutex keeps a snapshot of the table from looking at the local tables
+ *  while they are being merged into the sealed ones, which only ever happens
+ *  on the main thread, so no thread counting words ever waits on it.
  * 
  */
-__attribute__((nonnull(1), returns_nonnull))
-static struct table_entry_t* create_table_entry(const char* word) {
-    struct table_entry_t* entry = allocate_table_entry();
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
 
-    entry->count1 = 0;
-    entry->count2 = 0;
+/** In lock-free mode, no lock is taken for any individual word. The one thing
+ *  that still requires excluding every other thread is growing the table,
+ *  since that replaces the control bytes and slots wholesale. Rather than a
+ *  shared lock every thread would have to touch, each thread has its own
+ *  mutex, which it holds while it processes a buffer. A thread that needs to
+ *  grow the table acquires every one of these mutexes, so it waits for each
+ *  thread to reach the end of its current buffer. Each mutex sits on its own
+ *  cache line, so acquiring it never contends with another thread.
+ * 
+ */
+struct table_access_lock_t {
+    pthread_mutex_t lock;
+} __attribute__((aligned(64)));
 
-    entry->word   = strdup(word);
+static struct table_access_lock_t* table_access_locks = NULL;
 
-    if (entry->word == NULL) {
-        fatal_error("Memory allocation failure in create_table_entry->strdup(word)");
-    }
+static int number_of_table_threads = 0;
 
-    if (pthread_rwlock_init(&entry->lock, NULL)) {
-        fatal_error("Failed to dynamically initialize entry mutex");
-    }
+/** There is one more access lock than there are threads, which belongs to
+ *  whoever takes a snapshot of the table. Holding it keeps the table from
+ *  growing while the snapshot scans it, without stopping any thread from
+ *  counting words in the meantime.
+ * 
+ */
+static int number_of_access_locks = 0;
 
-    entry->next = NULL;
+static int registered_table_threads = 0;
 
-    return entry;
-}
+static __thread int table_thread_index = -1;
 
-/** This function calculates the geometric mean of two real numbers in the
- *  expected manner: it multiplies the two numbers together and takes the
- *  square root.
+/** These are what a thread claims along with its index the first time it
+ *  calls 'begin_table_access': its combining cache, if '--combine' was given,
+ *  its own table in local mode, and its partition worker in partitioned mode.
+ *  Each of them belongs to the module named after it.
  * 
- *  This function is used to calculate what I called the 'commonality' of the
- *  strings in the input files. To differentiate between many repeated
- *  appearances of a string in one file while barely any in the other, the
- *  geometric mean will score more favorably by a string that has about equal
- *  representation in both files, rather than one over the other.
+ */
+static int combine_mode = FALSE;
+
+static __thread struct combining_cache_t* combining_cache = NULL;
+
+static __thread struct hash_table_t* local_table = NULL;
+
+static __thread struct partition_worker_t* partition_worker = NULL;
+
+/** In local mode, these are the tables the local tables are merged into, one
+ *  for every range of hashes, and in partitioned mode, they are the partition
+ *  tables from the start. Either way, they take the place of the shared table
+ *  once every thread is done counting.
  * 
  */
-__attribute__((hot, pure, unused))
-static double geometric_mean(double a, double b) {
-    return sqrt(a * b);
-}
+static struct hash_table_t* merged_tables = NULL;
 
-/** This function calculates the harmonic mean of two real numbers in the
- *  expected manner: it multiplies the two numbers together and takes the
- *  square root.
+static size_t number_of_merged_tables = 0;
+
+/** The pair matrix is only ever filled in by scanning the tables, so the scan
+ *  has to know whether it was asked for.
  * 
- *  This function is also used to calculate the commonality of the strings in
- *  the input files, with the difference being that a higher priority is given
- *  to strings that appeared in high amounts in both files, rather than
- *  a lot in one file and maybe once in the other, which is a weakness with the
- *  geometric mean metric.
+ */
+static int matrix_mode = FALSE;
+
+/** The hash ranges used for merging are computed by scaling the hash into the
+ *  number of ranges with a 128-bit multiply, which splits the hash space into
+ *  ranges whose sizes differ by at most one, whatever the number of ranges.
  * 
  */
-__attribute((hot, pure))
-static double harmonic_mean(double a, double b) {
-    return 2.0 / ((1.0 / a) + (1.0 / b));
+__extension__ typedef unsigned __int128 uint128_t;
+
+__attribute__((const))
+size_t hash_range(hash_t hash, size_t ranges) {
+    return (size_t) (((uint128_t) hash * ranges) >> 64);
 }
 
-/** This function implicitly casts the entry parameters to real numbers and
- *  calls the geometric_mean function to calculate the commonality score for
- *  the given string.
+__attribute__((const))
+hash_t first_hash_in_range(size_t range, size_t ranges) {
+    return (hash_t) ((((uint128_t) range << 64) + ranges - 1) / ranges);
+}
+
+/** This function builds the key for a word, hashing it with the given seed,
+ *  which must be the seed of the table it is about to be looked up in. A short
+ *  word is also copied into the key's zero-padded inline copy once, here,
+ *  rather than every time it is compared with an entry.
  * 
  */
 __attribute__((hot, nonnull(1)))
-static inline double commonality(struct table_entry_t* entry, double (*metric_function)(double,double)) {
-    return metric_function((double) entry->count1, (double) entry->count2);
+static inline struct table_key_t create_table_key(const char* word, size_t length, hash_t seed) {
+    struct table_key_t key = {
+        .word        = word,
+        .length      = length,
+        .hash        = calculate_hash(word, length, seed),
+        .seed        = seed,
+        .inline_word = { 0, 0 }
+    };
+
+    if (length < INLINE_WORD_SIZE) {
+        memcpy(key.inline_word, word, length);
+    }
+
+    return key;
 }
 
-/** This function takes care of hashing the current string and returning the
- *  address the entry is supposed to be in. This function takes care of
- *  resolving hash collisions by iterating through the linked list of entries
- *  at the hash value in question until either a free spot is found or the
- *  string matches the string in one of the linked list entries. This latter
- *  case means we should not allocate a new entry; we simply need to increment
- *  the that entry's reference count.
+/** A key's hash is computed with the seed of the table it is about to be
+ *  looked up in. If that table has been reseeded in the meantime, which can
+ *  only happen while it is being grown, the key has to be rehashed before it
+ *  can be compared against any entry. This is a single comparison otherwise.
  * 
  */
-__attribute__((nonnull(1)))
-static struct table_entry_t* lookup_word(const char* word) {
-    struct table_entry_t* entry = hash_table[calculate_hash(word)];
+__attribute__((hot, nonnull(1,2)))
+static inline void refresh_key(const struct hash_table_t* table, struct table_key_t* key) {
+    const hash_t seed = __atomic_load_n(&table->seed, __ATOMIC_RELAXED);
+
+    if (key->seed != seed) {
+        key->hash = calculate_hash(key->word, key->length, seed);
+        key->seed = seed;
+    }
+}
+
+/** Table entries and word strings used to be allocated individually, with one
+ *  call to 'malloc' for the entry and another to 'strdup' for the word. They
+ *  are now bump-allocated out of a pair of arenas belonging to the thread that
+ *  creates them, one for the entries and one for the words, so releasing the
+ *  table's resources is a matter of freeing a handful of blocks per thread
+ *  rather than walking every entry.
+ * 
+ *  Keeping the words out of the entry arena packs the entries themselves
+ *  tightly together, which is what the final scan for the most common word
+ *  reads, and lets the words be packed byte to byte with no padding at all.
+ * 
+ *  Allocating from a thread's own arenas needs no synchronization, even in
+ *  lock-free mode. The only shared operation is pushing a thread's arenas onto
+ *  the list of every thread's arenas, which happens once per thread, the first
+ *  time it creates an entry.
+ * 
+ */
+struct table_arenas_t {
+    struct arena_t entries;
+    struct arena_t words;
+    struct table_arenas_t* next;
+} __attribute__((aligned(64)));
 
-    pthread_rwlock_rdlock(&hash_table_lock);
+static struct table_arenas_t* table_arenas = NULL;
 
-    while (entry) {
-        if (strings_match(word, entry->word)) {
-            break;
-        }
+static __thread struct table_arenas_t* thread_arenas = NULL;
 
-        entry = entry->next;
+__attribute__((returns_nonnull))
+static struct table_arenas_t* get_thread_arenas(void) {
+    if (thread_arenas) {
+        return thread_arenas;
     }
 
-    pthread_rwlock_unlock(&hash_table_lock);
+    struct table_arenas_t* arenas = NULL;
 
-    return entry;
+    if (posix_memalign((void **) &arenas, sizeof (struct table_arenas_t), sizeof (struct table_arenas_t))) {
+        fatal_error("Memory allocation failure in get_thread_arenas()");
+    }
+
+    initialize_arena(&arenas->entries, ARENA_BLOCK_SIZE);
+    initialize_arena(&arenas->words, ARENA_BLOCK_SIZE);
+
+    arenas->next = __atomic_load_n(&table_arenas, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&table_arenas, &arenas->next, arenas, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        /** A failed exchange has already reloaded the head of the list into
+         *  arenas->next, so there is nothing to do but try again.
+         * 
+         */
+    }
+
+    thread_arenas = arenas;
+
+    return arenas;
 }
 
-/** Each entry in the hash table has a reader-writer lock for data coherence.
- *  The benefit of the reader-writer lock over a simple mutex is that multiple
- *  threads can hold a read lock, minimizing the need for write locks, as they
- *  are the real bottleneck of the operation.
+/** This function initializes a new table entry. The word counts are
+ *  initialized by being set to zero, and a deep copy of the string is made, as
+ *  the input buffer in the process_file function will be rewritten once it has
+ *  been fully processed. The entry comes out of the calling thread's entry
+ *  arena. A short word is copied into the entry itself, straight from the
+ *  key's inline copy, and only a long word gets a copy in the word arena.
+ * 
+ *  In locked mode, the table entry's reader-writer lock must be dynamically
+ *  initialized by calling pthread_rwlock_init, passing the lock by reference,
+ *  along with the reader-writer lock attributes. At the moment, these
+ *  attributes are being left as the default, specified with NULL. The lock is
+ *  never explicitly destroyed, since the arena holding it is freed wholesale;
+ *  with the default attributes, destroying a reader-writer lock releases no
+ *  resources anyway.
  * 
  */
-static inline void increment_reference_count(struct table_entry_t* entry, int file) {
-    pthread_rwlock_wrlock(&entry->lock);
+__attribute__((nonnull(1), returns_nonnull))
+static struct table_entry_t* create_table_entry(const struct table_key_t* key) {
+    struct table_arenas_t* arenas = get_thread_arenas();
 
-    if (file == 1) {
-        ++entry->count1;
-    } else if (file == 2) {
-        ++entry->count2;
+    struct table_entry_t* entry = arena_allocate(&arenas->entries, table_entry_size, __alignof__ (struct table_entry_t));
+
+    entry->hash   = key->hash;
+    entry->length = key->length;
+
+    entry->inline_word[0] = key->inline_word[0];
+    entry->inline_word[1] = key->inline_word[1];
+
+    if (key->length < INLINE_WORD_SIZE) {
+        entry->word = (char *) entry->inline_word;
     } else {
-        fatal_error("Invalid file number");
+        entry->word = arena_allocate(&arenas->words, key->length + 1, 1);
+        memcpy(entry->word, key->word, key->length);
+        entry->word[key->length] = NUL;
+    }
+
+    memset(entry->counts, 0, number_of_inputs * sizeof (size_t));
+
+    count_new_entry();
+
+    /** Only entries in locked mode have a lock to initialize. Entries in
+     *  lock-free mode are only ever updated atomically, and the others only
+     *  ever by a single thread.
+     * 
+     */
+    if ((table_mode == TABLE_LOCKED) && pthread_rwlock_init(entry_lock(entry), NULL)) {
+        fatal_error("Failed to dynamically initialize entry mutex");
     }
 
-    pthread_rwlock_unlock(&entry->lock);
+    return entry;
 }
 
-/** The commonality score calculation has been modified to accept a function
- *  pointer, allowing for the customization of program operation down the line.
- *  I'm not actively working on this at the moment, but it is a possibility.
+/** These two functions compare a group of sixteen control bytes against a
+ *  given byte, returning a bitmask with bit i set if control byte i matched.
+ *  With SSE2 available this is a single compare and movemask; otherwise the
+ *  bytes are simply compared one at a time.
  * 
- *  The formula has been changed to the harmonic mean of the string counts in
- *  the input files rather than the geometric mean. I initially thought
- *  filtering zero values from the calculation would be much more involved, but
- *  I simply set the calculation to be contingent on nonzero counts in both
- *  input files, and the division by zero problem has been completely avoided.
+ *  In lock-free mode, a probe may load a group of control bytes while another
+ *  thread is setting one of them. That race is accepted: a byte is only ever
+ *  written whole, and a probe that sees the old value of a byte was already
+ *  something 'find_or_insert_word' had to allow for, since the slot pointer is
+ *  what it trusts. Copying the group out with atomic loads instead was tried,
+ *  and it cost the lock-free mode over half again its running time, so these
+ *  two functions are instead kept out of ThreadSanitizer's instrumentation.
+ *  That way the rest of the mode can still be checked with -fsanitize=thread
+ *  without this one known race drowning out everything else it reports.
  * 
  */
-static inline void calculate_commonality_score(struct table_entry_t* entry) {
-    double entry_commonality_score = commonality(entry, harmonic_mean);
+__attribute__((hot, nonnull(1), no_sanitize_thread))
+static inline unsigned int match_control_group(const control_t* group, control_t value) {
+#if defined(__SSE2__)
+    __m128i control = _mm_loadu_si128((const __m128i *) group);
 
-    pthread_mutex_lock(&max_lock);
+    return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value)));
+#else
+    unsigned int mask = 0;
 
-    if (entry_commonality_score > current_max) {
-        current_max = entry_commonality_score;
-        most_common_word = entry->word;
+    for (unsigned int i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= (unsigned int) (group[i] == value) << i;
     }
 
-    pthread_mutex_unlock(&max_lock);
+    return mask;
+#endif // __SSE2__
 }
 
-/** This is where most of the magic happens. The bulk of the application is
- *  building the hash table which will result in us being able to give the user
- *  an answer when the application has finished executing. This function takes
- *  care of adding new entries to the hash table as we encounter them, as well
- *  as incrementing reference counts if the given entry already exists in the
- *  hash table. The file integer is what allows for the distinction between
- *  files 1 and 2.
+__attribute__((hot, nonnull(1), no_sanitize_thread))
+unsigned int match_empty_slots(const control_t* group) {
+    return match_control_group(group, CONTROL_EMPTY);
+}
+
+/** The home slot of a hash is given by its top bits, and its control byte by
+ *  its bottom seven bits. Using opposite ends of the hash for the two means a
+ *  control byte match among slots near the home slot is still a useful filter.
+ * 
+ *  A table only ever holding hashes from one of several equal ranges has its
+ *  scale set to the number of ranges. Every hash in the range has the same top
+ *  bits, but multiplying by the scale discards exactly those, leaving the
+ *  position of the hash within its range to spread out over the whole table.
  * 
  */
-__attribute__((nonnull(1), returns_nonnull))
-struct table_entry_t* add_word_to_table(const char* word, int file) {
-    /** Look up the word in the table by passing in the 'word' string to the
-     *  lookup_word function. 'lookup_word' handles hashing the word and
-     *  determining whether the entry is in the hash table. If it isn't, the
-     *  return value will be a NULL pointer.
-     * 
-     */
-    struct table_entry_t* entry = lookup_word(word);
+__attribute__((hot, pure, nonnull(1)))
+size_t home_slot(const struct hash_table_t* table, hash_t hash) {
+    return (size_t) ((hash * table->scale) >> table->shift);
+}
 
-    /** Having determined that the entry is not already in the hash table, we
-     *  must add it now. The create_table_entry takes care of allocating an
-     *  entry struct, deep-copying in the word string, and return the pointer
-     *  to the entry.
-     * 
-     *  Prior to modifying the hash table pointers, we lock the hash_table_lock
-     *  mutex to prevent modifications to the same memory by two different
-     *  threads, corrupting the data.
-     * 
-     */
-    if (entry == NULL) {
-        entry = create_table_entry(word);
+__attribute__((hot, const))
+control_t control_byte(hash_t hash) {
+    return (control_t) (hash & 0x7f);
+}
 
-        pthread_rwlock_wrlock(&hash_table_lock);
-        size_t hashval = calculate_hash(entry->word);
-        entry->next = hash_table[hashval];
-        hash_table[hashval] = entry;
-        pthread_rwlock_unlock(&hash_table_lock);
+/** Setting a control byte also has to update its mirror past the end of the
+ *  array if the slot is in the first group, otherwise groups loaded from the
+ *  last few slots in the table would see stale values.
+ * 
+ */
+__attribute__((nonnull(1)))
+void set_control_byte(struct hash_table_t* table, size_t slot, control_t value) {
+    __atomic_store_n(&table->control[slot], value, __ATOMIC_RELEASE);
+
+    if (slot < GROUP_WIDTH) {
+        __atomic_store_n(&table->control[table->capacity + slot], value, __ATOMIC_RELEASE);
     }
+}
 
-    increment_reference_count(entry, file);
+/** A key matches an entry if their hashes and lengths agree, and only then are
+ *  the words themselves compared. Short words are compared as two 64-bit
+ *  halves, straight out of the entry and the key, with no branch on where they
+ *  differ. Only long words are compared byte for byte, and since the lengths
+ *  are already known to be equal, that is a plain 'memcmp'.
+ * 
+ */
+__attribute__((hot, nonnull(1,2)))
+static inline int entry_matches_key(const struct table_entry_t* entry, const struct table_key_t* key) {
+    if ((entry->hash != key->hash) || (entry->length != key->length)) {
+        return FALSE;
+    }
 
-    calculate_commonality_score(entry);
+    if (key->length < INLINE_WORD_SIZE) {
+        return ((entry->inline_word[0] ^ key->inline_word[0]) | (entry->inline_word[1] ^ key->inline_word[1])) == 0;
+    }
 
-    return entry;
+    return memcmp(entry->word, key->word, key->length) == 0;
 }
 
-void release_table_resources(void) {
-    for (size_t i = 0; i < HASH_MODULUS; ++i) {
-        struct table_entry_t* entry = hash_table[i];
+/** This function probes the table for the given word, returning the slot it
+ *  occupies if it is present. If it isn't, the return value is the empty slot
+ *  where it would be inserted, and 'found' is set to FALSE.
+ * 
+ *  Each iteration examines a full group of control bytes. Every slot whose
+ *  control byte matches the bottom seven bits of the hash is a candidate, and
+ *  only those candidates have their full hash and word compared. The first
+ *  empty slot in the group ends the probe.
+ * 
+ */
+__attribute__((hot, nonnull(1,2,3)))
+size_t probe_table(const struct hash_table_t* table, const struct table_key_t* key, int* found) {
+    const control_t tag = control_byte(key->hash);
+
+    size_t position = home_slot(table, key->hash);
+
+    while (TRUE) {
+        const control_t* group = table->control + position;
 
-        while (entry) {
-            struct table_entry_t* next = NULL;
+        unsigned int matches = match_control_group(group, tag);
 
-            if (entry->next) {
-                next = entry->next;
+        while (matches) {
+            size_t slot = (position + __builtin_ctz(matches)) & table->mask;
+            struct table_entry_t* entry = table->slots[slot];
+
+            if (entry_matches_key(entry, key)) {
+                *found = TRUE;
+                return slot;
             }
 
-            pthread_rwlock_destroy(&entry->lock);
+            matches &= matches - 1;
+        }
+
+        unsigned int empty = match_empty_slots(group);
+
+        if (empty) {
+            *found = FALSE;
+            return (position + __builtin_ctz(empty)) & table->mask;
+        }
+
+        position = (position + GROUP_WIDTH) & table->mask;
+    }
+}
+
+/** This function allocates the control bytes and slots of a table with the
+ *  given capacity, which must be a power of two. Every control byte starts out
+ *  empty, including the mirrored group at the end.
+ * 
+ */
+__attribute__((nonnull(1)))
+void allocate_table_storage(struct hash_table_t* table, size_t capacity) {
+    table->capacity     = capacity;
+    table->mask         = capacity - 1;
+    table->shift        = (unsigned int) (64 - __builtin_ctzll(capacity));
+    table->scale        = (table->scale) ? table->scale : 1;
+    table->size         = 0;
+    table->growth_limit = capacity - (capacity / 8);
+
+    table->control = malloc(capacity + GROUP_WIDTH);
+    table->slots   = calloc(capacity, sizeof (struct table_entry_t *));
+
+    if ((table->control == NULL) || (table->slots == NULL)) {
+        fatal_error("Memory allocation failure in allocate_table_storage()");
+    }
+
+    count_allocation(capacity + GROUP_WIDTH);
+    count_allocation(capacity * sizeof (struct table_entry_t *));
 
-            FREE(entry->word);
-            FREE(entry);
+    memset(table->control, CONTROL_EMPTY, capacity + GROUP_WIDTH);
+}
+
+/** This function rebuilds the table with the given capacity, reinserting every
+ *  entry at the first empty slot at or after its new home slot. Every entry is
+ *  known to be unique, so there is no need to compare any words. If 'rehash'
+ *  is set, every entry's hash is first recomputed with the table's seed, which
+ *  is how a new seed takes effect; otherwise the stored hashes are used as is.
+ * 
+ *  The return value is the total distance, in slots, between every entry and
+ *  its home slot, which is what the table's probe lengths are judged by.
+ * 
+ */
+__attribute__((nonnull(1)))
+static size_t rebuild_table(struct hash_table_t* table, size_t capacity, int rehash) {
+    struct hash_table_t old_table = *table;
+
+    allocate_table_storage(table, capacity);
+
+    size_t total_displacement = 0;
+
+    for (size_t i = 0; i < old_table.capacity; ++i) {
+        struct table_entry_t* entry = old_table.slots[i];
+
+        if (entry == NULL) {
+            continue;
+        }
+
+        if (rehash) {
+            entry->hash = calculate_hash(entry->word, entry->length, table->seed);
+        }
+
+        const size_t home = home_slot(table, entry->hash);
+
+        size_t position = home;
+
+        while (TRUE) {
+            unsigned int empty = match_empty_slots(table->control + position);
 
-            entry = next;
+            if (empty) {
+                size_t slot = (position + __builtin_ctz(empty)) & table->mask;
+
+                set_control_byte(table, slot, control_byte(entry->hash));
+                table->slots[slot] = entry;
+
+                total_displacement += (slot - home) & table->mask;
+                break;
+            }
+
+            position = (position + GROUP_WIDTH) & table->mask;
         }
     }
+
+    table->size = old_table.size;
+
+    FREE(old_table.control);
+    FREE(old_table.slots);
+
+    return total_displacement;
+}
+
+/** This function picks a new seed for the table and rehashes every entry in it
+ *  without changing its capacity. The new seed is derived from the old one, so
+ *  it is just as unpredictable. A table may only be reseeded once until it next
+ *  grows, which keeps an input that no seed can help, such as one made of
+ *  words whose unmixed hashes collide outright, from rehashing it on every
+ *  single insertion.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void reseed_table(struct hash_table_t* table) {
+    __atomic_store_n(&table->seed, mix_hash(table->seed + 0x9e3779b97f4a7c15ULL), __ATOMIC_RELAXED);
+
+    rebuild_table(table, table->capacity, TRUE);
+
+    table->reseeded_capacity = table->capacity;
+
+    __atomic_fetch_add(&number_of_reseeds, 1, __ATOMIC_RELAXED);
 }
 
-#if defined(HASH_MODULUS)
-#undef HASH_MODULUS
+/** Once the table reaches seven-eighths of its capacity, it is rebuilt with
+ *  twice as many slots. Since the entries store their full hash, rebuilding
+ *  the table only moves pointers around; no word is ever hashed twice, unless
+ *  the rebuilt table's probe lengths turn out to be so poor that it is worth
+ *  reseeding it then and there.
+ * 
+ */
+__attribute__((nonnull(1)))
+void grow_table(struct hash_table_t* table) {
+    size_t total_displacement = rebuild_table(table, (table->capacity) ? table->capacity * 2 : TABLE_INITIAL_CAPACITY, FALSE);
+
+    if (table->reseedable && (total_displacement > table->size * MEAN_PROBE_LENGTH_LIMIT)) {
+        reseed_table(table);
+    }
+}
+
+/** This function decides whether an insertion into the given slot probed so
+ *  far past the key's home slot that the table ought to be reseeded, which is
+ *  only ever the case if the table is allowed to reseed at its capacity.
+ * 
+ */
+__attribute__((hot, pure, nonnull(1)))
+static inline int probe_too_long(const struct hash_table_t* table, hash_t hash, size_t slot) {
+    return (((slot - home_slot(table, hash)) & table->mask) > PROBE_LENGTH_LIMIT) && table->reseedable && (table->reseeded_capacity != table->capacity);
+}
+
+/** This function takes care of hashing the current string and returning the
+ *  entry for it, if there is one. Probing the table only requires holding the
+ *  table lock in read mode, since the only thing that can change the table out
+ *  from under us is another thread inserting a new word.
+ * 
+ */
+__attribute__((nonnull(1)))
+static struct table_entry_t* lookup_word(struct table_key_t* key) {
+    struct table_entry_t* entry = NULL;
+
+    timed_rwlock_rdlock(&hash_table_lock, LOCK_TABLE);
+
+    if (hash_table.capacity) {
+        int found = FALSE;
+
+        refresh_key(&hash_table, key);
+
+        size_t slot = probe_table(&hash_table, key, &found);
+
+        if (found) {
+            entry = hash_table.slots[slot];
+        }
+    }
+
+    pthread_rwlock_unlock(&hash_table_lock);
+
+    return entry;
+}
+
+/** This function adds a new entry for the given word, unless another thread
+ *  beat us to it in the window between our lookup and acquiring the write lock,
+ *  in which case that thread's entry is returned instead. The table is grown
+ *  beforehand if this insertion would take it past its maximum load factor,
+ *  and reseeded if the word would land too far from its home slot.
+ * 
+ */
+__attribute__((nonnull(1), returns_nonnull))
+static struct table_entry_t* insert_word(struct table_key_t* key) {
+    timed_rwlock_wrlock(&hash_table_lock, LOCK_TABLE);
+
+    if (hash_table.size + 1 > hash_table.growth_limit) {
+        grow_table(&hash_table);
+    }
+
+    refresh_key(&hash_table, key);
+
+    int found = FALSE;
+
+    size_t slot = probe_table(&hash_table, key, &found);
+
+    if ((found == FALSE) && probe_too_long(&hash_table, key->hash, slot)) {
+        reseed_table(&hash_table);
+        refresh_key(&hash_table, key);
+        slot = probe_table(&hash_table, key, &found);
+    }
+
+    if (found == FALSE) {
+        set_control_byte(&hash_table, slot, control_byte(key->hash));
+        hash_table.slots[slot] = create_table_entry(key);
+        ++hash_table.size;
+    }
+
+    struct table_entry_t* entry = hash_table.slots[slot];
+
+    pthread_rwlock_unlock(&hash_table_lock);
+
+    return entry;
+}
+
+/** These two functions delimit the stretches of time during which a thread may
+ *  access the table in lock-free mode, which is to say while it processes a
+ *  single buffer of input. A thread is assigned its own access lock, or in
+ *  local mode its own table, the first time it calls 'begin_table_access'. In
+ *  partitioned mode, 'end_table_access' is where a thread counts the words it
+ *  has been sent. In locked mode, neither function does anything at all.
+ * 
+ */
+void begin_table_access(void) {
+    if ((table_mode == TABLE_LOCKED) && (combine_mode == FALSE)) {
+        return;
+    }
+
+    if (table_thread_index == -1) {
+        table_thread_index = __atomic_fetch_add(&registered_table_threads, 1, __ATOMIC_RELAXED);
+
+        if (table_thread_index >= number_of_table_threads) {
+            fatal_error("More threads accessed the table than it was initialized for");
+        }
+
+        if (table_mode == TABLE_LOCAL) {
+            local_table = claim_local_table(table_thread_index, initial_seed);
+        }
+
+        if (table_mode == TABLE_PARTITIONED) {
+            partition_worker = claim_partition_worker(table_thread_index);
+        }
+
+        if (combine_mode) {
+            combining_cache = claim_combining_cache(table_thread_index);
+        }
+    }
+
+    if (table_mode == TABLE_LOCKFREE) {
+        timed_mutex_lock(&table_access_locks[table_thread_index].lock, LOCK_ACCESS);
+    }
+}
+
+void end_table_access(void) {
+    if (combining_cache) {
+        flush_combining_cache(combining_cache);
+    }
+
+    if (partition_worker) {
+        drain_partition_inbox(partition_worker);
+    }
+
+    if (table_mode != TABLE_LOCKFREE) {
+        return;
+    }
+
+    pthread_mutex_unlock(&table_access_locks[table_thread_index].lock);
+}
+
+/** A thread that finds the table full in lock-free mode gives up its own
+ *  access lock, then acquires every thread's access lock in order. Since every
+ *  thread acquires them in the same order, and a thread never waits on another
+ *  thread's access lock while holding its own, two threads trying to grow the
+ *  table at once cannot deadlock. Whichever thread gets there second finds the
+ *  table has already been grown and leaves it alone.
+ * 
+ *  The same goes for a thread that finds the table in need of a new seed,
+ *  which passes in the seed it saw. If the seed has changed by the time every
+ *  lock is held, another thread has already taken care of it.
+ * 
+ */
+static void grow_table_concurrently(hash_t seed) {
+    end_table_access();
+
+    for (int i = 0; i < number_of_access_locks; ++i) {
+        timed_mutex_lock(&table_access_locks[i].lock, LOCK_ACCESS);
+    }
+
+    if (hash_table.size >= hash_table.growth_limit) {
+        grow_table(&hash_table);
+    } else if ((hash_table.seed == seed) && (hash_table.reseeded_capacity != hash_table.capacity)) {
+        reseed_table(&hash_table);
+    }
+
+    for (int i = number_of_access_locks - 1; i >= 0; --i) {
+        pthread_mutex_unlock(&table_access_locks[i].lock);
+    }
+
+    begin_table_access();
+}
+
+/** This is the lock-free counterpart to 'lookup_word' and 'insert_word'. The
+ *  slot pointer, not the control byte, is the authority on whether a slot is
+ *  taken: a new entry is published by swapping it into an empty slot, and its
+ *  control byte is only written afterwards. A control byte that matches is
+ *  therefore always backed by an entry, but a control byte that says a slot is
+ *  empty may simply not have caught up yet, so every apparently empty slot
+ *  has its pointer checked before the probe gives up on it.
+ * 
+ *  If another thread publishes an entry into the slot we were about to take,
+ *  the probe starts over, since the other thread may well have been inserting
+ *  the same word. The entry we created is then either used in a later slot or,
+ *  if the other thread's entry turns out to be for our word, abandoned in its
+ *  block. That only happens when two threads see a new word for the first
+ *  time at the same instant, so the memory lost to it is negligible.
+ * 
+ */
+__attribute__((hot, nonnull(1), returns_nonnull))
+static struct table_entry_t* find_or_insert_word(struct table_key_t* key) {
+    struct table_entry_t* new_entry = NULL;
+
+    while (TRUE) {
+        const control_t tag = control_byte(key->hash);
+
+        size_t position = home_slot(&hash_table, key->hash);
+        size_t empty_slot = 0;
+
+        while (TRUE) {
+            const control_t* group = hash_table.control + position;
+
+            unsigned int matches = match_control_group(group, tag);
+
+            while (matches) {
+                size_t slot = (position + __builtin_ctz(matches)) & hash_table.mask;
+                struct table_entry_t* entry = __atomic_load_n(&hash_table.slots[slot], __ATOMIC_ACQUIRE);
+
+                if (entry_matches_key(entry, key)) {
+                    return entry;
+                }
+
+                matches &= matches - 1;
+            }
+
+            unsigned int empty = match_empty_slots(group);
+
+            while (empty) {
+                size_t slot = (position + __builtin_ctz(empty)) & hash_table.mask;
+                struct table_entry_t* entry = __atomic_load_n(&hash_table.slots[slot], __ATOMIC_ACQUIRE);
+
+                if (entry == NULL) {
+                    break;
+                }
+
+                if (entry_matches_key(entry, key)) {
+                    return entry;
+                }
+
+                empty &= empty - 1;
+            }
+
+            if (empty) {
+                empty_slot = (position + __builtin_ctz(empty)) & hash_table.mask;
+                break;
+            }
+
+            position = (position + GROUP_WIDTH) & hash_table.mask;
+        }
+
+        if ((__atomic_load_n(&hash_table.size, __ATOMIC_RELAXED) >= hash_table.growth_limit) || probe_too_long(&hash_table, key->hash, empty_slot)) {
+            grow_table_concurrently(key->seed);
+            refresh_key(&hash_table, key);
+            continue;
+        }
+
+        /** An entry created before the table was reseeded carries the hash
+         *  for the old seed, so it is brought up to date before it is used.
+         * 
+         */
+        if (new_entry == NULL) {
+            new_entry = create_table_entry(key);
+        } else {
+            new_entry->hash = key->hash;
+        }
+
+        struct table_entry_t* expected = NULL;
+
+        if (__atomic_compare_exchange_n(&hash_table.slots[empty_slot], &expected, new_entry, FALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            set_control_byte(&hash_table, empty_slot, tag);
+            __atomic_fetch_add(&hash_table.size, 1, __ATOMIC_RELAXED);
+            return new_entry;
+        }
+    }
+}
+
+/** In local mode the table belongs to the calling thread alone, so this is
+ *  simply the combination of 'lookup_word' and 'insert_word' without the locks.
+ * 
+ */
+__attribute__((hot, nonnull(1,2), returns_nonnull))
+struct table_entry_t* find_or_insert_local_word(struct hash_table_t* table, struct table_key_t* key) {
+    int found = FALSE;
+
+    size_t slot = probe_table(table, key, &found);
+
+    if (found) {
+        return table->slots[slot];
+    }
+
+    if (table->size + 1 > table->growth_limit) {
+        grow_table(table);
+        refresh_key(table, key);
+        slot = probe_table(table, key, &found);
+    }
+
+    if (probe_too_long(table, key->hash, slot)) {
+        reseed_table(table);
+        refresh_key(table, key);
+        slot = probe_table(table, key, &found);
+    }
+
+    set_control_byte(table, slot, control_byte(key->hash));
+    table->slots[slot] = create_table_entry(key);
+    ++table->size;
+
+    return table->slots[slot];
+}
+
+/** Files are numbered from one, and each file's count is at the matching
+ *  index of the count vector, less one.
+ * 
+ */
+__attribute__((hot))
+size_t count_index(int file) {
+    if ((file < 1) || ((size_t) file > number_of_inputs)) {
+        fatal_error("Invalid file number");
+    }
+
+    return (size_t) file - 1;
+}
+
+/** Each entry in the hash table has a reader-writer lock for data coherence.
+ *  The benefit of the reader-writer lock over a simple mutex is that multiple
+ *  threads can hold a read lock, minimizing the need for write locks, as they
+ *  are the real bottleneck of the operation.
+ * 
+ */
+static inline void increment_reference_count(struct table_entry_t* entry, int file) {
+    timed_rwlock_wrlock(entry_lock(entry), LOCK_ENTRY);
+
+    ++entry->counts[count_index(file)];
+
+    pthread_rwlock_unlock(entry_lock(entry));
+}
+
+/** This function scores an entry with whichever metric '--metric' chose,
+ *  through the metric function picked out of the table of them when the table
+ *  was initialized, and makes the entry the running maximum if it beats it.
+ *  It is only ever called in the live winner mode, which is also the only
+ *  time the max lock is ever taken.
+ * 
+ *  The harmonic mean is the default. Every metric is contingent on nonzero
+ *  counts in every input file, so a word missing from any of them scores zero
+ *  without the harmonic mean ever dividing by zero.
+ * 
+ */
+static inline void calculate_commonality_score(struct table_entry_t* entry) {
+    double entry_commonality_score = commonality(entry);
+
+    timed_mutex_lock(&max_lock, LOCK_MAX);
+
+    if (entry_commonality_score > current_max) {
+        current_max = entry_commonality_score;
+        most_common_word = entry->word;
+    }
+
+    pthread_mutex_unlock(&max_lock);
+}
+
+/** In lock-free mode the counts are bumped with a single atomic add, and
+ *  nothing else about the entry is touched.
+ * 
+ */
+static inline void atomically_increment_reference_count(struct table_entry_t* entry, int file) {
+    __atomic_fetch_add(&entry->counts[count_index(file)], 1, __ATOMIC_RELAXED);
+}
+
+/** This function adds a word's pending count from a combining cache to its
+ *  entry all at once, the same way a single count would have been added in
+ *  the current table mode, running maximum and all.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+void add_reference_counts(struct table_entry_t* entry, int file, size_t count) {
+    if (table_mode == TABLE_LOCKFREE) {
+        __atomic_fetch_add(&entry->counts[count_index(file)], count, __ATOMIC_RELAXED);
+        return;
+    }
+
+    timed_rwlock_wrlock(entry_lock(entry), LOCK_ENTRY);
+
+    entry->counts[count_index(file)] += count;
+
+    pthread_rwlock_unlock(entry_lock(entry));
+
+    if (winner_mode == WINNER_LIVE) {
+        calculate_commonality_score(entry);
+    }
+}
+
+/** This function finds or inserts a word in the shared table without adding a
+ *  count to its entry, which is what a combining cache needs on a miss. In
+ *  lock-free mode, that takes no locks at all, and in locked mode, it is the
+ *  usual lookup, followed by an insertion if the word wasn't there.
+ * 
+ */
+__attribute__((hot, nonnull(1), returns_nonnull))
+struct table_entry_t* find_or_insert_shared_word(struct table_key_t* key) {
+    if (table_mode == TABLE_LOCKFREE) {
+        return find_or_insert_word(key);
+    }
+
+    struct table_entry_t* entry = lookup_word(key);
+
+    return (entry) ? entry : insert_word(key);
+}
+
+/** Once every scanning thread's selection has been merged into the final one,
+ *  it is sorted from the highest rank down, which only takes O(K log K), and
+ *  its first entry is the most common word.
+ * 
+ */
+static void publish_top_words(void) {
+    sort_selection(&top_words);
+
+    if (top_words.size) {
+        current_max = top_words.entries[0].score;
+        most_common_word = top_words.entries[0].entry->word;
+    }
+}
+
+/** This is the state of a single thread scanning one range of slots in the
+ *  shared table for its best entries, and if the matrix was asked for, the
+ *  best entry for every pair of files. Each sits on its own cache line, since
+ *  the selection is written to every time it changes.
+ * 
+ */
+struct scan_range_t {
+    const struct hash_table_t* table;
+    size_t first_slot;
+    size_t last_slot;
+    int find_words;
+    struct selection_t selection;
+    struct scored_entry_t* pairs;
+} __attribute__((aligned(64)));
+
+__attribute__((nonnull(1)))
+static void* scan_range_thread(void* arg) {
+    struct scan_range_t* scan = (struct scan_range_t *) arg;
+
+    if (scan->find_words) {
+        find_best_entries(scan->table, scan->first_slot, scan->last_slot, &scan->selection);
+    }
+
+    if (scan->pairs) {
+        find_best_pairs(scan->table, scan->first_slot, scan->last_slot, scan->pairs);
+    }
+
+    return NULL;
+}
+
+/** This function finds the most common words in the given tables with a
+ *  parallel reduction. The threads are divided evenly among the tables, and
+ *  each table's slots are split into one contiguous range per thread, rounded
+ *  to whole groups. Each thread finds the best entries in its range, and the
+ *  best of those are the most common words. The first scan simply happens on
+ *  the calling thread. The pair matrix, if it was asked for, is found in the
+ *  same pass, and reduced the same way, one cell at a time.
+ * 
+ *  There is usually just the one shared table, but in join mode, the merged
+ *  tables of local mode have to be scanned all over again once the larger
+ *  input has been counted into them, and in local mode, the merged tables
+ *  have to be scanned for the pair matrix, since merging them only finds the
+ *  most common words.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void scan_tables(const struct hash_table_t* tables, size_t number_of_tables, int find_words, int find_pairs) {
+    size_t scans_per_table = (size_t) settings_get_threads() / number_of_tables;
+
+    if (scans_per_table < 1) {
+        scans_per_table = 1;
+    }
+
+    size_t number_of_scans = 0;
+
+    for (size_t t = 0; t < number_of_tables; ++t) {
+        number_of_scans += MIN(scans_per_table, tables[t].capacity / GROUP_WIDTH);
+    }
+
+    if (number_of_scans == 0) {
+        return;
+    }
+
+    struct scan_range_t* scans = NULL;
+
+    if (posix_memalign((void **) &scans, sizeof (struct scan_range_t), number_of_scans * sizeof (struct scan_range_t))) {
+        fatal_error("Memory allocation failure in scan_tables()");
+    }
+
+    pthread_t* threads = malloc(number_of_scans * sizeof (pthread_t));
+
+    if (threads == NULL) {
+        fatal_error("Memory allocation failure in scan_tables()");
+    }
+
+    size_t i = 0;
+
+    for (size_t t = 0; t < number_of_tables; ++t) {
+        const size_t groups = tables[t].capacity / GROUP_WIDTH;
+        const size_t ranges = MIN(scans_per_table, groups);
+
+        for (size_t r = 0; r < ranges; ++r, ++i) {
+            scans[i].table      = &tables[t];
+            scans[i].first_slot = (groups * r / ranges) * GROUP_WIDTH;
+            scans[i].last_slot  = (groups * (r + 1) / ranges) * GROUP_WIDTH;
+            scans[i].find_words = find_words;
+            scans[i].pairs      = (find_pairs) ? allocate_pair_matrix() : NULL;
+
+            initialize_selection(&scans[i].selection, top_words.capacity);
+
+            if ((i > 0) && pthread_create(&threads[i], NULL, scan_range_thread, &scans[i])) {
+                fatal_error("Could not create scan thread");
+            }
+        }
+    }
+
+    scan_range_thread(&scans[0]);
+
+    for (size_t i = 0; i < number_of_scans; ++i) {
+        if ((i > 0) && pthread_join(threads[i], NULL)) {
+            fatal_error("Could not rejoin scan threads");
+        }
+
+        merge_selection(&top_words, &scans[i].selection);
+        release_selection(&scans[i].selection);
+
+        if (scans[i].pairs) {
+            merge_pair_matrix(scans[i].pairs);
+
+            FREE(scans[i].pairs);
+        }
+    }
+
+    if (find_words) {
+        publish_top_words();
+    }
+
+    FREE(threads);
+    FREE(scans);
+}
+
+/** This is where most of the magic happens. The bulk of the application is
+ *  building the hash table which will result in us being able to give the user
+ *  an answer when the application has finished executing. This function takes
+ *  care of adding new entries to the hash table as we encounter them, as well
+ *  as incrementing reference counts if the given entry already exists in the
+ *  hash table. The file integer is what allows for the distinction between
+ *  the files, which are numbered from one.
+ * 
+ *  The word is given by its length rather than by a NUL terminator, so that
+ *  tokens can be added straight out of the input buffer.
+ * 
+ */
+__attribute__((nonnull(1)))
+struct table_entry_t* add_word_to_table(const char* word, size_t length, int file) {
+    /** In partitioned mode, the word is only hashed and sent off to the owner
+     *  of its partition, so it has no entry to return yet.
+     * 
+     */
+    if (table_mode == TABLE_PARTITIONED) {
+        const struct table_key_t key = create_table_key(word, length, initial_seed);
+
+        scatter_word(partition_worker, &key, file);
+
+        return NULL;
+    }
+
+    /** The word is hashed exactly once, here, with the seed of the table it
+     *  is going into, and the hash is carried along in the key into both the
+     *  lookup and, if necessary, the new entry itself. It is only ever hashed
+     *  again if the table happens to be reseeded in the meantime.
+     * 
+     */
+    const struct hash_table_t* table = (table_mode == TABLE_LOCAL) ? local_table : &hash_table;
+
+    struct table_key_t key = create_table_key(word, length, __atomic_load_n(&table->seed, __ATOMIC_RELAXED));
+
+    /** In local mode, the word goes into the calling thread's own table, and
+     *  nothing about it needs to be synchronized in any way.
+     * 
+     */
+    if (table_mode == TABLE_LOCAL) {
+        struct table_entry_t* entry = find_or_insert_local_word(local_table, &key);
+
+        ++entry->counts[count_index(file)];
+
+        return entry;
+    }
+
+    /** With a combining cache, short words are counted through the cache, in
+     *  either of the other two modes, and only reach the table in batches.
+     * 
+     */
+    if (combining_cache && (key.length < INLINE_WORD_SIZE)) {
+        return combine_word(combining_cache, &key, file);
+    }
+
+    /** The lock-free path is entirely separate. Finding or inserting the entry
+     *  takes no locks, the count is bumped atomically, and the running maximum
+     *  is left alone altogether.
+     * 
+     */
+    if (table_mode == TABLE_LOCKFREE) {
+        struct table_entry_t* entry = find_or_insert_word(&key);
+
+        atomically_increment_reference_count(entry, file);
+
+        return entry;
+    }
+
+    /** Look up the word in the table by passing in the 'word' string to the
+     *  lookup_word function. 'lookup_word' handles determining whether the
+     *  entry is in the hash table. If it isn't, the return value will be a
+     *  NULL pointer.
+     * 
+     */
+    struct table_entry_t* entry = lookup_word(&key);
+
+    /** Having determined that the entry is not already in the hash table, we
+     *  must add it now. The insert_word function takes care of locking the
+     *  table in write mode, growing it if need be, and creating the entry.
+     * 
+     */
+    if (entry == NULL) {
+        entry = insert_word(&key);
+    }
+
+    increment_reference_count(entry, file);
+
+    /** Only in live winner mode is the running maximum kept up to date as the
+     *  words are counted. Otherwise, the most common word is found once every
+     *  thread has finished, which keeps every thread off the global mutex.
+     * 
+     */
+    if (winner_mode == WINNER_LIVE) {
+        calculate_commonality_score(entry);
+    }
+
+    return entry;
+}
+
+/** Once the table is sealed, nothing can change it but the counts in its
+ *  entries, so probing it needs no lock of any kind, in any mode. A word that
+ *  isn't already in the table is simply dropped, without ever allocating
+ *  anything for it. The count itself is bumped atomically, since any number of
+ *  threads may be probing for the same word at once.
+ * 
+ *  In local and partitioned mode, the sealed table is really the set of merged
+ *  tables, each holding one range of hash values, so the word's hash picks
+ *  the table. They all share the initial seed, which is also the one the
+ *  merge used.
+ * 
+ */
+__attribute__((nonnull(1)))
+struct table_entry_t* count_word_in_table(const char* word, size_t length, int file) {
+    const struct hash_table_t* table = (merged_tables) ? merged_tables : &hash_table;
+
+    const struct table_key_t key = create_table_key(word, length, table->seed);
+
+    if (merged_tables) {
+        table = &merged_tables[hash_range(key.hash, number_of_merged_tables)];
+    }
+
+    int found = FALSE;
+
+    size_t slot = probe_table(table, &key, &found);
+
+    if (found == FALSE) {
+        return NULL;
+    }
+
+    struct table_entry_t* entry = table->slots[slot];
+
+    atomically_increment_reference_count(entry, file);
+
+    return entry;
+}
+
+/** In local and partitioned mode, the words are only all in the merged tables
+ *  once the local tables have been merged, or the partitions counted in full,
+ *  which also finds the most common words, unless this is join mode, where the
+ *  counts are only half done.
+ * 
+ */
+static void complete_private_tables(void) {
+    if (table_mode == TABLE_LOCAL) {
+        merged_tables = merge_local_tables(initial_seed, &top_words, join_mode == FALSE, &number_of_merged_tables);
+    } else {
+        drain_partitions(&top_words, join_mode == FALSE);
+    }
+
+    publish_top_words();
+}
+
+/** This function ends the build phase of join mode, once every thread adding
+ *  words to the table has been joined. Only local and partitioned mode have
+ *  any real work to do here, since their private tables have to be merged, or
+ *  their partitions counted in full, before every thread can probe them.
+ * 
+ */
+void seal_table(void) {
+    pthread_mutex_lock(&snapshot_lock);
+
+    if ((table_mode == TABLE_LOCAL) || (table_mode == TABLE_PARTITIONED)) {
+        complete_private_tables();
+    }
+
+    table_sealed = TRUE;
+
+    pthread_mutex_unlock(&snapshot_lock);
+}
+
+/** This function reports the statistics of the tables every thread can see,
+ *  which are the merged tables in local mode once they exist, and the shared
+ *  table in every other mode. The local tables themselves are never counted.
+ * 
+ */
+static void report_shared_table_statistics(void) {
+    if (merged_tables) {
+        report_table_statistics(merged_tables, number_of_merged_tables);
+    } else {
+        report_table_statistics(&hash_table, 1);
+    }
+}
+
+/** A snapshot reports the provisional leader and the table statistics while
+ *  the threads are still counting, without stopping any of them. What it takes
+ *  to look at the table safely in the meantime depends on the table mode.
+ * 
+ *  In locked mode, the snapshot holds the table lock in read mode, just as any
+ *  thread counting a word it has seen before does, so only the threads adding
+ *  new words wait for it. In lock-free mode, it holds the access lock set
+ *  aside for it, which only keeps the table from growing, and entries that are
+ *  being published as it scans are either seen or not. Local tables are never
+ *  looked at by anyone but their owners until they are merged, so until then
+ *  the snapshot makes do with how many entries each of them holds, and the
+ *  same goes for the partitions until every word has been counted. Once the
+ *  table is sealed, nothing about it changes but the counts, so there is
+ *  nothing to hold at all. In the live winner mode, the running maximum is
+ *  already the leader, and the table is not scanned for one.
+ * 
+ *  Every count is read while it may be being bumped, so the leader is only
+ *  ever provisional, which is all a snapshot can promise anyway.
+ * 
+ */
+void report_table_snapshot(void) {
+    pthread_mutex_lock(&snapshot_lock);
+
+    const int sealed = table_sealed;
+
+    if ((table_mode == TABLE_LOCAL) && !sealed) {
+        const size_t entries = local_table_entries();
+
+        fprintf(stderr, "Snapshot: %zu entries across %d local tables, no leader until they are merged\n", entries, number_of_table_threads);
+
+        pthread_mutex_unlock(&snapshot_lock);
+        return;
+    }
+
+    if ((table_mode == TABLE_PARTITIONED) && !sealed) {
+        size_t entries = 0;
+
+        for (size_t i = 0; i < number_of_merged_tables; ++i) {
+            entries += __atomic_load_n(&merged_tables[i].size, __ATOMIC_RELAXED);
+        }
+
+        fprintf(stderr, "Snapshot: %zu entries across %zu partitions, no leader until every word is counted\n", entries, number_of_merged_tables);
+
+        pthread_mutex_unlock(&snapshot_lock);
+        return;
+    }
+
+    if (!sealed && (table_mode == TABLE_LOCKED)) {
+        timed_rwlock_rdlock(&hash_table_lock, LOCK_TABLE);
+    } else if (!sealed && (table_mode == TABLE_LOCKFREE)) {
+        timed_mutex_lock(&table_access_locks[number_of_table_threads].lock, LOCK_ACCESS);
+    }
+
+    struct selection_t leader;
+
+    initialize_selection(&leader, 1);
+
+    if (winner_mode == WINNER_LIVE) {
+        timed_mutex_lock(&max_lock, LOCK_MAX);
+
+        if (most_common_word) {
+            fprintf(stderr, "Snapshot: leader %s (score %.3f)\n", most_common_word, current_max);
+        } else {
+            fprintf(stderr, "Snapshot: no shared word yet\n");
+        }
+
+        pthread_mutex_unlock(&max_lock);
+    } else {
+        if (merged_tables) {
+            for (size_t i = 0; i < number_of_merged_tables; ++i) {
+                find_best_entries(&merged_tables[i], 0, merged_tables[i].capacity, &leader);
+            }
+        } else {
+            find_best_entries(&hash_table, 0, hash_table.capacity, &leader);
+        }
+
+        if (leader.size) {
+            fprintf(stderr, "Snapshot: leader %s (score %.3f)\n", leader.entries[0].entry->word, leader.entries[0].score);
+        } else {
+            fprintf(stderr, "Snapshot: no shared word yet\n");
+        }
+    }
+
+    release_selection(&leader);
+
+    report_shared_table_statistics();
+
+    if (!sealed && (table_mode == TABLE_LOCKED)) {
+        pthread_rwlock_unlock(&hash_table_lock);
+    } else if (!sealed && (table_mode == TABLE_LOCKFREE)) {
+        pthread_mutex_unlock(&table_access_locks[number_of_table_threads].lock);
+    }
+
+    pthread_mutex_unlock(&snapshot_lock);
+}
+
+/** This function must be called once the settings are final, but before any
+ *  thread touches the table. It records the table mode and the hash function,
+ *  picks the initial seed, allocates one access lock per thread for lock-free
+ *  mode, plus the one for snapshots, and allocates the table's initial
+ *  storage, so that lock-free lookups never have to check for a table that
+ *  doesn't exist yet.
+ * 
+ */
+void initialize_table_resources(void) {
+    table_mode     = settings_get_table_mode();
+    winner_mode    = settings_get_winner_mode();
+    join_mode      = settings_get_join();
+    calculate_hash = hash_functions[settings_get_hash_algorithm()];
+
+    number_of_inputs = settings_get_number_of_inputs();
+    table_entry_size = sizeof (struct table_entry_t) + number_of_inputs * sizeof (size_t);
+
+    if (table_mode == TABLE_LOCKED) {
+        entry_lock_offset = (table_entry_size + __alignof__ (pthread_rwlock_t) - 1) & ~(__alignof__ (pthread_rwlock_t) - 1);
+        table_entry_size  = entry_lock_offset + sizeof (pthread_rwlock_t);
+    }
+
+    initialize_metric();
+    initialize_selection(&top_words, MAX(settings_get_top(), 1));
+
+    matrix_mode = settings_get_matrix();
+
+    if (matrix_mode) {
+        initialize_pair_matrix();
+    }
+
+    /** The kernel places sixteen random bytes in every new process' auxiliary
+     *  vector, which saves a system call to get a random seed. Should it not
+     *  be there for some reason, the seed falls back on the time.
+     * 
+     */
+    const unsigned char* random_bytes = (const unsigned char *) getauxval(AT_RANDOM);
+
+    if (random_bytes) {
+        memcpy(&initial_seed, random_bytes, sizeof (initial_seed));
+    } else {
+        initial_seed = mix_hash((hash_t) time(NULL));
+    }
+
+    hash_table.seed       = initial_seed;
+    hash_table.reseedable = TRUE;
+
+    if (table_mode == TABLE_LOCKFREE) {
+        number_of_table_threads = settings_get_threads();
+        number_of_access_locks  = number_of_table_threads + 1;
+
+        if (posix_memalign((void **) &table_access_locks, sizeof (struct table_access_lock_t), number_of_access_locks * sizeof (struct table_access_lock_t))) {
+            fatal_error("Memory allocation failure in initialize_table_resources()");
+        }
+
+        for (int i = 0; i < number_of_access_locks; ++i) {
+            if (pthread_mutex_init(&table_access_locks[i].lock, NULL)) {
+                fatal_error("Failed to initialize table access lock");
+            }
+        }
+    }
+
+    /** The local tables themselves are only allocated once a thread claims
+     *  one, so a thread that never sees any input costs nothing but the
+     *  header.
+     * 
+     */
+    if (table_mode == TABLE_LOCAL) {
+        number_of_table_threads = settings_get_threads();
+
+        initialize_local_tables(number_of_table_threads);
+
+        return;
+    }
+
+    /** The partition tables are set up here, all but their storage, which the
+     *  thread owning each one allocates once it has a word to count in it, so
+     *  that its slots are first touched by the thread that uses them.
+     * 
+     */
+    if (table_mode == TABLE_PARTITIONED) {
+        number_of_table_threads = settings_get_threads();
+
+        merged_tables = initialize_partitions(number_of_table_threads, initial_seed, &number_of_merged_tables);
+
+        return;
+    }
+
+    /** Neither local nor partitioned tables are ever shared to begin with, so
+     *  only the locked and lock-free modes have any use for combining caches,
+     *  and '--combine' is rejected in the others. In locked mode, the threads
+     *  then claim one through 'begin_table_access' just as they would an
+     *  access lock in lock-free mode.
+     * 
+     */
+    combine_mode = settings_get_combine();
+
+    if (combine_mode) {
+        number_of_table_threads = settings_get_threads();
+
+        initialize_combining_caches(number_of_table_threads);
+    }
+
+    allocate_table_storage(&hash_table, TABLE_INITIAL_CAPACITY);
+}
+
+/** This function must be called once every thread adding words to the table
+ *  has been joined. In local mode, it merges the threads' tables and finds the
+ *  most common word in the process. In the other modes, it scans the table for
+ *  the most common word, unless it was already kept track of live while the
+ *  table was being built, in which case there is nothing left to do. In join
+ *  mode, the local tables were already merged when the table was sealed, so
+ *  it is the merged tables that are scanned. Partitioned mode works just like
+ *  local mode, only its partitions are counted in full rather than merged.
+ * 
+ */
+void finalize_table_resources(void) {
+    if ((table_mode == TABLE_LOCAL) || (table_mode == TABLE_PARTITIONED)) {
+        if (table_sealed == FALSE) {
+            complete_private_tables();
+        }
+
+        if (join_mode || matrix_mode) {
+            scan_tables(merged_tables, number_of_merged_tables, join_mode, matrix_mode);
+        }
+    } else if ((winner_mode == WINNER_SCAN) || matrix_mode) {
+        scan_tables(&hash_table, 1, winner_mode == WINNER_SCAN, matrix_mode);
+    }
+
+    if (settings_get_verbose() || settings_get_stats()) {
+        report_shared_table_statistics();
+    }
+}
+
+/** This function returns the most common word shared by every input file.
+ *  The most_common_word variable is initially zero, so if there is no common
+ *  word, maybe because one of the input files is empty, the return value will
+ *  be a NULL pointer.
+ * 
+ */
+const char volatile* most_common_shared_word(void) {
+    return most_common_word;
+}
+
+size_t most_common_shared_words(struct shared_word_t* words, size_t capacity) {
+    const size_t number_of_words = MIN(capacity, top_words.size);
+
+    for (size_t i = 0; i < number_of_words; ++i) {
+        const struct table_entry_t* entry = top_words.entries[i].entry;
+
+        words[i].word   = entry->word;
+        words[i].counts = entry->counts;
+        words[i].score  = top_words.entries[i].score;
+    }
+
+    return number_of_words;
+}
+
+size_t table_reseeds(void) {
+    return __atomic_load_n(&number_of_reseeds, __ATOMIC_RELAXED);
+}
+
+/** Because the entries and their words live in the threads' arenas, releasing
+ *  the table is a bulk operation: the control bytes and slots are two
+ *  allocations, and each arena frees its blocks one at a time without ever
+ *  visiting the entries they contain.
+ * 
+ */
+void release_table_resources(void) {
+    FREE(hash_table.control);
+    FREE(hash_table.slots);
+
+    hash_table.capacity = 0;
+    hash_table.size     = 0;
+
+    while (table_arenas) {
+        struct table_arenas_t* next = table_arenas->next;
+
+        release_arena(&table_arenas->entries);
+        release_arena(&table_arenas->words);
+
+        FREE(table_arenas);
+
+        table_arenas = next;
+    }
+
+    thread_arenas = NULL;
+
+    for (size_t i = 0; i < number_of_merged_tables; ++i) {
+        FREE(merged_tables[i].control);
+        FREE(merged_tables[i].slots);
+    }
+
+    FREE(merged_tables);
+
+    number_of_merged_tables = 0;
+
+    release_selection(&top_words);
+    release_pair_matrix();
+
+    if (table_access_locks) {
+        for (int i = 0; i < number_of_access_locks; ++i) {
+            pthread_mutex_destroy(&table_access_locks[i].lock);
+        }
+    }
+
+    FREE(table_access_locks);
+
+    release_local_tables();
+    release_combining_caches();
+    release_partitions();
+
+    number_of_table_threads = 0;
+    number_of_access_locks  = 0;
+}
+
+#if defined(ARENA_BLOCK_SIZE)
+#undef ARENA_BLOCK_SIZE
+#endif
+
+#if defined(MEAN_PROBE_LENGTH_LIMIT)
+#undef MEAN_PROBE_LENGTH_LIMIT
+#endif
+
+#if defined(PROBE_LENGTH_LIMIT)
+#undef PROBE_LENGTH_LIMIT
 #endif
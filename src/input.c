@@ -0,0 +1,292 @@
+
+#include "common.h"
+
+#ifndef PEEK_SIZE
+/** This is how many bytes at a time are read past the end of an unmapped
+ *  chunk while looking for the end of the word it ends in. Nearly every word
+ *  is shorter than this, so one read is almost always enough.
+ * 
+ */
+#define PEEK_SIZE (64)
+#else
+#error "PEEK_SIZE already defined."
+#endif // PEEK_SIZE
+
+size_t default_chunk_size(void) {
+    long cache_size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+
+    if (cache_size <= 0) {
+        return 256 * 1024;
+    }
+
+    return (size_t) cache_size / 2;
+}
+
+/** This function's only job is to allocate the memory required by the input
+ *  object, exiting with an error message if the allocation fails, just like
+ *  the rest of the allocation functions in this program.
+ * 
+ */
+__attribute__((returns_nonnull))
+static inline struct input_t* allocate_input(void) {
+    struct input_t* input = malloc(sizeof (struct input_t));
+
+    if (input == NULL) {
+        fatal_error("Memory allocation failure in allocate_input()");
+    }
+
+    return input;
+}
+
+/** This function opens the named file as input number 'file'. Regular files
+ *  are mapped into memory in their entirety, unless the user asked for
+ *  'pread' instead, which saves copying every byte of the file into a buffer
+ *  and making a system call for every chunk.
+ * 
+ *  Once mapped, the kernel is told the mapping will be read sequentially,
+ *  which makes it read ahead more aggressively, and that the whole of it will
+ *  be needed soon, which starts that reading right away. Neither piece of
+ *  advice is binding, so their failure is of no consequence.
+ * 
+ *  Inputs that are read with 'pread', whether by choice or because they could
+ *  not be mapped, get the equivalent advice through 'posix_fadvise'. An offset
+ *  and length of zero apply the advice to the whole file.
+ * 
+ *  Anything other than a regular file, like a pipe, can only be read from
+ *  start to finish, so it becomes a stream, with a reader thread of its own.
+ *  Standard input is no different: if it was redirected from a regular file,
+ *  it is mapped just like any other.
+ * 
+ *  In the direct input mode, regular files become streams as well, reopened
+ *  with O_DIRECT and read a page-aligned chunk at a time by their reader
+ *  threads, into a fixed ring of aligned buffers that are recycled as soon as
+ *  the threads are done with them. Files read this way never enter the page
+ *  cache, so reading them does not evict anything else from it. Should the
+ *  file system not support O_DIRECT, the file is streamed through the page
+ *  cache after all.
+ * 
+ */
+struct input_t* open_input(const char* filename, int file) {
+    struct input_t* input = allocate_input();
+
+    input->filename        = filename;
+    input->file            = file;
+    input->file_descriptor = (strings_match(filename, "-")) ? STDIN_FILENO : open_file_descriptor(filename, O_RDONLY);
+    input->size            = -1;
+    input->data            = NULL;
+    input->stream          = NULL;
+    input->offset          = 0;
+
+    if (pthread_mutex_init(&input->lock, NULL)) {
+        fatal_error("Failed to initialize input lock");
+    }
+
+    struct stat file_status;
+
+    if (fstat(input->file_descriptor, &file_status) == -1) {
+        fprintf(stderr, "[Error] %s (%s)\n", strerror(errno), filename);
+        exit(EXIT_FAILURE);
+    }
+
+    if (S_ISREG(file_status.st_mode)) {
+        input->size = file_status.st_size;
+    }
+
+    if (!S_ISREG(file_status.st_mode) || (settings_get_io_mode() == IO_DIRECT)) {
+        size_t alignment = 1;
+
+        if (S_ISREG(file_status.st_mode) && !strings_match(filename, "-")) {
+            int file_descriptor = open_direct_file_descriptor(filename);
+
+            if (file_descriptor != -1) {
+                close_file_descriptor(input->file_descriptor);
+
+                input->file_descriptor = file_descriptor;
+
+                alignment = (size_t) sysconf(_SC_PAGESIZE);
+            }
+        }
+
+        input->stream = open_stream(input->file_descriptor, filename, alignment);
+
+        return input;
+    }
+
+    if ((settings_get_io_mode() == IO_MMAP) && (input->size > 0)) {
+        input->data = map_file_descriptor(input->file_descriptor, (size_t) input->size, settings_get_populate());
+    }
+
+    if (input->data) {
+        madvise((void *) input->data, (size_t) input->size, MADV_SEQUENTIAL);
+        madvise((void *) input->data, (size_t) input->size, MADV_WILLNEED);
+    } else {
+        posix_fadvise(input->file_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    return input;
+}
+
+/** This function returns the offset of the first byte at or after 'offset'
+ *  that is not part of a word, or the end of the input if there isn't one.
+ *  Chunks ending at this offset therefore never end in the middle of a word,
+ *  and since the next chunk begins where this one ends, it never begins in
+ *  the middle of one either.
+ * 
+ *  Mapped inputs are simply scanned in place. Unmapped inputs have to be
+ *  peeked at with 'pread', which only happens once per chunk, and is so small
+ *  a read compared to the chunk itself that it is negligible.
+ * 
+ */
+__attribute__((nonnull(1)))
+static off_t find_word_boundary(const struct input_t* input, off_t offset) {
+    if (input->data) {
+        while ((offset < input->size) && is_word_character(input->data[offset])) {
+            ++offset;
+        }
+
+        return offset;
+    }
+
+    char peek[PEEK_SIZE];
+
+    while (TRUE) {
+        ssize_t bytes_read = pread(input->file_descriptor, peek, PEEK_SIZE, offset);
+
+        if (bytes_read <= 0) {
+            return offset;
+        }
+
+        for (ssize_t i = 0; i < bytes_read; ++i) {
+            if (!is_word_character(peek[i])) {
+                return offset + i;
+            }
+        }
+
+        offset += bytes_read;
+    }
+}
+
+/** Before performing any kind of read operations, we must first get the file
+ *  offset at which this thread is to begin reading from, while at the same
+ *  time incrementing the input file offset by the buffer size so the next
+ *  thread begins reading from the next sector.
+ * 
+ *  While I usually prefer reader-writer locks to mutexes, a reader-writer lock
+ *  gives us no additional functionality here. We can't simply lock the global
+ *  offset in read mode, get our offset value, lock the the global offset in
+ *  write mode, increment it, and unlock it. Other threads waiting to read and
+ *  increment the global file offset may get spurious values if we treat read
+ *  and write operations distinctly. Reading and writing operations on the
+ *  global file offset must be treated atomically, so this is the perfect use
+ *  case for a mutex.
+ * 
+ *  The end of the chunk is snapped forward to the end of whatever word it
+ *  lands in while the lock is still held, since that is where the next chunk
+ *  has to begin. Only regular files get this far, since everything else is
+ *  read as a stream, so the size of the input is always known.
+ * 
+ */
+int claim_input_chunk(struct input_t* input, struct chunk_t* chunk) {
+    if (input->stream) {
+        return claim_stream_chunk(input->stream, chunk);
+    }
+
+    int claimed = FALSE;
+
+    timed_mutex_lock(&input->lock, LOCK_INPUT);
+
+    if (input->offset < input->size) {
+        off_t end = input->offset + (off_t) settings_get_chunk_size();
+
+        if (end > input->size) {
+            end = input->size;
+        }
+
+        end = find_word_boundary(input, end);
+
+        chunk->start  = input->offset;
+        chunk->length = (size_t) (end - input->offset);
+
+        input->offset = end;
+
+        claimed = TRUE;
+    }
+
+    pthread_mutex_unlock(&input->lock);
+
+    return claimed;
+}
+
+/** The benefit of using 'pread' over 'read' is that not only is pread
+ *  equivalent to using 'lseek' then 'read', which is perfect here because
+ *  each thread is keeping track of its own offset in the input file, but
+ *  pread is an atomic IO operation. A mapped input needs neither, of course.
+ * 
+ *  A single call to pread is allowed to read less than it was asked to, so it
+ *  is called until the chunk has been read in full or the file runs out.
+ * 
+ */
+const char* read_input_chunk(struct input_t* input, struct chunk_t* chunk, struct input_buffer_t* buffer) {
+    if (input->data) {
+        return input->data + chunk->start;
+    }
+
+    if (input->stream) {
+        return stream_chunk_data(input->stream, chunk);
+    }
+
+    if (buffer->capacity < chunk->length) {
+        char* data = realloc(buffer->data, chunk->length);
+
+        if (data == NULL) {
+            fatal_error("Memory allocation failure in read_input_chunk()");
+        }
+
+        buffer->data     = data;
+        buffer->capacity = chunk->length;
+    }
+
+    size_t total_bytes_read = 0;
+
+    while (total_bytes_read < chunk->length) {
+        ssize_t bytes_read = pread(input->file_descriptor, buffer->data + total_bytes_read, chunk->length - total_bytes_read, chunk->start + (off_t) total_bytes_read);
+
+        if (bytes_read <= 0) {
+            break;
+        }
+
+        total_bytes_read += (size_t) bytes_read;
+    }
+
+    chunk->length = total_bytes_read;
+
+    return buffer->data;
+}
+
+void release_input_chunk(struct input_t* input, const struct chunk_t* chunk) {
+    if (input->stream) {
+        release_stream_chunk(input->stream, chunk);
+    }
+}
+
+void release_input_buffer(struct input_buffer_t* buffer) {
+    FREE(buffer->data);
+
+    buffer->capacity = 0;
+}
+
+void close_input(struct input_t* input) {
+    if (input->data) {
+        unmap_file(input->data, (size_t) input->size);
+    }
+
+    if (input->stream) {
+        close_stream(input->stream);
+    }
+
+    close_file_descriptor(input->file_descriptor);
+
+    pthread_mutex_destroy(&input->lock);
+
+    FREE(input);
+}
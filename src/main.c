@@ -32,31 +32,40 @@
 
 /** This object holds the parameters needed by each thread to execute the
  *  'thread_process_file' function, which each thread's main method. The object
- *  contains two fields:
+ *  contains three fields:
  * 
- *      1. filename     The name of the input file to process
- *      2. file         The number (1 or 2) of the input file it is handling
+ *      1. scheduler    The scheduler handing out chunks of the inputs, which
+ *                      is shared by every thread
+ * 
+ *      2. worker       The thread's own number, which identifies its deque
+ *                      in the scheduler
+ * 
+ *      3. probe        Whether the words of the inputs are only to be counted
+ *                      if they are already in the table, which is the case for
+ *                      the larger input in join mode
  * 
  *  The thread's start function takes a single void pointer argument, meaning
  *  that we have to aggregate the arguments into a single object to then pass
- *  in.
+ *  in. Every thread gets an object of its own, since no two threads share a
+ *  worker number.
  * 
  */
 struct thread_arguments_t {
-    const char* filename;
-    int file;
+    struct scheduler_t* scheduler;
+    size_t worker;
+    int probe;
 };
 
 /** This function's only job is to allocate the memory required by the thread
- *  arguments object. The function also ensures the pointer returned by the
- *  call to malloc is valid, and if it isn't, the function prints an error
- *  message to standard error and exits with a status code of EXIT_FAILURE. The
- *  caller may be sure that execution beyond the call to this function will
- *  take place if and only if the call is successful.
+ *  arguments objects, one for each thread. The function also ensures the
+ *  pointer returned by the call to malloc is valid, and if it isn't, the
+ *  function prints an error message to standard error and exits with a status
+ *  code of EXIT_FAILURE. The caller may be sure that execution beyond the call
+ *  to this function will take place if and only if the call is successful.
  * 
  */
-static inline struct thread_arguments_t* allocate_thread_arguments(void) {
-    struct thread_arguments_t* thread_arguments = malloc(sizeof (struct thread_arguments_t));
+static inline struct thread_arguments_t* allocate_thread_arguments(int number_of_threads) {
+    struct thread_arguments_t* thread_arguments = malloc(number_of_threads * sizeof (struct thread_arguments_t));
 
     if (thread_arguments == NULL) {
         fatal_error("Memory allocation failure in allocate_thread_arguments");
@@ -65,30 +74,19 @@ static inline struct thread_arguments_t* allocate_thread_arguments(void) {
     return thread_arguments;
 }
 
-/** This is the constructor for the thread arguments object. To invoke, the
- *  caller must pass in both the name of the input file and the file number
- *  designation. This is an arbitrary number (1 or 2) to distinguish the word
- *  counts for the file. This allows for a simple calculation of the harmonic
- *  mean using each count from both input files.
- * 
- *  A deep copy of the filename must be made via a call to strdup because the
- *  filename pointer's data is sitting in the thread_process_file function's
- *  input_buffer, which will be overwritten once the entire buffer has been
- *  processed.
+/** This function fills in a single thread's arguments. The scheduler is
+ *  created once per pass over the inputs, in main, and the inputs themselves
+ *  are opened once, so that every thread processing them shares the same file
+ *  descriptor, mapping, and chunk offset. Each input also carries the file
+ *  number designation, its position on the command line counting from one,
+ *  which picks out the word's count for the file.
  * 
  */
-static inline struct thread_arguments_t* create_thread_arguments(const char* filename, int file) {
-    struct thread_arguments_t* thread_arguments = allocate_thread_arguments();
-
-    thread_arguments->filename = strdup(filename);
-
-    if (thread_arguments->filename == NULL) {
-        fatal_error("strdup() failed in create_thread_arguments");
-    }
-
-    thread_arguments->file = file;
-
-    return thread_arguments;
+__attribute__((nonnull(1,2)))
+static inline void initialize_thread_arguments(struct thread_arguments_t* thread_arguments, struct scheduler_t* scheduler, size_t worker, int probe) {
+    thread_arguments->scheduler = scheduler;
+    thread_arguments->worker    = worker;
+    thread_arguments->probe     = probe;
 }
 
 /** This function takes care of safely freeing the heap-allocated memory
@@ -99,128 +97,366 @@ static inline struct thread_arguments_t* create_thread_arguments(const char* fil
  */
 __attribute__((nonnull(1)))
 static inline void free_thread_arguments(struct thread_arguments_t* thread_arguments) {
-    FREE(thread_arguments->filename);
     FREE(thread_arguments);
 }
-   
-#ifndef DELIMITERS
-/** These are the delimiters the strtok_r function will use to tokenize the
- *  input buffer. The program spec indicated valid strings would be composed of
- *  alphanumeric characters exclusively. These are all graphic non-alphanumeric
- *  ASCII characters, plus space.
+
+/** This function counts every word in a single chunk. The chunk is split into
+ *  words by the tokenizer, which hands them back in batches. The words point
+ *  straight into the chunk, and are delimited by their length rather than a
+ *  NUL terminator, so nothing is copied until a word is seen for the first
+ *  time, which is what makes it possible to tokenize a read-only mapping of
+ *  the file.
  * 
  */
-#define DELIMITERS " \n\t\"!#$%%&'()*+,-./:;<=>?@[\\]^_`}|{~"
-#endif
+__attribute__((hot, nonnull(1,2,3,5)))
+static void process_chunk(const struct thread_arguments_t* thread_arguments, const struct input_t* input, const char* data, size_t length, struct token_t* tokens) {
+    struct tokenizer_t tokenizer;
 
-static off_t f1_offset = 0;
+    initialize_tokenizer(&tokenizer, data, length);
 
-static pthread_mutex_t f1_lock = PTHREAD_MUTEX_INITIALIZER;
+    size_t number_of_tokens = 0;
+    size_t total_tokens = 0;
 
-static off_t f2_offset = 0;
+    switch_perf_phase(PERF_PHASE_TOKENIZE);
 
-static pthread_mutex_t f2_lock = PTHREAD_MUTEX_INITIALIZER;
+    /** Probing a sealed table changes nothing but the counts, so it never
+     *  has to be bracketed by the table access functions, which only exist
+     *  to keep the table from being grown out from under a thread.
+     * 
+     */
+    if (thread_arguments->probe) {
+        while ((number_of_tokens = next_tokens(&tokenizer, tokens, TOKEN_BATCH_SIZE)) != 0) {
+            switch_perf_phase(PERF_PHASE_INSERT);
 
-void* thread_process_file(void* arg) {
-    struct thread_arguments_t* thread_arguments = (struct thread_arguments_t *) arg;
+            for (size_t i = 0; i < number_of_tokens; ++i) {
+                count_word_in_table(tokens[i].start, tokens[i].length, input->file);
+            }
+
+            total_tokens += number_of_tokens;
+
+            switch_perf_phase(PERF_PHASE_TOKENIZE);
+        }
+
+        switch_perf_phase(PERF_PHASE_NONE);
+
+        count_input(length, total_tokens);
+        count_perf_tokens(total_tokens);
+        count_progress(length);
+
+        return;
+    }
+
+    begin_table_access();
+
+    while ((number_of_tokens = next_tokens(&tokenizer, tokens, TOKEN_BATCH_SIZE)) != 0) {
+        switch_perf_phase(PERF_PHASE_INSERT);
+
+        for (size_t i = 0; i < number_of_tokens; ++i) {
+            add_word_to_table(tokens[i].start, tokens[i].length, input->file);
+        }
 
-    /** This is the buffer responsible for streamlining disk-read operations as
-     *  much as possible. The buffer is 4kb long to benefit as much as possible
-     *  from the sequential read that's going on in this admittedly contrived
-     *  example, but generally speaking, the buffer size should always be a
-     *  multiple of the sector size of the hard drive, as reading in
-     *  sector-aligned chunks is the most efficient way of maximizing disk
-     *  throughput.
+        total_tokens += number_of_tokens;
+
+        switch_perf_phase(PERF_PHASE_TOKENIZE);
+    }
+
+    end_table_access();
+
+    switch_perf_phase(PERF_PHASE_NONE);
+
+    count_input(length, total_tokens);
+    count_perf_tokens(total_tokens);
+    count_progress(length);
+}
+
+/** This function reads and processes a single task, waiting for the read to
+ *  complete, if there is one at all.
+ * 
+ */
+__attribute__((nonnull(1,2,3,4)))
+static void process_task(const struct thread_arguments_t* thread_arguments, struct task_t* task, struct input_buffer_t* input_buffer, struct token_t* tokens) {
+    switch_perf_phase(PERF_PHASE_READ);
+
+    uint64_t start = trace_clock();
+
+    const char* data = read_input_chunk(task->input, &task->chunk, input_buffer);
+
+    trace_event(TRACE_READ, start, task->input->filename, task->chunk.start, task->chunk.length);
+
+    switch_perf_phase(PERF_PHASE_NONE);
+
+    /** A chunk read past the end of its input comes back empty, which only
+     *  ends that input, not the thread, since there may well be work left in
+     *  the others.
      * 
      */
-    char input_buffer[BUFFER_SIZE] = { 0 };
+    if (task->chunk.length) {
+        start = trace_clock();
+
+        process_chunk(thread_arguments, task->input, data, task->chunk.length, tokens);
 
-    int input_file_descriptor = open_file_descriptor(thread_arguments->filename, O_RDONLY);
+        trace_event(TRACE_TOKENIZE, start, task->input->filename, task->chunk.start, task->chunk.length);
+    }
 
-    /** Having parsed the command-line arguments and successfully opened the
-     *  first of two files, we will now inform the kernel about the significant
-     *  sequential disk reads we are about to partake in. The kernel is not 
-     *  obligated to do anything with this information, and in fact
-     *  implementations aren't even required to implement any actual
-     *  functionality for it, but we'll try it on the off-chance it makes a any
-     *  difference.
+    /** A chunk of a stream is one of the buffers in the stream's ring, so it
+     *  has to be handed back before the reader can fill it again.
      * 
      */
-    if (posix_fadvise(input_file_descriptor, SEEK_SET, SEEK_END, POSIX_FADV_SEQUENTIAL)) {
-        /** The only way this call fails is if the file descriptor is
-         *  associated with a pipe/FIFO, the file descriptor is invalid, or the
-         *  length of the file we specified was negative.
-         * 
-         */
+    release_input_chunk(task->input, &task->chunk);
+}
+
+/** In the uring input mode, every thread keeps up to the queue depth's worth
+ *  of reads in flight at once, each into a buffer of its own, and processes
+ *  whichever of them completes first, so the kernel is copying the next few
+ *  chunks into memory while the thread tokenizes the current one. As soon as
+ *  a buffer has been processed, the thread claims another task and queues its
+ *  read, which is submitted along with the next wait.
+ * 
+ *  Chunks that need no reading at all, because their input is mapped or is a
+ *  stream, are simply processed right away, as are chunks too long for the
+ *  buffers, which are rare enough to be read synchronously. So is a chunk
+ *  whose read comes back short, which only happens if the file was truncated
+ *  while it was being read.
+ * 
+ */
+__attribute__((nonnull(1,2,3,4)))
+static void process_tasks_asynchronously(const struct thread_arguments_t* thread_arguments, struct uring_t* uring, struct input_buffer_t* input_buffer, struct token_t* tokens) {
+    struct task_t* tasks = malloc(uring->depth * sizeof (struct task_t));
+    unsigned int* free_buffers = malloc(uring->depth * sizeof (unsigned int));
+
+    if ((tasks == NULL) || (free_buffers == NULL)) {
+        fatal_error("Memory allocation failure in process_tasks_asynchronously()");
     }
 
-    ssize_t bytes_read = 0;
+    unsigned int number_of_free_buffers = 0;
 
-    off_t current_offset = 0;
+    for (unsigned int i = 0; i < uring->depth; ++i) {
+        free_buffers[number_of_free_buffers++] = i;
+    }
+
+    int tasks_left = TRUE;
 
     while (TRUE) {
-        /** Before performing any kind of read operations, we must first get
-         *  the file offset at which this thread is to begin reading from,
-         *  while at the same time incrementing the input file offset by the
-         *  buffer size so the next thread begins reading from the next sector.
-         * 
-         *  While I usually prefer reader-writer locks to mutexes, a
-         *  reader-writer lock gives us no additional functionality here. We
-         *  can't simply lock the global offset in read mode, get our offset
-         *  value, lock the the global offset in write mode, increment it, and
-         *  unlock it. Other threads waiting to read and increment the global
-         *  file offset may get spurious values if we treat read and write
-         *  operations distinctly. Reading and writing operations on the global
-         *  file offset must be treated atomically, so this is the perfect use
-         *  case for a mutex.
-         * 
-         */
-        if (thread_arguments->file == 1) {
-            pthread_mutex_lock(&f1_lock);
-            current_offset = f1_offset;
-            f1_offset += BUFFER_SIZE;
-            pthread_mutex_unlock(&f1_lock);
-        } else if (thread_arguments->file == 2) {
-            pthread_mutex_lock(&f2_lock);
-            current_offset = f2_offset;
-            f2_offset += BUFFER_SIZE;
-            pthread_mutex_unlock(&f2_lock);
-        } else {
-            fatal_error("Invalid file id");
+        while (tasks_left && (number_of_free_buffers > 0)) {
+            struct task_t task;
+
+            const uint64_t start = trace_clock();
+
+            if (!next_task(thread_arguments->scheduler, thread_arguments->worker, &task)) {
+                tasks_left = FALSE;
+                break;
+            }
+
+            trace_event(TRACE_CLAIM, start, task.input->filename, task.chunk.start, task.chunk.length);
+
+            if (task.input->data || task.input->stream || (task.chunk.length > uring->buffer_size)) {
+                process_task(thread_arguments, &task, input_buffer, tokens);
+                continue;
+            }
+
+            const unsigned int buffer = free_buffers[--number_of_free_buffers];
+
+            tasks[buffer] = task;
+
+            uring_prepare_read(uring, buffer, task.input->file_descriptor, task.chunk.start, task.chunk.length);
         }
-        
-        /** The benefit of using 'pread' over 'read' is that not only is pread
-         *  equivalent to using 'lseek' then 'read', which is perfect here
-         *  because each thread is keeping track of its own offset in the
-         *  input file, but pread is an atomic IO operation.
-         * 
-         */
-        bytes_read = pread(input_file_descriptor, input_buffer, BUFFER_SIZE, current_offset);
-
-        if ((bytes_read == 0) || ((bytes_read == -1))) {
+
+        if (number_of_free_buffers == uring->depth) {
             break;
         }
 
-        char* token_reentrancy_pointer = NULL;
+        ssize_t result = 0;
+
+        switch_perf_phase(PERF_PHASE_READ);
+
+        uint64_t start = trace_clock();
+
+        const unsigned int buffer = uring_wait_for_read(uring, &result);
+
+        switch_perf_phase(PERF_PHASE_NONE);
+
+        struct task_t* task = &tasks[buffer];
 
-        char* word = strtok_r(input_buffer, DELIMITERS, &token_reentrancy_pointer);
+        trace_event(TRACE_READ, start, task->input->filename, task->chunk.start, task->chunk.length);
 
-        if (word == NULL) {
-            continue;
+        if (result < 0) {
+            fprintf(stderr, "[Error] %s (%s)\n", strerror((int) -result), task->input->filename);
+            exit(EXIT_FAILURE);
         }
 
-        add_word_to_table(word, ((struct thread_arguments_t *) arg)->file);
+        if ((size_t) result == task->chunk.length) {
+            start = trace_clock();
+
+            process_chunk(thread_arguments, task->input, uring_buffer(uring, buffer), task->chunk.length, tokens);
+
+            trace_event(TRACE_TOKENIZE, start, task->input->filename, task->chunk.start, task->chunk.length);
+
+            release_input_chunk(task->input, &task->chunk);
+        } else {
+            process_task(thread_arguments, task, input_buffer, tokens);
+        }
+
+        free_buffers[number_of_free_buffers++] = buffer;
+    }
+
+    FREE(free_buffers);
+    FREE(tasks);
+}
+
+void* thread_process_file(void* arg) {
+    struct thread_arguments_t* thread_arguments = (struct thread_arguments_t *) arg;
+
+    register_stats_thread(thread_arguments->worker);
+    register_trace_thread(thread_arguments->worker);
+    register_progress_thread(thread_arguments->worker);
+    open_thread_perf_counters(thread_arguments->worker);
+
+    const double start = stats_clock();
+
+    /** This is the buffer chunks are read into when the input could not be
+     *  mapped into memory. It used to live on the stack, but the chunk size is
+     *  now chosen at runtime, and is usually far too large for the minimum
+     *  stack size the threads are created with. Mapped inputs never touch it,
+     *  so it is never even allocated for them.
+     * 
+     */
+    struct input_buffer_t input_buffer = { NULL, 0 };
+
+    struct token_t tokens[TOKEN_BATCH_SIZE];
+
+    /** Should the thread fail to set up a uring of its own, say because it has
+     *  hit the limit on open files, it simply reads its chunks with 'pread'.
+     * 
+     */
+    struct uring_t uring;
+
+    if ((settings_get_io_mode() == IO_URING) && create_uring(&uring, settings_get_queue_depth(), settings_get_chunk_size() + URING_BUFFER_SLACK)) {
+        process_tasks_asynchronously(thread_arguments, &uring, &input_buffer, tokens);
+        destroy_uring(&uring);
+    } else {
+        struct task_t task;
+
+        uint64_t claim_start = trace_clock();
+
+        while (next_task(thread_arguments->scheduler, thread_arguments->worker, &task)) {
+            trace_event(TRACE_CLAIM, claim_start, task.input->filename, task.chunk.start, task.chunk.length);
+
+            process_task(thread_arguments, &task, &input_buffer, tokens);
 
-        while ((word = strtok_r(NULL, DELIMITERS, &token_reentrancy_pointer)) != NULL) {
-            add_word_to_table(word, ((struct thread_arguments_t *) arg)->file);
+            claim_start = trace_clock();
         }
     }
 
-    close_file_descriptor(input_file_descriptor);
+    release_input_buffer(&input_buffer);
+
+    record_phase((thread_arguments->probe) ? PHASE_PROBE : PHASE_COUNT, start);
+
+    close_thread_perf_counters();
 
     return NULL;
 }
 
+/** This function makes one pass over the given inputs with every thread, all
+ *  of them pulling their chunks from a single scheduler, and returns once
+ *  every thread has finished.
+ * 
+ */
+__attribute__((nonnull(1,2,4,6)))
+static void process_inputs(pthread_t* threads, struct thread_arguments_t* thread_arguments, int number_of_threads, const pthread_attr_t* thread_attributes, int probe, struct input_t** inputs, size_t number_of_inputs) {
+    struct scheduler_t* scheduler = create_scheduler(inputs, number_of_inputs, (size_t) number_of_threads);
+
+    for (int i = 0; i < number_of_threads; ++i) {
+        initialize_thread_arguments(&thread_arguments[i], scheduler, (size_t) i, probe);
+
+        if (pthread_create(&threads[i], thread_attributes, thread_process_file, &thread_arguments[i])) {
+            fatal_error("Could not create new thread");
+        }
+    }
+
+    for (int i = 0; i < number_of_threads; ++i) {
+        if (pthread_join(threads[i], NULL)) {
+            fatal_error("Could not rejoin sub-threads");
+        }
+    }
+
+    free_scheduler(scheduler);
+}
+
+/** In join mode, the table is built from whichever input is smallest, since
+ *  that is the one that determines how many entries the table ends up with,
+ *  and this function returns its index in the given array. An input whose size
+ *  is unknown is assumed to be larger than any other, and if the sizes are
+ *  equal, the earliest input is used.
+ * 
+ */
+__attribute__((nonnull(1)))
+static size_t choose_build_input(struct input_t* const* inputs, size_t number_of_inputs) {
+    size_t build = 0;
+
+    for (size_t i = 1; i < number_of_inputs; ++i) {
+        if ((inputs[i]->size != -1) && ((inputs[build]->size == -1) || (inputs[i]->size < inputs[build]->size))) {
+            build = i;
+        }
+    }
+
+    return build;
+}
+
+/** This function prints a single word's counts in every input, in the order
+ *  the inputs were given, each preceded by a tab.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void print_counts(const size_t* counts, size_t number_of_inputs) {
+    for (size_t i = 0; i < number_of_inputs; ++i) {
+        printf("\t%zu", counts[i]);
+    }
+}
+
+/** Given '--top K', the program prints up to K of the most common shared
+ *  words instead of just the one, from the most common down, one per line,
+ *  each followed by its count in every file and its commonality score, all
+ *  separated by tabs so the output can be fed straight to other tools.
+ * 
+ */
+static void print_top_words(size_t top, size_t number_of_inputs) {
+    struct shared_word_t* words = malloc(top * sizeof (struct shared_word_t));
+
+    if (words == NULL) {
+        fatal_error("Memory allocation failure in print_top_words()");
+    }
+
+    const size_t number_of_words = most_common_shared_words(words, top);
+
+    for (size_t i = 0; i < number_of_words; ++i) {
+        printf("%s", words[i].word);
+        print_counts(words[i].counts, number_of_inputs);
+        printf("\t%.3f\n", words[i].score);
+    }
+
+    FREE(words);
+}
+
+/** Given '--matrix', the program prints the most common word shared by every
+ *  pair of files instead, as a grid with a row and a column for each file in
+ *  the order they were given. The cells are separated by tabs, and the grid is
+ *  symmetric, since the word shared by two files does not depend on which one
+ *  comes first. A file has nothing to be compared with on the diagonal, which
+ *  is marked with a dash, as is any pair of files with no words in common.
+ * 
+ */
+static void print_pair_matrix(size_t number_of_inputs) {
+    for (size_t row = 1; row <= number_of_inputs; ++row) {
+        for (size_t column = 1; column <= number_of_inputs; ++column) {
+            struct shared_word_t word;
+
+            const char* cell = (most_common_pair_word((int) row, (int) column, &word)) ? word.word : "-";
+
+            printf((column < number_of_inputs) ? "%s\t" : "%s\n", cell);
+        }
+    }
+}
+
 /** This is the entry point of the program, which begins by calling the
  *  parse_command_line_options function. This function handles any options and
  *  validates the number of command line parameters. This allows the rest of
@@ -231,15 +467,49 @@ void* thread_process_file(void* arg) {
 int main(int argc, char *argv[])
 {
     /** This argument vector returned by parse_command_line_options contains
-     *  only the names of the filenames to process. The current program is
-     *  structured to handle only two filenames, but this limit is arbitrary
-     *  and could be changed with only minor modifications.
+     *  only the names of the filenames to process, of which there are at
+     *  least two, and as many more as the user cares to give.
      * 
      */
     char** filenames = parse_command_line_options(argc, argv);
 
-    const int total_threads    = settings_get_threads();
-    const int threads_per_file = total_threads / 2;
+    const size_t number_of_inputs = settings_get_number_of_inputs();
+
+    const int total_threads = settings_get_threads();
+
+    /** The counters have to be in place before the table is, so that even its
+     *  initial allocations are counted.
+     * 
+     */
+    if (settings_get_stats()) {
+        initialize_stats((size_t) total_threads);
+    }
+
+    /** Hardware counters are commonly unavailable, in virtual machines and in
+     *  containers alike, in which case the run simply goes on without them.
+     * 
+     */
+    if (settings_get_perf_counters() && !initialize_perf_counters((size_t) total_threads)) {
+        fprintf(stderr, "[Warning] %s (%s)\n", "Hardware performance counters are unavailable", strerror(errno));
+    }
+
+    /** The trace buffers are allocated, and touched, before any thread starts,
+     *  and only written out once every thread is done, so the timeline is of
+     *  the run itself rather than of the tracing.
+     * 
+     */
+    if (settings_get_trace()) {
+        initialize_trace((size_t) total_threads);
+    }
+
+    initialize_table_resources();
+
+    /** The monitor has to be running before any other thread is started, the
+     *  readers of any streams included, so that none of them can be the one
+     *  SIGUSR1 is delivered to, since it would kill the process.
+     * 
+     */
+    start_monitor((size_t) total_threads);
 
     pthread_t* threads = malloc(total_threads * sizeof (pthread_t));
 
@@ -247,7 +517,27 @@ int main(int argc, char *argv[])
         fatal_error("Memory allocation failure in main()");
     }
 
-    struct thread_arguments_t* t1_args = create_thread_arguments(filenames[0], 1);
+    /** The inputs are all opened up front, rather than by each thread, so
+     *  that each file is only opened and mapped into memory once.
+     * 
+     */
+    struct input_t** inputs = malloc(number_of_inputs * sizeof (struct input_t *));
+
+    if (inputs == NULL) {
+        fatal_error("Memory allocation failure in main()");
+    }
+
+    size_t total_bytes = 0;
+
+    for (size_t i = 0; i < number_of_inputs; ++i) {
+        inputs[i] = open_input(filenames[i], (int) (i + 1));
+
+        total_bytes = ((total_bytes == SIZE_MAX) || (inputs[i]->size == -1)) ? SIZE_MAX : total_bytes + (size_t) inputs[i]->size;
+    }
+
+    set_progress_total((total_bytes == SIZE_MAX) ? 0 : total_bytes);
+
+    struct thread_arguments_t* thread_arguments = allocate_thread_arguments(total_threads);
 
     /** This pthread_attributes_t variable is used for configuring the
      *  attributes on newly created threads, which is especially useful given
@@ -280,35 +570,100 @@ int main(int argc, char *argv[])
      */
     pthread_attr_setguardsize(&thread_attributes, 0);
 
-    for (int i = 0; i < threads_per_file; ++i) {
-        if (pthread_create(&threads[i], &thread_attributes, thread_process_file, t1_args)) {
-            fatal_error("Could not create new thread");
-        }
-    }
+    /** Normally, every thread processes every input at the same time, taking
+     *  chunks from whichever input it can, so a thread whose input runs out
+     *  early simply moves on to another one, and every word is counted for
+     *  every file in a single pass. In join mode, the inputs are processed in
+     *  two passes instead: first the smallest input builds the table, and once
+     *  the table has been sealed, the rest of the inputs probe it together.
+     *  The build input is swapped to the front of the array, so the inputs
+     *  left to probe it are simply the rest of the array.
+     * 
+     */
+    if (settings_get_join()) {
+        const size_t build = choose_build_input(inputs, number_of_inputs);
 
-    struct thread_arguments_t* t2_args = create_thread_arguments(filenames[1], 2);
+        struct input_t* build_input = inputs[build];
 
-    for (int i = threads_per_file; i < total_threads; ++i) {
-        if (pthread_create(&threads[i], &thread_attributes, thread_process_file, t2_args)) {
-            fatal_error("Could not create thread");
-        }
+        inputs[build] = inputs[0];
+        inputs[0]     = build_input;
+
+        double start = stats_clock();
+        uint64_t trace_start = trace_clock();
+
+        process_inputs(threads, thread_arguments, total_threads, &thread_attributes, FALSE, inputs, 1);
+
+        record_phase(PHASE_COUNT, start);
+        trace_phase(PHASE_COUNT, trace_start);
+
+        start = stats_clock();
+        trace_start = trace_clock();
+
+        begin_perf_scan();
+
+        seal_table();
+
+        end_perf_scan();
+
+        record_phase(PHASE_SEAL, start);
+        trace_phase(PHASE_SEAL, trace_start);
+
+        start = stats_clock();
+        trace_start = trace_clock();
+
+        process_inputs(threads, thread_arguments, total_threads, &thread_attributes, TRUE, inputs + 1, number_of_inputs - 1);
+
+        record_phase(PHASE_PROBE, start);
+        trace_phase(PHASE_PROBE, trace_start);
+    } else {
+        const double start = stats_clock();
+        const uint64_t trace_start = trace_clock();
+
+        process_inputs(threads, thread_arguments, total_threads, &thread_attributes, FALSE, inputs, number_of_inputs);
+
+        record_phase(PHASE_COUNT, start);
+        trace_phase(PHASE_COUNT, trace_start);
     }
 
-    for (int i = 0; i < total_threads; ++i) {
-        if (pthread_join(threads[i], NULL)) {
-            fatal_error("Could not rejoin sub-threads");
-        }
+    stop_monitor();
+
+    /** With every thread joined, the table can be brought to its final state.
+     *  Depending on the table mode, that may mean scanning the table for the
+     *  most common word, or merging every thread's private table in parallel.
+     * 
+     */
+    const double start = stats_clock();
+    const uint64_t trace_start = trace_clock();
+
+    begin_perf_scan();
+
+    finalize_table_resources();
+
+    end_perf_scan();
+
+    record_phase(PHASE_FINALIZE, start);
+    trace_phase(PHASE_FINALIZE, trace_start);
+
+    report_stats();
+    report_perf_counters();
+
+    if (settings_get_trace()) {
+        write_trace(settings_get_trace());
     }
 
     /** This is the grand-finale; should there exist a string commonly found
-     *  in both input files, the most_common_shared_word function will evaluate
+     *  in every input file, the most_common_shared_word function will evaluate
      *  to true (as it is a pointer to said word), and the printf function will
      *  subsequently print it for the user.
      * 
      *  (Spoiler alert: it's probably "the")
      * 
      */
-    if (most_common_shared_word()) {
+    if (settings_get_matrix()) {
+        print_pair_matrix(number_of_inputs);
+    } else if (settings_get_top()) {
+        print_top_words(settings_get_top(), number_of_inputs);
+    } else if (most_common_shared_word()) {
         printf("%s\n", most_common_shared_word());
     }
 
@@ -321,16 +676,23 @@ int main(int argc, char *argv[])
      *  prevents double-freeing heap-allocated memory.
      * 
      */
-    free_thread_arguments(t1_args);
-    free_thread_arguments(t2_args);
+    free_thread_arguments(thread_arguments);
 
-    FREE(filenames[0]);
-    FREE(filenames[1]);
+    for (size_t i = 0; i < number_of_inputs; ++i) {
+        close_input(inputs[i]);
+        FREE(filenames[i]);
+    }
+
+    FREE(inputs);
     FREE(filenames);
 
     pthread_attr_destroy(&thread_attributes);
     
     release_table_resources();
 
+    release_stats();
+    release_perf_counters();
+    release_trace();
+
     return EXIT_SUCCESS;
 }
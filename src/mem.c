@@ -36,3 +36,82 @@ void safe_free(void** ptr) {
      */
     *ptr = NULL;
 }
+
+/** Every block in an arena starts with a pointer to the block allocated before
+ *  it, so that the arena can find them all again when it is released. That is
+ *  the only bookkeeping an arena ever does.
+ * 
+ */
+struct arena_block_t {
+    struct arena_block_t* next;
+    unsigned char data[];
+};
+
+void initialize_arena(struct arena_t* arena, size_t block_size) {
+    arena->blocks     = NULL;
+    arena->next       = NULL;
+    arena->end        = NULL;
+    arena->block_size = block_size;
+}
+
+/** This function allocates a new block with room for 'size' bytes of data and
+ *  pushes it onto the arena's list of blocks.
+ * 
+ */
+__attribute__((nonnull(1), returns_nonnull))
+static struct arena_block_t* allocate_arena_block(struct arena_t* arena, size_t size) {
+    struct arena_block_t* block = malloc(sizeof (struct arena_block_t) + size);
+
+    if (block == NULL) {
+        fatal_error("Memory allocation failure in allocate_arena_block()");
+    }
+
+    count_allocation(sizeof (struct arena_block_t) + size);
+
+    block->next   = arena->blocks;
+    arena->blocks = block;
+
+    return block;
+}
+
+void* arena_allocate(struct arena_t* arena, size_t size, size_t alignment) {
+    unsigned char* allocation = (unsigned char *) (((uintptr_t) arena->next + (alignment - 1)) & ~(uintptr_t) (alignment - 1));
+
+    /** The arena starts out with no block at all, in which case 'next' and
+     *  'end' are both NULL, so the first allocation always lands here. Near
+     *  the end of a block, aligning 'next' can take it past 'end' altogether,
+     *  which has to be ruled out before the two are subtracted.
+     * 
+     */
+    if ((arena->next == NULL) || (allocation > arena->end) || (size > (size_t) (arena->end - allocation))) {
+        if (size + alignment > arena->block_size) {
+            struct arena_block_t* block = allocate_arena_block(arena, size + alignment);
+
+            return (void *) (((uintptr_t) block->data + (alignment - 1)) & ~(uintptr_t) (alignment - 1));
+        }
+
+        struct arena_block_t* block = allocate_arena_block(arena, arena->block_size);
+
+        arena->next = block->data;
+        arena->end  = block->data + arena->block_size;
+
+        allocation = (unsigned char *) (((uintptr_t) arena->next + (alignment - 1)) & ~(uintptr_t) (alignment - 1));
+    }
+
+    arena->next = allocation + size;
+
+    return allocation;
+}
+
+void release_arena(struct arena_t* arena) {
+    while (arena->blocks) {
+        struct arena_block_t* next = arena->blocks->next;
+
+        FREE(arena->blocks);
+
+        arena->blocks = next;
+    }
+
+    arena->next = NULL;
+    arena->end  = NULL;
+}
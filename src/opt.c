@@ -11,14 +11,29 @@
  * 
  *  Unimplemented:
  *      -N
- *      -v, --verbose
  * 
  */
 static struct option_t options[] = {
-    { OPTION_THREADS, "-j", "--threads", "Use this many threads (default: 2)"    },
+    { OPTION_THREADS, "-j", "--threads", "Use this many threads, or auto (default: 2)"             },
     { OPTION_HELP   , "-h", "--help"   , "Display this help menu and exit"                      },
     { OPTION_VERSION, NONE, "--version", "Display program version info and exit"                },
-    { OPTION_VERBOSE, "-v", "--verbose", "Display detailed info during program execution"       }
+    { OPTION_VERBOSE, "-v", "--verbose", "Display detailed info during program execution"       },
+    { OPTION_TABLE  , NONE, "--table"  , "Table mode: locked, lockfree, local, partitioned"         },
+    { OPTION_IO     , NONE, "--io"     , "Input mode: mmap, pread, uring, direct (default: mmap)"   },
+    { OPTION_POPULATE, NONE, "--populate", "Prefault memory-mapped input files"                    },
+    { OPTION_CHUNK_SIZE, NONE, "--chunk-size", "Bytes claimed per thread at a time (default: L2 / 2)" },
+    { OPTION_WINNER , NONE, "--winner" , "Find the winner by: scan, live (default: scan)"          },
+    { OPTION_HASH   , NONE, "--hash"   , "Hash: wyhash, murmur, weinberger, sedgewick, trivial"    },
+    { OPTION_JOIN   , NONE, "--join"   , "Build from the smallest file, probe with the rest"       },
+    { OPTION_TOP    , NONE, "--top"    , "List the K most common shared words with their counts"   },
+    { OPTION_METRIC , NONE, "--metric" , "Score by: harmonic, geometric, min (default: harmonic)"  },
+    { OPTION_MATRIX , NONE, "--matrix" , "Print the most common word shared by every pair of files" },
+    { OPTION_QUEUE_DEPTH, NONE, "--queue-depth", "Reads in flight per thread with io_uring (default: 4)" },
+    { OPTION_STATS  , NONE, "--stats"  , "Report per-thread counters, lock waits and table statistics" },
+    { OPTION_PERF_COUNTERS, NONE, "--perf-counters", "Report hardware counters, IPC and misses per token by phase" },
+    { OPTION_TRACE  , NONE, "--trace"  , "Write a Chrome trace of every thread's work to this file" },
+    { OPTION_PROGRESS, NONE, "--progress", "Report throughput and time left while running" },
+    { OPTION_COMBINE, NONE, "--combine", "Combine counts of frequent words per thread" }
 };
 
 static size_t number_of_program_options = sizeof (options) / sizeof (options[0]);
@@ -28,8 +43,8 @@ static size_t number_of_program_options = sizeof (options) / sizeof (options[0])
  * 
  *  Currently the help menu looks as follows:
  * 
- *    Usage: common [OPTIONS...] FILE1 FILE2
- *    Find the most common string shared between two files.
+ *    Usage: common [OPTIONS...] FILE1 FILE2 [FILE...]
+ *    Find the most common string shared between two or more files.
  *
  *        -h, --help                   Display this help menu and exit
  *            --version                Display program version info and exit
@@ -48,29 +63,63 @@ static void print_options_help(void) {
     }
 }
 
+/** Long options may be given their value in the same argument, separated by
+ *  an equals sign, as in '--table=lockfree'. When matching an argument against
+ *  the long options, only the part before the equals sign is compared.
+ * 
+ */
 __attribute__((nonnull(1)))
 static option_id_t string_matches_program_option(const char* str) {
+    size_t name_length = strcspn(str, "=");
+
     for (size_t i = 0; i < number_of_program_options; ++i) {
         if (strings_match(options[i].short_option, str) || strings_match(options[i].long_option, str)) {
             return options[i].id;
         }
+
+        if ((str[name_length] == '=') && (strlen(options[i].long_option) == name_length) && (strncmp(options[i].long_option, str, name_length) == 0)) {
+            return options[i].id;
+        }
     }
 
     return OPTION_NONE;
 }
 
+/** This function returns the value of the option at argv[*index], which is
+ *  either whatever follows the equals sign in the same argument, or else the
+ *  entire next argument, in which case the index is advanced past it. If the
+ *  option is the last argument, there is no value to return, and we exit with
+ *  an error rather than reading past the end of the argument vector.
+ * 
+ */
+__attribute__((nonnull(2,3), returns_nonnull))
+static const char* option_value(int argc, char *argv[], int* index) {
+    const char* equals_sign = strchr(argv[*index], '=');
+
+    if ((equals_sign != NULL) && (strncmp(argv[*index], "--", 2) == 0)) {
+        return equals_sign + 1;
+    }
+
+    if (*index + 1 >= argc) {
+        fprintf(stderr, "[Error] %s (%s)\n", "Missing value for option", argv[*index]);
+        exit(EXIT_FAILURE);
+    }
+
+    return argv[++*index];
+}
+
 typedef enum {
     NORMAL,
     ERROR
 } message_type_t;
 
-static const char* usage_str = "Usage: common [OPTIONS...] FILE1 FILE2";
+static const char* usage_str = "Usage: common [OPTIONS...] FILE1 FILE2 [FILE...]";
 
 static void print_usage(message_type_t message_type) {
     fprintf((message_type) ? stderr : stdout, "%s\n", usage_str);
 }
 
-static const char* help_str = "Find the most common string shared between two files.";
+static const char* help_str = "Find the most common string shared between two or more files.";
 
 static void print_help(void) {
     print_usage(NORMAL);
@@ -92,14 +141,11 @@ static size_t number_of_non_option_arguments = 0;
 __attribute__((hot, nonnull(1)))
 static void add_argument(const char* argument) {
     /** The program specification calls for accepting two and only two
-     *  filename arguments. While this seems a little arbitrary, The Spec's
-     *  Will Be Done.
-     * 
-     *  If we already have two filename arguments in the argument vector, we
-     *  will unapologetically exit with an error.
+     *  filename arguments, but any number of files can now be compared in a
+     *  single pass, so the only limit left is the one on the file numbers.
      * 
      */
-    if (number_of_non_option_arguments == 2) {
+    if (number_of_non_option_arguments == INT_MAX) {
         fprintf(stderr, "Too many filename arguments passed in.\n");
         exit(EXIT_FAILURE);
     }
@@ -129,6 +175,9 @@ static void add_argument(const char* argument) {
  */
 char** parse_command_line_options(int argc, char *argv[]) {
     int number_of_threads_specified = FALSE;
+    int chunk_size_specified = FALSE;
+    int standard_input_named = FALSE;
+    int queue_depth_specified = FALSE;
 
     for (int i = 1; i < argc; ++i) {
         option_id_t option_id = string_matches_program_option(argv[i]);
@@ -136,18 +185,19 @@ char** parse_command_line_options(int argc, char *argv[]) {
         if (option_id) {
             switch (option_id) {
                 case OPTION_THREADS: {
-                    int threads = atoi(argv[++i]);
+                    const char* value = option_value(argc, argv, &i);
 
-                    /** The total number of threads must be even, since an
-                     *  equal number of threads will be used for both files. If
-                     *  an odd number of threads is detected, increment the
-                     *  thread count by one and notify the user.
+                    /** Any number of threads will do, since every thread takes
+                     *  its chunks from any of the files. Given 'auto', the
+                     *  program uses one thread for every processor it may run
+                     *  on.
                      * 
                      */
-                    if (threads & 1) {
-                        fprintf(stderr, "%s\n", "Number of threads must be even");
+                    int threads = (strings_match(value, "auto")) ? available_processors() : atoi(value);
 
-                        ++threads;
+                    if (threads < 1) {
+                        fprintf(stderr, "[Error] %s (%s)\n", "Invalid number of threads", value);
+                        exit(EXIT_FAILURE);
                     }
 
                     settings_set_threads(threads);
@@ -168,6 +218,162 @@ char** parse_command_line_options(int argc, char *argv[]) {
                     settings_set_verbose(TRUE);
                 } break;
 
+                case OPTION_TABLE: {
+                    const char* mode = option_value(argc, argv, &i);
+
+                    if (strings_match(mode, "locked")) {
+                        settings_set_table_mode(TABLE_LOCKED);
+                    } else if (strings_match(mode, "lockfree")) {
+                        settings_set_table_mode(TABLE_LOCKFREE);
+                    } else if (strings_match(mode, "local")) {
+                        settings_set_table_mode(TABLE_LOCAL);
+                    } else if (strings_match(mode, "partitioned")) {
+                        settings_set_table_mode(TABLE_PARTITIONED);
+                    } else {
+                        fprintf(stderr, "[Error] %s (%s)\n", "Unknown table mode", mode);
+                        exit(EXIT_FAILURE);
+                    }
+                } break;
+
+                case OPTION_IO: {
+                    const char* mode = option_value(argc, argv, &i);
+
+                    if (strings_match(mode, "mmap")) {
+                        settings_set_io_mode(IO_MMAP);
+                    } else if (strings_match(mode, "pread")) {
+                        settings_set_io_mode(IO_PREAD);
+                    } else if (strings_match(mode, "uring")) {
+                        settings_set_io_mode(IO_URING);
+                    } else if (strings_match(mode, "direct")) {
+                        settings_set_io_mode(IO_DIRECT);
+                    } else {
+                        fprintf(stderr, "[Error] %s (%s)\n", "Unknown input mode", mode);
+                        exit(EXIT_FAILURE);
+                    }
+                } break;
+
+                case OPTION_POPULATE: {
+                    settings_set_populate(TRUE);
+                } break;
+
+                case OPTION_CHUNK_SIZE: {
+                    const char* size = option_value(argc, argv, &i);
+
+                    settings_set_chunk_size(parse_size(size));
+                    chunk_size_specified = TRUE;
+                } break;
+
+                case OPTION_WINNER: {
+                    const char* mode = option_value(argc, argv, &i);
+
+                    if (strings_match(mode, "scan")) {
+                        settings_set_winner_mode(WINNER_SCAN);
+                    } else if (strings_match(mode, "live")) {
+                        settings_set_winner_mode(WINNER_LIVE);
+                    } else {
+                        fprintf(stderr, "[Error] %s (%s)\n", "Unknown winner mode", mode);
+                        exit(EXIT_FAILURE);
+                    }
+                } break;
+
+                case OPTION_HASH: {
+                    const char* algorithm = option_value(argc, argv, &i);
+
+                    if (strings_match(algorithm, "wyhash")) {
+                        settings_set_hash_algorithm(HASH_WYHASH);
+                    } else if (strings_match(algorithm, "murmur")) {
+                        settings_set_hash_algorithm(HASH_MURMUR);
+                    } else if (strings_match(algorithm, "weinberger")) {
+                        settings_set_hash_algorithm(HASH_WEINBERGER);
+                    } else if (strings_match(algorithm, "sedgewick")) {
+                        settings_set_hash_algorithm(HASH_SEDGEWICK);
+                    } else if (strings_match(algorithm, "trivial")) {
+                        settings_set_hash_algorithm(HASH_TRIVIAL);
+                    } else {
+                        fprintf(stderr, "[Error] %s (%s)\n", "Unknown hash function", algorithm);
+                        exit(EXIT_FAILURE);
+                    }
+                } break;
+
+                case OPTION_JOIN: {
+                    settings_set_join(TRUE);
+                } break;
+
+                case OPTION_TOP: {
+                    const char* value = option_value(argc, argv, &i);
+
+                    char* end = NULL;
+
+                    unsigned long long top = strtoull(value, &end, 10);
+
+                    if ((end == value) || (*end != '\0') || (top == 0) || (value[0] == '-')) {
+                        fprintf(stderr, "[Error] %s (%s)\n", "Invalid number of words", value);
+                        exit(EXIT_FAILURE);
+                    }
+
+                    settings_set_top((size_t) top);
+                } break;
+
+                case OPTION_METRIC: {
+                    const char* metric = option_value(argc, argv, &i);
+
+                    if (strings_match(metric, "harmonic")) {
+                        settings_set_metric(METRIC_HARMONIC);
+                    } else if (strings_match(metric, "geometric")) {
+                        settings_set_metric(METRIC_GEOMETRIC);
+                    } else if (strings_match(metric, "min")) {
+                        settings_set_metric(METRIC_MINIMUM);
+                    } else {
+                        fprintf(stderr, "[Error] %s (%s)\n", "Unknown metric", metric);
+                        exit(EXIT_FAILURE);
+                    }
+                } break;
+
+                case OPTION_MATRIX: {
+                    settings_set_matrix(TRUE);
+                } break;
+
+                case OPTION_STATS: {
+                    settings_set_stats(TRUE);
+                } break;
+
+                case OPTION_PERF_COUNTERS: {
+                    settings_set_perf_counters(TRUE);
+                } break;
+
+                case OPTION_TRACE: {
+                    settings_set_trace(option_value(argc, argv, &i));
+                } break;
+
+                case OPTION_PROGRESS: {
+                    settings_set_progress(TRUE);
+                } break;
+
+                case OPTION_COMBINE: {
+                    settings_set_combine(TRUE);
+                } break;
+
+                case OPTION_QUEUE_DEPTH: {
+                    const char* value = option_value(argc, argv, &i);
+
+                    /** The kernel caps the number of entries in a ring, and
+                     *  every read in flight needs a whole chunk's worth of
+                     *  buffer, so there is no point in going much deeper.
+                     * 
+                     */
+                    char* end = NULL;
+
+                    long queue_depth = strtol(value, &end, 10);
+
+                    if ((end == value) || (*end != '\0') || (queue_depth < 1) || (queue_depth > 1024)) {
+                        fprintf(stderr, "[Error] %s (%s)\n", "Invalid queue depth", value);
+                        exit(EXIT_FAILURE);
+                    }
+
+                    settings_set_queue_depth((unsigned int) queue_depth);
+                    queue_depth_specified = TRUE;
+                } break;
+
                 default: {
                     fprintf(stderr, "Invalid option id: %d\n", option_id);
                     exit(EXIT_FAILURE);
@@ -175,9 +381,18 @@ char** parse_command_line_options(int argc, char *argv[]) {
             }
         } else {
             /** Before adding the file to the parameter list, verify it exists.
+             *  The name '-' stands for standard input, which can only be read
+             *  once.
              * 
              */
-            if (!file_exists(argv[i])) {
+            if (strings_match(argv[i], "-")) {
+                if (standard_input_named) {
+                    fprintf(stderr, "[Error] %s\n", "Standard input can only be given once");
+                    exit(EXIT_FAILURE);
+                }
+
+                standard_input_named = TRUE;
+            } else if (!file_exists(argv[i])) {
                 fprintf(stderr, "[Error] %s (%s)\n", "The specified file does not exist:", argv[i]);
                 exit(EXIT_FAILURE);
             }
@@ -195,6 +410,88 @@ char** parse_command_line_options(int argc, char *argv[]) {
         settings_set_threads(2);
     }
 
+    /** The default chunk size depends on the processor's cache, so it is up to
+     *  the input module to work out.
+     * 
+     */
+    if (chunk_size_specified == FALSE) {
+        settings_set_chunk_size(default_chunk_size());
+    }
+
+    if (queue_depth_specified == FALSE) {
+        settings_set_queue_depth(4);
+    }
+
+    /** A kernel without io_uring, or with io_uring disabled, can still read
+     *  the files with 'pread', which is what the uring mode falls back to.
+     * 
+     */
+    if ((settings_get_io_mode() == IO_URING) && !uring_supported()) {
+        if (settings_get_verbose()) {
+            fprintf(stderr, "[Warning] %s\n", "io_uring is not supported, falling back on pread");
+        }
+
+        settings_set_io_mode(IO_PREAD);
+    }
+
+    /** Only the locked table mode has a global lock to keep the running
+     *  maximum coherent under, so it is the only mode the winner can be
+     *  tracked live in. The other modes only ever count.
+     * 
+     */
+    if ((settings_get_winner_mode() == WINNER_LIVE) && (settings_get_table_mode() != TABLE_LOCKED)) {
+        fprintf(stderr, "[Error] %s\n", "The live winner mode requires the locked table mode");
+        exit(EXIT_FAILURE);
+    }
+
+    /** In join mode, the words of the smaller input are all counted before a
+     *  single word of the larger one is, so the running maximum would be
+     *  meaningless until the very end anyway.
+     * 
+     */
+    if ((settings_get_winner_mode() == WINNER_LIVE) && settings_get_join()) {
+        fprintf(stderr, "[Error] %s\n", "The live winner mode cannot be combined with the join mode");
+        exit(EXIT_FAILURE);
+    }
+
+    /** The running maximum only ever holds the one word, so the top words can
+     *  only be found by scanning the table.
+     * 
+     */
+    if ((settings_get_winner_mode() == WINNER_LIVE) && settings_get_top()) {
+        fprintf(stderr, "[Error] %s\n", "The live winner mode cannot list the top words");
+        exit(EXIT_FAILURE);
+    }
+
+    /** In join mode, only the words of the smallest input ever make it into
+     *  the table, so the words shared by any pair of the other inputs would
+     *  never be seen.
+     * 
+     */
+    if (settings_get_matrix() && settings_get_join()) {
+        fprintf(stderr, "[Error] %s\n", "The matrix cannot be combined with the join mode");
+        exit(EXIT_FAILURE);
+    }
+
+    /** The matrix and the top words are two different ways of printing the
+     *  results, so only one of them can be asked for at a time.
+     * 
+     */
+    if (settings_get_matrix() && settings_get_top()) {
+        fprintf(stderr, "[Error] %s\n", "The matrix cannot be combined with the top words");
+        exit(EXIT_FAILURE);
+    }
+
+    /** The combining cache sits in front of the shared table, and neither the
+     *  local nor the partitioned mode has one, since no thread there ever
+     *  counts into a table another thread is counting into.
+     * 
+     */
+    if (settings_get_combine() && (settings_get_table_mode() != TABLE_LOCKED) && (settings_get_table_mode() != TABLE_LOCKFREE)) {
+        fprintf(stderr, "[Error] %s\n", "Combining requires the locked or lock-free table mode");
+        exit(EXIT_FAILURE);
+    }
+
     /** If the user elected to receive verbose execution information, let them
      *  know how many threads will be used.
      * 
@@ -216,11 +513,13 @@ char** parse_command_line_options(int argc, char *argv[]) {
      *  made it to this point in the subroutine.
      * 
      */
-    if (number_of_non_option_arguments != 2) {
+    if (number_of_non_option_arguments < 2) {
         print_usage(ERROR);
         exit(EXIT_FAILURE);
     }
 
+    settings_set_number_of_inputs(number_of_non_option_arguments);
+
     return arguments;
 }
 
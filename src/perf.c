@@ -0,0 +1,420 @@
+
+#include "common.h"
+
+/** The perf events header is only needed here, and like the io_uring header,
+ *  it is kept out of common.h, since the rest of the program only ever deals
+ *  with the counts.
+ * 
+ */
+#include <linux/perf_event.h>
+
+static const char* perf_event_names[] = { "Cycles", "Instructions", "LLC misses", "Branch misses", "dTLB misses" };
+
+static const char* perf_phase_names[] = { "none", "read", "tokenize", "insert", "scan" };
+
+/** This function returns the attributes of the given event, counted in user
+ *  space only, since the kernel's share of the work is not what is being
+ *  tuned, and an unprivileged process is not allowed to count it anyway. Every
+ *  event starts out disabled, and the group leader enables the whole group.
+ * 
+ */
+static struct perf_event_attr perf_event_attributes(perf_event_t event, int inherit) {
+    struct perf_event_attr attributes;
+
+    memset(&attributes, 0, sizeof (attributes));
+
+    attributes.size           = sizeof (attributes);
+    attributes.disabled       = TRUE;
+    attributes.inherit        = (inherit) ? TRUE : FALSE;
+    attributes.exclude_kernel = TRUE;
+    attributes.exclude_hv     = TRUE;
+
+    switch (event) {
+        case PERF_CYCLES: {
+            attributes.type   = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+        } break;
+
+        case PERF_INSTRUCTIONS: {
+            attributes.type   = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+        } break;
+
+        case PERF_LLC_MISSES: {
+            attributes.type   = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        } break;
+
+        case PERF_BRANCH_MISSES: {
+            attributes.type   = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+        } break;
+
+        case PERF_DTLB_MISSES:
+        default: {
+            attributes.type   = PERF_TYPE_HW_CACHE;
+            attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        } break;
+    }
+
+    return attributes;
+}
+
+static inline int perf_event_open(struct perf_event_attr* attributes, int group_descriptor) {
+    return (int) syscall(__NR_perf_event_open, attributes, 0, -1, group_descriptor, 0);
+}
+
+/** A group is one thread's set of counters, one per event, with the first
+ *  event that could be opened as the leader. An event that could not be
+ *  opened has a descriptor of -1. Each counter's page is mapped in whenever
+ *  the kernel allows it, which on x86 lets a thread read the counter with a
+ *  single 'rdpmc' instruction, rather than with a system call.
+ * 
+ */
+struct perf_group_t {
+    int descriptors[NUMBER_OF_PERF_EVENTS];
+    struct perf_event_mmap_page* pages[NUMBER_OF_PERF_EVENTS];
+    uint64_t last[NUMBER_OF_PERF_EVENTS];
+    perf_phase_t phase;
+    struct perf_counts_t* counts;
+};
+
+static struct perf_counts_t* all_perf_counts = NULL;
+static size_t number_of_perf_threads = 0;
+
+static int perf_events_available[NUMBER_OF_PERF_EVENTS];
+
+static struct perf_counts_t scan_counts;
+
+static __thread struct perf_group_t thread_group;
+static __thread int thread_group_open = FALSE;
+
+static struct perf_group_t scan_group;
+
+/** This function opens every available event in a group, and maps in their
+ *  pages, if asked to. It returns FALSE if not a single event could be opened.
+ * 
+ */
+__attribute__((nonnull(1)))
+static int open_perf_group(struct perf_group_t* group, int inherit, int map_pages) {
+    int leader = -1;
+
+    memset(group, 0, sizeof (struct perf_group_t));
+
+    for (size_t event = 0; event < NUMBER_OF_PERF_EVENTS; ++event) {
+        group->descriptors[event] = -1;
+
+        if (all_perf_counts && !perf_events_available[event]) {
+            continue;
+        }
+
+        struct perf_event_attr attributes = perf_event_attributes((perf_event_t) event, inherit);
+
+        group->descriptors[event] = perf_event_open(&attributes, leader);
+
+        if (group->descriptors[event] == -1) {
+            continue;
+        }
+
+        if (leader == -1) {
+            leader = group->descriptors[event];
+        }
+
+        if (map_pages) {
+            void* page = mmap(NULL, (size_t) sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, group->descriptors[event], 0);
+
+            group->pages[event] = (page == MAP_FAILED) ? NULL : page;
+        }
+    }
+
+    if (leader == -1) {
+        return FALSE;
+    }
+
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    return TRUE;
+}
+
+__attribute__((nonnull(1)))
+static void close_perf_group(struct perf_group_t* group) {
+    for (size_t event = 0; event < NUMBER_OF_PERF_EVENTS; ++event) {
+        if (group->pages[event]) {
+            munmap(group->pages[event], (size_t) sysconf(_SC_PAGESIZE));
+        }
+
+        if (group->descriptors[event] != -1) {
+            close(group->descriptors[event]);
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t read_performance_counter(unsigned int counter) {
+    unsigned int low, high;
+
+    __asm__ volatile ("rdpmc" : "=a" (low), "=d" (high) : "c" (counter));
+
+    return ((uint64_t) high << 32) | low;
+}
+#endif // __x86_64__ || __i386__
+
+/** This function reads a single counter. The counter's page holds its count
+ *  as of the last time the kernel saved it, along with the index of the
+ *  hardware counter it is currently running on, and the count is that plus the
+ *  hardware counter's value, sign-extended from its width. The kernel bumps
+ *  the page's lock around every update, so the page is simply read again if it
+ *  changed while it was being read. Should the counter not be running on the
+ *  hardware at the moment, or should the page not allow 'rdpmc' at all, the
+ *  count is read with a system call instead.
+ * 
+ */
+static uint64_t read_perf_counter(int descriptor, const struct perf_event_mmap_page* page) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (page && page->cap_user_rdpmc) {
+        uint32_t sequence;
+        uint32_t index;
+        uint64_t count;
+
+        do {
+            sequence = __atomic_load_n(&page->lock, __ATOMIC_ACQUIRE);
+
+            index = page->index;
+            count = (uint64_t) page->offset;
+
+            if (index) {
+                const unsigned int shift = 64 - page->pmc_width;
+
+                count += (uint64_t) (((int64_t) read_performance_counter(index - 1) << shift) >> shift);
+            }
+
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while (__atomic_load_n(&page->lock, __ATOMIC_RELAXED) != sequence);
+
+        if (index) {
+            return count;
+        }
+    }
+#else
+    (void) page;
+#endif // __x86_64__ || __i386__
+
+    uint64_t count = 0;
+
+    if (read(descriptor, &count, sizeof (count)) != (ssize_t) sizeof (count)) {
+        return 0;
+    }
+
+    return count;
+}
+
+/** This function reads every counter in the group, and adds what each counted
+ *  since it was last read to the given phase.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+static void accumulate_perf_group(struct perf_group_t* group, struct perf_counts_t* counts, perf_phase_t phase) {
+    for (size_t event = 0; event < NUMBER_OF_PERF_EVENTS; ++event) {
+        if (group->descriptors[event] == -1) {
+            continue;
+        }
+
+        const uint64_t count = read_perf_counter(group->descriptors[event], group->pages[event]);
+
+        counts->counts[phase][event] += count - group->last[event];
+
+        group->last[event] = count;
+    }
+}
+
+int initialize_perf_counters(size_t number_of_threads) {
+    struct perf_group_t group;
+
+    const int opened = open_perf_group(&group, FALSE, FALSE);
+
+    for (size_t event = 0; event < NUMBER_OF_PERF_EVENTS; ++event) {
+        perf_events_available[event] = (group.descriptors[event] != -1);
+    }
+
+    close_perf_group(&group);
+
+    if (!opened) {
+        return FALSE;
+    }
+
+    if (posix_memalign((void **) &all_perf_counts, sizeof (struct perf_counts_t), number_of_threads * sizeof (struct perf_counts_t))) {
+        fatal_error("Memory allocation failure in initialize_perf_counters()");
+    }
+
+    memset(all_perf_counts, 0, number_of_threads * sizeof (struct perf_counts_t));
+
+    number_of_perf_threads = number_of_threads;
+
+    return TRUE;
+}
+
+void open_thread_perf_counters(size_t worker) {
+    if ((all_perf_counts == NULL) || (worker >= number_of_perf_threads)) {
+        return;
+    }
+
+    if (!open_perf_group(&thread_group, FALSE, TRUE)) {
+        return;
+    }
+
+    thread_group.counts = &all_perf_counts[worker];
+    thread_group.phase  = PERF_PHASE_NONE;
+
+    accumulate_perf_group(&thread_group, thread_group.counts, PERF_PHASE_NONE);
+
+    thread_group_open = TRUE;
+}
+
+void close_thread_perf_counters(void) {
+    if (!thread_group_open) {
+        return;
+    }
+
+    switch_perf_phase(PERF_PHASE_NONE);
+
+    close_perf_group(&thread_group);
+
+    thread_group_open = FALSE;
+}
+
+void switch_perf_phase(perf_phase_t phase) {
+    if (!thread_group_open || (phase == thread_group.phase)) {
+        return;
+    }
+
+    accumulate_perf_group(&thread_group, thread_group.counts, thread_group.phase);
+
+    thread_group.phase = phase;
+}
+
+void count_perf_tokens(size_t tokens) {
+    if (thread_group_open) {
+        thread_group.counts->tokens += tokens;
+    }
+}
+
+/** The scan group is inherited by every thread the main thread starts while it
+ *  is open, which is how the threads that scan and merge the table get
+ *  counted. An inherited counter can only be read with a system call, since
+ *  the page only ever holds the main thread's own count, and the counts of
+ *  the other threads are only added in once they have exited.
+ * 
+ */
+void begin_perf_scan(void) {
+    if (all_perf_counts == NULL) {
+        return;
+    }
+
+    open_perf_group(&scan_group, TRUE, FALSE);
+
+    accumulate_perf_group(&scan_group, &scan_counts, PERF_PHASE_NONE);
+}
+
+void end_perf_scan(void) {
+    if (all_perf_counts == NULL) {
+        return;
+    }
+
+    accumulate_perf_group(&scan_group, &scan_counts, PERF_PHASE_SCAN);
+
+    close_perf_group(&scan_group);
+}
+
+/** This function prints a single row of the report, for the given counts.
+ * 
+ */
+__attribute__((nonnull(2,3)))
+static void report_perf_row(const char* name, const uint64_t* counts, const struct perf_counts_t* total) {
+    fprintf(stderr, "%-10s", name);
+
+    for (size_t event = 0; event < NUMBER_OF_PERF_EVENTS; ++event) {
+        if (perf_events_available[event]) {
+            fprintf(stderr, " %16" PRIu64, counts[event]);
+        }
+    }
+
+    if (perf_events_available[PERF_CYCLES] && perf_events_available[PERF_INSTRUCTIONS]) {
+        fprintf(stderr, " %6.2f", (counts[PERF_CYCLES]) ? (double) counts[PERF_INSTRUCTIONS] / (double) counts[PERF_CYCLES] : 0.0);
+    }
+
+    for (size_t event = PERF_LLC_MISSES; event < NUMBER_OF_PERF_EVENTS; ++event) {
+        if (perf_events_available[event]) {
+            fprintf(stderr, " %20.4f", (total->tokens) ? (double) counts[event] / (double) total->tokens : 0.0);
+        }
+    }
+
+    fprintf(stderr, "\n");
+}
+
+/** The report has a row for every phase, with every thread's counts summed,
+ *  and a column for every event that could be counted, followed by the IPC
+ *  and each kind of miss per token, where the tokens are every token of the
+ *  whole run, so that the misses of every phase can be compared directly.
+ * 
+ */
+void report_perf_counters(void) {
+    if (all_perf_counts == NULL) {
+        return;
+    }
+
+    struct perf_counts_t total = scan_counts;
+
+    for (size_t i = 0; i < number_of_perf_threads; ++i) {
+        for (size_t phase = PERF_PHASE_READ; phase < PERF_PHASE_SCAN; ++phase) {
+            for (size_t event = 0; event < NUMBER_OF_PERF_EVENTS; ++event) {
+                total.counts[phase][event] += all_perf_counts[i].counts[phase][event];
+            }
+        }
+
+        total.tokens += all_perf_counts[i].tokens;
+    }
+
+    uint64_t sum[NUMBER_OF_PERF_EVENTS] = { 0 };
+
+    fprintf(stderr, "%-10s", "Phase");
+
+    for (size_t event = 0; event < NUMBER_OF_PERF_EVENTS; ++event) {
+        if (perf_events_available[event]) {
+            fprintf(stderr, " %16s", perf_event_names[event]);
+        }
+    }
+
+    if (perf_events_available[PERF_CYCLES] && perf_events_available[PERF_INSTRUCTIONS]) {
+        fprintf(stderr, " %6s", "IPC");
+    }
+
+    for (size_t event = PERF_LLC_MISSES; event < NUMBER_OF_PERF_EVENTS; ++event) {
+        if (perf_events_available[event]) {
+            char heading[32];
+
+            snprintf(heading, sizeof (heading), "%s/token", perf_event_names[event]);
+
+            fprintf(stderr, " %20s", heading);
+        }
+    }
+
+    fprintf(stderr, "\n");
+
+    for (size_t phase = PERF_PHASE_READ; phase < NUMBER_OF_PERF_PHASES; ++phase) {
+        report_perf_row(perf_phase_names[phase], total.counts[phase], &total);
+
+        for (size_t event = 0; event < NUMBER_OF_PERF_EVENTS; ++event) {
+            sum[event] += total.counts[phase][event];
+        }
+    }
+
+    report_perf_row("total", sum, &total);
+
+    fprintf(stderr, "Tokens: %zu\n", total.tokens);
+}
+
+void release_perf_counters(void) {
+    FREE(all_perf_counts);
+
+    number_of_perf_threads = 0;
+}
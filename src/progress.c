@@ -0,0 +1,219 @@
+
+#include "common.h"
+
+/** These are the counters of every thread processing the inputs, along with
+ *  the total every progress line measures them against.
+ * 
+ */
+static struct progress_counter_t* progress_counters = NULL;
+static size_t number_of_progress_counters = 0;
+
+static size_t progress_total = 0;
+
+static __thread struct progress_counter_t* thread_progress = NULL;
+
+/** The monitor thread only exits once it is told to stop, which is how it
+ *  tells the SIGUSR1 it is sent to wake it up from one sent by the user.
+ * 
+ */
+static pthread_t monitor_thread;
+
+static int monitor_running = FALSE;
+
+static int monitor_progress = FALSE;
+
+static int monitor_stopping = FALSE;
+
+void register_progress_thread(size_t worker) {
+    if (progress_counters && (worker < number_of_progress_counters)) {
+        thread_progress = &progress_counters[worker];
+    }
+}
+
+void count_progress(size_t bytes) {
+    struct progress_counter_t* counter = thread_progress;
+
+    if (counter) {
+        __atomic_store_n(&counter->bytes, counter->bytes + bytes, __ATOMIC_RELAXED);
+    }
+}
+
+static size_t progress_bytes(void) {
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < number_of_progress_counters; ++i) {
+        bytes += __atomic_load_n(&progress_counters[i].bytes, __ATOMIC_RELAXED);
+    }
+
+    return bytes;
+}
+
+/** The progress line redraws itself in place on a terminal, and otherwise
+ *  takes up a line of its own every time, so that a log of it still reads
+ *  sensibly. The throughput is over the last interval, while the ETA goes by
+ *  the throughput over the whole run so far, which is far steadier.
+ * 
+ */
+static void print_progress(size_t bytes, double rate, double elapsed, int last) {
+    const size_t total = __atomic_load_n(&progress_total, __ATOMIC_RELAXED);
+
+    const double gib = 1024.0 * 1024.0 * 1024.0;
+    const double mib = 1024.0 * 1024.0;
+
+    const int terminal = isatty(STDERR_FILENO);
+
+    fprintf(stderr, "%sProgress: %.2f GiB", (terminal) ? "\r" : "", (double) bytes / gib);
+
+    if (total) {
+        fprintf(stderr, " of %.2f GiB (%.1f%%)", (double) total / gib, 100.0 * (double) MIN(bytes, total) / (double) total);
+    }
+
+    fprintf(stderr, ", %.1f MiB/s", rate / mib);
+
+    if (total && (bytes > 0) && !last) {
+        const double remaining = (double) (total - MIN(bytes, total)) * elapsed / (double) bytes;
+
+        const unsigned long seconds = (unsigned long) remaining;
+
+        fprintf(stderr, ", ETA %lu:%02lu:%02lu", seconds / 3600, (seconds / 60) % 60, seconds % 60);
+    } else if (last) {
+        fprintf(stderr, " in %.1fs", elapsed);
+    }
+
+    if (terminal) {
+        fprintf(stderr, "\033[K");
+    }
+
+    if (!terminal || last) {
+        fprintf(stderr, "\n");
+    }
+
+    fflush(stderr);
+}
+
+/** The monitor waits for SIGUSR1 until the next progress line is due, or for
+ *  as long as it takes if there are no progress lines to print. Whatever
+ *  woke it up, it keeps the same schedule of progress lines, so a stream of
+ *  snapshots never holds them up.
+ * 
+ */
+static void* monitor_process(void* arg) {
+    (void) arg;
+
+    const int progress = monitor_progress;
+
+    sigset_t signals;
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+
+    const uint64_t interval = (uint64_t) PROGRESS_INTERVAL_MILLISECONDS * 1000000ULL;
+
+    const uint64_t start = stats_nanoseconds();
+
+    uint64_t last_report = start;
+    uint64_t next_report = start + interval;
+
+    size_t last_bytes = 0;
+
+    while (TRUE) {
+        int received = 0;
+
+        if (progress) {
+            const uint64_t now = stats_nanoseconds();
+            const uint64_t wait = (next_report > now) ? next_report - now : 0;
+
+            const struct timespec timeout = { (time_t) (wait / 1000000000ULL), (long) (wait % 1000000000ULL) };
+
+            received = sigtimedwait(&signals, NULL, &timeout);
+        } else {
+            received = sigwaitinfo(&signals, NULL);
+        }
+
+        if (__atomic_load_n(&monitor_stopping, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        if (received == SIGUSR1) {
+            if (progress && isatty(STDERR_FILENO)) {
+                fprintf(stderr, "\n");
+            }
+
+            report_table_snapshot();
+        } else if ((received == -1) && (errno == EAGAIN)) {
+            const uint64_t now = stats_nanoseconds();
+            const size_t bytes = progress_bytes();
+
+            print_progress(bytes, (double) (bytes - last_bytes) * 1e9 / (double) (now - last_report), (double) (now - start) / 1e9, FALSE);
+
+            last_report = now;
+            last_bytes  = bytes;
+            next_report = MAX(next_report + interval, now);
+        }
+    }
+
+    if (progress) {
+        const double elapsed = (double) (stats_nanoseconds() - start) / 1e9;
+        const size_t bytes   = progress_bytes();
+
+        print_progress(bytes, (elapsed > 0.0) ? (double) bytes / elapsed : 0.0, elapsed, TRUE);
+    }
+
+    return NULL;
+}
+
+void set_progress_total(size_t total_bytes) {
+    __atomic_store_n(&progress_total, total_bytes, __ATOMIC_RELAXED);
+}
+
+void start_monitor(size_t number_of_threads) {
+    monitor_progress = settings_get_progress();
+
+    if (monitor_progress) {
+        if (posix_memalign((void **) &progress_counters, sizeof (struct progress_counter_t), number_of_threads * sizeof (struct progress_counter_t))) {
+            fatal_error("Memory allocation failure in start_monitor()");
+        }
+
+        memset(progress_counters, 0, number_of_threads * sizeof (struct progress_counter_t));
+
+        number_of_progress_counters = number_of_threads;
+    }
+
+    sigset_t signals;
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+
+    if (pthread_sigmask(SIG_BLOCK, &signals, NULL)) {
+        fatal_error("Could not block SIGUSR1");
+    }
+
+    /** The monitor is started with the default attributes rather than the
+     *  workers' minimal stack, since a snapshot formats its output with the
+     *  standard library, which needs the room.
+     * 
+     */
+    if (pthread_create(&monitor_thread, NULL, monitor_process, NULL)) {
+        fatal_error("Could not create monitor thread");
+    }
+
+    monitor_running = TRUE;
+}
+
+void stop_monitor(void) {
+    if (monitor_running) {
+        __atomic_store_n(&monitor_stopping, TRUE, __ATOMIC_RELEASE);
+
+        pthread_kill(monitor_thread, SIGUSR1);
+
+        if (pthread_join(monitor_thread, NULL)) {
+            fatal_error("Could not rejoin monitor thread");
+        }
+
+        monitor_running = FALSE;
+    }
+
+    FREE(progress_counters);
+
+    number_of_progress_counters = 0;
+}
@@ -0,0 +1,214 @@
+
+#include "common.h"
+
+int available_processors(void) {
+    cpu_set_t cpu_set;
+
+    if (sched_getaffinity(0, sizeof (cpu_set), &cpu_set) == 0) {
+        return CPU_COUNT(&cpu_set);
+    }
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (processors > 0) ? (int) processors : 1;
+}
+
+struct scheduler_t* create_scheduler(struct input_t** inputs, size_t number_of_inputs, size_t number_of_workers) {
+    struct scheduler_t* scheduler = malloc(sizeof (struct scheduler_t));
+
+    if (scheduler == NULL) {
+        fatal_error("Memory allocation failure in create_scheduler()");
+    }
+
+    scheduler->inputs            = malloc(number_of_inputs * sizeof (struct input_t *));
+    scheduler->number_of_inputs  = number_of_inputs;
+    scheduler->deques            = NULL;
+    scheduler->number_of_workers = number_of_workers;
+
+    if ((scheduler->inputs == NULL) && (number_of_inputs > 0)) {
+        fatal_error("Memory allocation failure in create_scheduler()");
+    }
+
+    if (number_of_inputs > 0) {
+        memcpy(scheduler->inputs, inputs, number_of_inputs * sizeof (struct input_t *));
+    }
+
+    if (posix_memalign((void **) &scheduler->deques, sizeof (struct task_deque_t), number_of_workers * sizeof (struct task_deque_t))) {
+        fatal_error("Memory allocation failure in create_scheduler()");
+    }
+
+    for (size_t i = 0; i < number_of_workers; ++i) {
+        if (pthread_mutex_init(&scheduler->deques[i].lock, NULL)) {
+            fatal_error("Failed to initialize task deque lock");
+        }
+
+        scheduler->deques[i].top    = 0;
+        scheduler->deques[i].bottom = 0;
+    }
+
+    return scheduler;
+}
+
+/** The deque is a plain array rather than a ring, since it is only ever
+ *  refilled by its owner once it is empty, at which point both ends are reset
+ *  to the start of the array.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+static int pop_task(struct task_deque_t* deque, struct task_t* task) {
+    int popped = FALSE;
+
+    timed_mutex_lock(&deque->lock, LOCK_SCHEDULER);
+
+    if (deque->bottom > deque->top) {
+        *task = deque->tasks[--deque->bottom];
+        popped = TRUE;
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return popped;
+}
+
+/** This function claims up to a deque's worth of chunks from the worker's
+ *  inputs, starting with the input the worker was assigned and moving on to
+ *  the next one whenever an input runs out. The first chunk claimed is handed
+ *  straight back to the worker, and the rest are queued in its deque, where
+ *  they are up for grabs by any other worker that runs out of work.
+ * 
+ *  The chunks are claimed before the deque is locked, so that a thief never
+ *  has to wait on an input's lock along with the deque's.
+ * 
+ *  Claiming a chunk of a stream means waiting for its reader to get to it,
+ *  so streams are only claimed from once nothing else is left, and only a
+ *  single chunk at a time, since every chunk of a stream sitting in a deque is
+ *  a buffer its reader cannot fill.
+ * 
+ */
+__attribute__((nonnull(1,3)))
+static int refill_tasks(struct scheduler_t* scheduler, size_t worker, struct task_t* task) {
+    struct task_t claimed[TASK_DEQUE_CAPACITY];
+
+    size_t number_claimed = 0;
+
+    for (size_t i = 0; (i < scheduler->number_of_inputs) && (number_claimed < TASK_DEQUE_CAPACITY); ++i) {
+        struct input_t* input = scheduler->inputs[(worker + i) % scheduler->number_of_inputs];
+
+        if (input->stream) {
+            continue;
+        }
+
+        while ((number_claimed < TASK_DEQUE_CAPACITY) && claim_input_chunk(input, &claimed[number_claimed].chunk)) {
+            claimed[number_claimed++].input = input;
+        }
+    }
+
+    for (size_t i = 0; (i < scheduler->number_of_inputs) && (number_claimed == 0); ++i) {
+        struct input_t* input = scheduler->inputs[(worker + i) % scheduler->number_of_inputs];
+
+        if (input->stream && claim_input_chunk(input, &claimed[number_claimed].chunk)) {
+            claimed[number_claimed++].input = input;
+        }
+    }
+
+    if (number_claimed == 0) {
+        return FALSE;
+    }
+
+    *task = claimed[0];
+
+    struct task_deque_t* deque = &scheduler->deques[worker];
+
+    timed_mutex_lock(&deque->lock, LOCK_SCHEDULER);
+
+    deque->top    = 0;
+    deque->bottom = 0;
+
+    for (size_t i = number_claimed - 1; i > 0; --i) {
+        deque->tasks[deque->bottom++] = claimed[i];
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return TRUE;
+}
+
+/** Once every input has been claimed in full, a worker that runs out of work
+ *  goes looking through the other workers' deques, starting with its
+ *  neighbor, and takes half of the first one it finds anything in, rounded
+ *  up. The oldest of the stolen tasks is handed back to the worker, and the
+ *  rest go into its own deque, where they can be stolen all over again.
+ * 
+ */
+__attribute__((nonnull(1,3)))
+static int steal_tasks(struct scheduler_t* scheduler, size_t worker, struct task_t* task) {
+    for (size_t i = 1; i < scheduler->number_of_workers; ++i) {
+        struct task_deque_t* victim = &scheduler->deques[(worker + i) % scheduler->number_of_workers];
+
+        struct task_t stolen[TASK_DEQUE_CAPACITY];
+
+        size_t number_stolen = 0;
+
+        timed_mutex_lock(&victim->lock, LOCK_SCHEDULER);
+
+        size_t available = victim->bottom - victim->top;
+
+        while (number_stolen < (available + 1) / 2) {
+            stolen[number_stolen++] = victim->tasks[victim->top++];
+        }
+
+        pthread_mutex_unlock(&victim->lock);
+
+        if (number_stolen == 0) {
+            continue;
+        }
+
+        *task = stolen[0];
+
+        struct task_deque_t* deque = &scheduler->deques[worker];
+
+        timed_mutex_lock(&deque->lock, LOCK_SCHEDULER);
+
+        deque->top    = 0;
+        deque->bottom = 0;
+
+        for (size_t j = number_stolen - 1; j > 0; --j) {
+            deque->tasks[deque->bottom++] = stolen[j];
+        }
+
+        pthread_mutex_unlock(&deque->lock);
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/** A worker only ever refills its deque once it is empty, and only ever
+ *  steals once every input is empty as well, so once a worker finds nothing to
+ *  steal, there is nothing left for anyone to do. Tasks can still be in flight
+ *  at that point, between being claimed and being queued, but those will be
+ *  processed by the worker that claimed them.
+ * 
+ */
+int next_task(struct scheduler_t* scheduler, size_t worker, struct task_t* task) {
+    if (pop_task(&scheduler->deques[worker], task)) {
+        return TRUE;
+    }
+
+    if (refill_tasks(scheduler, worker, task)) {
+        return TRUE;
+    }
+
+    return steal_tasks(scheduler, worker, task);
+}
+
+void free_scheduler(struct scheduler_t* scheduler) {
+    for (size_t i = 0; i < scheduler->number_of_workers; ++i) {
+        pthread_mutex_destroy(&scheduler->deques[i].lock);
+    }
+
+    FREE(scheduler->deques);
+    FREE(scheduler->inputs);
+    FREE(scheduler);
+}
@@ -0,0 +1,360 @@
+#include "common.h"
+
+/** This function calculates the geometric mean of the counts in the expected
+ *  manner: it multiplies them together and takes the nth root, by way of the
+ *  mean of their logarithms, so that the product can never overflow.
+ * 
+ *  This function is used to calculate what I called the 'commonality' of the
+ *  strings in the input files. To differentiate between many repeated
+ *  appearances of a string in one file while barely any in the other, the
+ *  geometric mean will score more favorably by a string that has about equal
+ *  representation in every file, rather than one over the other.
+ * 
+ *  A word missing from any of the files scores zero with every metric, which
+ *  is what keeps the division by zero problem out of the harmonic mean.
+ * 
+ */
+__attribute__((hot, pure, nonnull(1)))
+static double geometric_mean(const size_t* counts, size_t n) {
+    if (n == 2) {
+        return sqrt((double) counts[0] * (double) counts[1]);
+    }
+
+    double sum_of_logarithms = 0.0;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (counts[i] == 0) {
+            return 0.0;
+        }
+
+        sum_of_logarithms += log((double) counts[i]);
+    }
+
+    return exp(sum_of_logarithms / (double) n);
+}
+
+/** This function calculates the harmonic mean of the counts in the expected
+ *  manner: it divides their number by the sum of their reciprocals.
+ * 
+ *  This function is also used to calculate the commonality of the strings in
+ *  the input files, with the difference being that a higher priority is given
+ *  to strings that appeared in high amounts in every file, rather than a lot
+ *  in one file and maybe once in another, which is a weakness with the
+ *  geometric mean metric.
+ * 
+ *  The mean of two counts is computed as 2ab / (a + b) instead, which is exact
+ *  for any realistic count, just like the vectorized scan computes it, so the
+ *  two always agree on which words are tied.
+ * 
+ */
+__attribute__((hot, pure, nonnull(1)))
+static double harmonic_mean(const size_t* counts, size_t n) {
+    if (n == 2) {
+        const double a = (double) counts[0];
+        const double b = (double) counts[1];
+
+        return (2.0 * a * b) / fmax(a + b, 1.0);
+    }
+
+    double sum_of_reciprocals = 0.0;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (counts[i] == 0) {
+            return 0.0;
+        }
+
+        sum_of_reciprocals += 1.0 / (double) counts[i];
+    }
+
+    return (double) n / sum_of_reciprocals;
+}
+
+/** This metric simply scores a word by its count in the file it appears in
+ *  the least.
+ * 
+ */
+__attribute__((hot, pure, nonnull(1)))
+static double minimum_count(const size_t* counts, size_t n) {
+    size_t minimum = counts[0];
+
+    for (size_t i = 1; i < n; ++i) {
+        minimum = MIN(minimum, counts[i]);
+    }
+
+    return (double) minimum;
+}
+
+typedef double (*metric_function_t)(const size_t*, size_t);
+
+/** The metric is chosen once, along with the hash function, out of the table
+ *  of metrics below, which is in the same order as the metric enumeration.
+ * 
+ */
+static const metric_function_t metric_functions[] = { harmonic_mean, geometric_mean, minimum_count };
+
+static metric_function_t metric_function = harmonic_mean;
+
+static metric_t metric = METRIC_HARMONIC;
+
+/** The number of inputs is copied out of the settings along with the metric,
+ *  since it is the length of the count vector of every entry that is scored.
+ * 
+ */
+static size_t number_of_inputs = 2;
+
+void initialize_metric(void) {
+    metric           = settings_get_metric();
+    metric_function  = metric_functions[metric];
+    number_of_inputs = settings_get_number_of_inputs();
+}
+
+/** This function calculates the commonality score of the given string with the
+ *  chosen metric.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+double commonality(const struct table_entry_t* entry) {
+    return metric_function(entry->counts, number_of_inputs);
+}
+
+__attribute__((hot, nonnull(1)))
+double score_counts(const size_t* counts, size_t n) {
+    return metric_function(counts, n);
+}
+
+/** This function decides whether one scored entry ranks above another. Ties
+ *  are broken in favor of the word that sorts first, so the result does not
+ *  depend on where the words happened to land in the table, nor on how the
+ *  table was split up between the threads scanning it.
+ * 
+ */
+__attribute__((nonnull(1,2), pure))
+int ranks_higher(const struct scored_entry_t* a, const struct scored_entry_t* b) {
+    return (a->score > b->score) || ((a->score == b->score) && (strcmp(a->entry->word, b->entry->word) < 0));
+}
+
+/** A selection keeps the best 'capacity' entries it has been offered in a
+ *  bounded min-heap, so the lowest ranked of them is always at the root, and
+ *  offering it another entry costs O(log K) at most. Once the selection is
+ *  full, the root's score is the threshold an entry has to reach to have any
+ *  chance of getting in, which rules out nearly every entry with a single
+ *  comparison, just like the best score did back when only the most common
+ *  word was ever kept.
+ * 
+ */
+__attribute__((nonnull(1)))
+void initialize_selection(struct selection_t* selection, size_t capacity) {
+    selection->entries  = malloc(capacity * sizeof (struct scored_entry_t));
+    selection->size     = 0;
+    selection->capacity = capacity;
+
+    if (selection->entries == NULL) {
+        fatal_error("Memory allocation failure in initialize_selection()");
+    }
+}
+
+__attribute__((nonnull(1)))
+void release_selection(struct selection_t* selection) {
+    FREE(selection->entries);
+
+    selection->size     = 0;
+    selection->capacity = 0;
+}
+
+__attribute__((nonnull(1), pure))
+static inline double selection_threshold(const struct selection_t* selection) {
+    return (selection->size < selection->capacity) ? 0.0 : selection->entries[0].score;
+}
+
+__attribute__((nonnull(1,2)))
+void select_entry(struct selection_t* selection, struct table_entry_t* entry, double score) {
+    const struct scored_entry_t candidate = { entry, score };
+
+    struct scored_entry_t* heap = selection->entries;
+
+    if (selection->size < selection->capacity) {
+        size_t i = selection->size++;
+
+        while ((i > 0) && ranks_higher(&heap[(i - 1) / 2], &candidate)) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+
+        heap[i] = candidate;
+        return;
+    }
+
+    if (!ranks_higher(&candidate, &heap[0])) {
+        return;
+    }
+
+    size_t i = 0;
+
+    while (2 * i + 1 < selection->size) {
+        size_t child = 2 * i + 1;
+
+        if ((child + 1 < selection->size) && ranks_higher(&heap[child], &heap[child + 1])) {
+            ++child;
+        }
+
+        if (!ranks_higher(&candidate, &heap[child])) {
+            break;
+        }
+
+        heap[i] = heap[child];
+        i = child;
+    }
+
+    heap[i] = candidate;
+}
+
+/** This function folds every entry of one selection into another. It is how
+ *  the selections made by the threads scanning the table are combined into the
+ *  final one.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+void merge_selection(struct selection_t* selection, const struct selection_t* other) {
+    for (size_t i = 0; i < other->size; ++i) {
+        select_entry(selection, other->entries[i].entry, other->entries[i].score);
+    }
+}
+
+static int compare_scored_entries(const void* a, const void* b) {
+    const struct scored_entry_t* x = (const struct scored_entry_t *) a;
+    const struct scored_entry_t* y = (const struct scored_entry_t *) b;
+
+    if (ranks_higher(x, y)) {
+        return -1;
+    }
+
+    return (ranks_higher(y, x)) ? 1 : 0;
+}
+
+/** Sorting a selection turns its heap into a list from the highest rank down,
+ *  after which nothing more may be selected into it.
+ * 
+ */
+__attribute__((nonnull(1)))
+void sort_selection(struct selection_t* selection) {
+    qsort(selection->entries, selection->size, sizeof (struct scored_entry_t), compare_scored_entries);
+}
+
+/** This function scores a whole group of entries at once, given their counts
+ *  in exactly two files gathered into two arrays. It computes the same scores
+ *  as the metric functions do for two counts, with the harmonic mean computed
+ *  as 2ab / (a + b), which needs one division rather than three. Since both
+ *  the numerator and the denominator are exact for any realistic count, two
+ *  words whose means are equal always get equal scores, and ties are always
+ *  detected as such.
+ * 
+ *  A word missing from either file scores zero. Padding slots have both counts
+ *  set to zero, so the denominator is clamped to one to keep them from being
+ *  scored as NaN.
+ * 
+ */
+__attribute__((hot, nonnull(1,2,3)))
+static inline void score_group(const double* count1, const double* count2, double* scores) {
+#if defined(__SSE2__)
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d two = _mm_set1_pd(2.0);
+
+    for (unsigned int i = 0; i < GROUP_WIDTH; i += 2) {
+        __m128d a = _mm_loadu_pd(count1 + i);
+        __m128d b = _mm_loadu_pd(count2 + i);
+
+        __m128d score;
+
+        if (metric == METRIC_GEOMETRIC) {
+            score = _mm_sqrt_pd(_mm_mul_pd(a, b));
+        } else if (metric == METRIC_MINIMUM) {
+            score = _mm_min_pd(a, b);
+        } else {
+            __m128d numerator   = _mm_mul_pd(two, _mm_mul_pd(a, b));
+            __m128d denominator = _mm_max_pd(_mm_add_pd(a, b), one);
+
+            score = _mm_div_pd(numerator, denominator);
+        }
+
+        _mm_storeu_pd(scores + i, score);
+    }
+#else
+    for (unsigned int i = 0; i < GROUP_WIDTH; ++i) {
+        if (metric == METRIC_GEOMETRIC) {
+            scores[i] = sqrt(count1[i] * count2[i]);
+        } else if (metric == METRIC_MINIMUM) {
+            scores[i] = fmin(count1[i], count2[i]);
+        } else {
+            scores[i] = (2.0 * count1[i] * count2[i]) / fmax(count1[i] + count2[i], 1.0);
+        }
+    }
+#endif // __SSE2__
+}
+
+/** Without the running maximum maintained by 'calculate_commonality_score',
+ *  the most common word has to be found by scanning the table once every
+ *  thread has finished. This function scans the slots from 'first_slot' up to
+ *  but not including 'last_slot', both of which must be multiples of the group
+ *  width, one group at a time. The full slots in each group are picked out of
+ *  the control bytes, their counts are gathered, and the whole group is scored
+ *  at once. Only then are the scores compared against the selection's
+ *  threshold, which is rarely reached, so that branch is almost never taken.
+ *  Words with a count of zero in any file score zero, and are skipped
+ *  outright.
+ * 
+ *  Only a group of entries counted in exactly two files is scored in bulk.
+ *  With any other number of files, each entry's count vector is handed to the
+ *  metric function one entry at a time instead.
+ * 
+ */
+__attribute__((hot, nonnull(1,4)))
+void find_best_entries(const struct hash_table_t* table, size_t first_slot, size_t last_slot, struct selection_t* selection) {
+    struct table_entry_t* entries[GROUP_WIDTH];
+
+    double count1[GROUP_WIDTH];
+    double count2[GROUP_WIDTH];
+    double scores[GROUP_WIDTH];
+
+    for (size_t position = first_slot; position < last_slot; position += GROUP_WIDTH) {
+        unsigned int full = ~match_empty_slots(table->control + position) & ((1u << GROUP_WIDTH) - 1);
+
+        if (full == 0) {
+            continue;
+        }
+
+        unsigned int number_of_entries = 0;
+
+        while (full) {
+            struct table_entry_t* entry = table->slots[position + __builtin_ctz(full)];
+
+            entries[number_of_entries] = entry;
+            ++number_of_entries;
+
+            full &= full - 1;
+        }
+
+        if (number_of_inputs == 2) {
+            for (unsigned int i = 0; i < number_of_entries; ++i) {
+                count1[i] = (double) entries[i]->counts[0];
+                count2[i] = (double) entries[i]->counts[1];
+            }
+
+            for (unsigned int i = number_of_entries; i < GROUP_WIDTH; ++i) {
+                count1[i] = 0.0;
+                count2[i] = 0.0;
+            }
+
+            score_group(count1, count2, scores);
+        } else {
+            for (unsigned int i = 0; i < number_of_entries; ++i) {
+                scores[i] = commonality(entries[i]);
+            }
+        }
+
+        for (unsigned int i = 0; i < number_of_entries; ++i) {
+            if ((scores[i] > 0.0) && (scores[i] >= selection_threshold(selection))) {
+                select_entry(selection, entries[i], scores[i]);
+            }
+        }
+    }
+}
@@ -16,6 +16,74 @@ void settings_set_threads(int setting) {
     settings.threads = setting;
 }
 
+void settings_set_table_mode(table_mode_t setting) {
+    settings.table_mode = setting;
+}
+
+void settings_set_io_mode(io_mode_t setting) {
+    settings.io_mode = setting;
+}
+
+void settings_set_populate(int setting) {
+    settings.populate = setting;
+}
+
+void settings_set_chunk_size(size_t setting) {
+    settings.chunk_size = setting;
+}
+
+void settings_set_winner_mode(winner_mode_t setting) {
+    settings.winner_mode = setting;
+}
+
+void settings_set_hash_algorithm(hash_algorithm_t setting) {
+    settings.hash_algorithm = setting;
+}
+
+void settings_set_join(int setting) {
+    settings.join = setting;
+}
+
+void settings_set_top(size_t setting) {
+    settings.top = setting;
+}
+
+void settings_set_number_of_inputs(size_t setting) {
+    settings.number_of_inputs = setting;
+}
+
+void settings_set_metric(metric_t setting) {
+    settings.metric = setting;
+}
+
+void settings_set_matrix(int setting) {
+    settings.matrix = setting;
+}
+
+void settings_set_queue_depth(unsigned int setting) {
+    settings.queue_depth = setting;
+}
+
+void settings_set_stats(int setting) {
+    settings.stats = setting;
+}
+
+void settings_set_perf_counters(int setting) {
+    settings.perf_counters = setting;
+}
+
+void settings_set_trace(const char* setting) {
+    settings.trace = setting;
+}
+
+void settings_set_progress(int setting) {
+    settings.progress = setting;
+}
+
+void settings_set_combine(int setting) {
+    settings.combine = setting;
+}
+
 int settings_get_verbose(void) {
     return settings.verbose;
 }
@@ -23,3 +91,71 @@ int settings_get_verbose(void) {
 int settings_get_threads(void) {
     return settings.threads;
 }
+
+table_mode_t settings_get_table_mode(void) {
+    return settings.table_mode;
+}
+
+io_mode_t settings_get_io_mode(void) {
+    return settings.io_mode;
+}
+
+int settings_get_populate(void) {
+    return settings.populate;
+}
+
+size_t settings_get_chunk_size(void) {
+    return settings.chunk_size;
+}
+
+winner_mode_t settings_get_winner_mode(void) {
+    return settings.winner_mode;
+}
+
+hash_algorithm_t settings_get_hash_algorithm(void) {
+    return settings.hash_algorithm;
+}
+
+int settings_get_join(void) {
+    return settings.join;
+}
+
+size_t settings_get_top(void) {
+    return settings.top;
+}
+
+size_t settings_get_number_of_inputs(void) {
+    return settings.number_of_inputs;
+}
+
+metric_t settings_get_metric(void) {
+    return settings.metric;
+}
+
+int settings_get_matrix(void) {
+    return settings.matrix;
+}
+
+unsigned int settings_get_queue_depth(void) {
+    return settings.queue_depth;
+}
+
+int settings_get_stats(void) {
+    return settings.stats;
+}
+
+int settings_get_perf_counters(void) {
+    return settings.perf_counters;
+}
+
+const char* settings_get_trace(void) {
+    return settings.trace;
+}
+
+int settings_get_progress(void) {
+    return settings.progress;
+}
+
+int settings_get_combine(void) {
+    return settings.combine;
+}
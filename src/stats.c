@@ -0,0 +1,234 @@
+
+#include "common.h"
+
+static const char* lock_kind_names[] = { "table", "entry", "max", "access", "input", "scheduler" };
+
+static const char* phase_names[] = { "count", "seal", "probe", "finalize" };
+
+/** These are the counters of every thread processing the inputs, one after
+ *  the other, along with the shared set for every other thread and the times
+ *  of the phases as a whole, which only the main thread ever records.
+ * 
+ */
+static struct thread_stats_t* all_thread_stats = NULL;
+static size_t number_of_stats_threads = 0;
+
+static struct thread_stats_t shared_stats;
+
+static double run_phase_seconds[NUMBER_OF_PHASES];
+
+static __thread struct thread_stats_t* thread_stats = NULL;
+
+static __thread int thread_timed_locks = FALSE;
+
+void initialize_stats(size_t number_of_threads) {
+    if (posix_memalign((void **) &all_thread_stats, sizeof (struct thread_stats_t), number_of_threads * sizeof (struct thread_stats_t))) {
+        fatal_error("Memory allocation failure in initialize_stats()");
+    }
+
+    memset(all_thread_stats, 0, number_of_threads * sizeof (struct thread_stats_t));
+
+    number_of_stats_threads = number_of_threads;
+}
+
+void register_stats_thread(size_t worker) {
+    if (all_thread_stats && (worker < number_of_stats_threads)) {
+        thread_stats = &all_thread_stats[worker];
+        thread_timed_locks = TRUE;
+    }
+}
+
+void time_thread_locks(void) {
+    thread_timed_locks = TRUE;
+}
+
+const char* lock_kind_name(lock_kind_t kind) {
+    return lock_kind_names[kind];
+}
+
+const char* phase_name(phase_t phase) {
+    return phase_names[phase];
+}
+
+uint64_t stats_nanoseconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+double stats_clock(void) {
+    return (double) stats_nanoseconds() / 1e9;
+}
+
+void record_phase(phase_t phase, double start) {
+    if (all_thread_stats == NULL) {
+        return;
+    }
+
+    const double elapsed = stats_clock() - start;
+
+    if (thread_stats) {
+        thread_stats->phase_seconds[phase] += elapsed;
+    } else {
+        run_phase_seconds[phase] += elapsed;
+    }
+}
+
+void count_input(size_t bytes, size_t tokens) {
+    if (thread_stats) {
+        thread_stats->bytes  += bytes;
+        thread_stats->tokens += tokens;
+    }
+}
+
+void count_new_entry(void) {
+    if (thread_stats) {
+        thread_stats->new_entries += 1;
+    }
+}
+
+/** Allocations are rare enough that the threads without counters of their
+ *  own can afford to count theirs atomically.
+ * 
+ */
+void count_allocation(size_t size) {
+    if (thread_stats) {
+        thread_stats->allocations     += 1;
+        thread_stats->allocated_bytes += size;
+    } else if (all_thread_stats) {
+        __atomic_fetch_add(&shared_stats.allocations, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&shared_stats.allocated_bytes, size, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void count_lock_acquisition(lock_kind_t kind) {
+    if (thread_stats) {
+        thread_stats->lock_acquisitions[kind] += 1;
+    }
+}
+
+/** This function records a contended acquisition of a lock, which took from
+ *  'start' until now, in the calling thread's counters and in its trace,
+ *  whichever of the two it has.
+ * 
+ */
+static inline void record_lock_wait(lock_kind_t kind, uint64_t start) {
+    const uint64_t end = stats_nanoseconds();
+
+    if (thread_stats) {
+        thread_stats->lock_contentions[kind]      += 1;
+        thread_stats->lock_wait_nanoseconds[kind] += end - start;
+    }
+
+    trace_lock_wait(kind, start, end);
+}
+
+void timed_mutex_lock(pthread_mutex_t* lock, lock_kind_t kind) {
+    if (!thread_timed_locks) {
+        pthread_mutex_lock(lock);
+        return;
+    }
+
+    count_lock_acquisition(kind);
+
+    if (pthread_mutex_trylock(lock) == 0) {
+        return;
+    }
+
+    const uint64_t start = stats_nanoseconds();
+
+    pthread_mutex_lock(lock);
+
+    record_lock_wait(kind, start);
+}
+
+void timed_rwlock_rdlock(pthread_rwlock_t* lock, lock_kind_t kind) {
+    if (!thread_timed_locks) {
+        pthread_rwlock_rdlock(lock);
+        return;
+    }
+
+    count_lock_acquisition(kind);
+
+    if (pthread_rwlock_tryrdlock(lock) == 0) {
+        return;
+    }
+
+    const uint64_t start = stats_nanoseconds();
+
+    pthread_rwlock_rdlock(lock);
+
+    record_lock_wait(kind, start);
+}
+
+void timed_rwlock_wrlock(pthread_rwlock_t* lock, lock_kind_t kind) {
+    if (!thread_timed_locks) {
+        pthread_rwlock_wrlock(lock);
+        return;
+    }
+
+    count_lock_acquisition(kind);
+
+    if (pthread_rwlock_trywrlock(lock) == 0) {
+        return;
+    }
+
+    const uint64_t start = stats_nanoseconds();
+
+    pthread_rwlock_wrlock(lock);
+
+    record_lock_wait(kind, start);
+}
+
+void report_stats(void) {
+    if (all_thread_stats == NULL) {
+        return;
+    }
+
+    struct thread_stats_t total = shared_stats;
+
+    fprintf(stderr, "Phases:");
+
+    for (size_t phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+        fprintf(stderr, "%s %s %.3fs", (phase) ? "," : "", phase_names[phase], run_phase_seconds[phase]);
+    }
+
+    fprintf(stderr, "\n%6s %14s %12s %12s %12s %10s %10s\n", "Thread", "Bytes", "Tokens", "New entries", "Allocations", "Count (s)", "Probe (s)");
+
+    for (size_t i = 0; i < number_of_stats_threads; ++i) {
+        const struct thread_stats_t* stats = &all_thread_stats[i];
+
+        fprintf(stderr, "%6zu %14zu %12zu %12zu %12zu %10.3f %10.3f\n", i, stats->bytes, stats->tokens, stats->new_entries, stats->allocations, stats->phase_seconds[PHASE_COUNT], stats->phase_seconds[PHASE_PROBE]);
+
+        total.bytes           += stats->bytes;
+        total.tokens          += stats->tokens;
+        total.new_entries     += stats->new_entries;
+        total.allocations     += stats->allocations;
+        total.allocated_bytes += stats->allocated_bytes;
+
+        for (size_t kind = 0; kind < NUMBER_OF_LOCK_KINDS; ++kind) {
+            total.lock_acquisitions[kind]     += stats->lock_acquisitions[kind];
+            total.lock_contentions[kind]      += stats->lock_contentions[kind];
+            total.lock_wait_nanoseconds[kind] += stats->lock_wait_nanoseconds[kind];
+        }
+    }
+
+    fprintf(stderr, "%6s %14zu %12zu %12zu %12zu\n", "Total", total.bytes, total.tokens, total.new_entries, total.allocations);
+    fprintf(stderr, "Allocations: %zu totalling %.1f MiB\n", total.allocations, (double) total.allocated_bytes / (1024.0 * 1024.0));
+
+    for (size_t kind = 0; kind < NUMBER_OF_LOCK_KINDS; ++kind) {
+        if (total.lock_acquisitions[kind] == 0) {
+            continue;
+        }
+
+        fprintf(stderr, "Lock waits (%s): %zu of %zu acquisitions contended, %.3fs waiting\n", lock_kind_names[kind], total.lock_contentions[kind], total.lock_acquisitions[kind], (double) total.lock_wait_nanoseconds[kind] / 1e9);
+    }
+}
+
+void release_stats(void) {
+    FREE(all_thread_stats);
+
+    number_of_stats_threads = 0;
+}
@@ -17,3 +17,27 @@
 int strings_match(const char* a, const char* b) {
     return (strcmp(a, b) == 0);
 }
+
+size_t parse_size(const char* argument) {
+    char* suffix = NULL;
+
+    errno = 0;
+
+    unsigned long long size = strtoull(argument, &suffix, 10);
+
+    unsigned int shift = 0;
+
+    switch (*suffix) {
+        case 'K': case 'k': shift = 10; ++suffix; break;
+        case 'M': case 'm': shift = 20; ++suffix; break;
+        case 'G': case 'g': shift = 30; ++suffix; break;
+        default: break;
+    }
+
+    if (errno || (suffix == argument) || (*suffix != '\0') || (size == 0) || (size > (SIZE_MAX >> shift)) || (*argument == '-')) {
+        fprintf(stderr, "[Error] %s (%s)\n", "Invalid size", argument);
+        exit(EXIT_FAILURE);
+    }
+
+    return (size_t) (size << shift);
+}
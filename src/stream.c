@@ -0,0 +1,287 @@
+
+#include "common.h"
+
+/** Waiting on a semaphore can be interrupted by a signal, in which case the
+ *  wait simply starts over.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void wait_for_semaphore(sem_t* semaphore) {
+    while (sem_wait(semaphore) == -1) {
+        if (errno != EINTR) {
+            fatal_error("Failed to wait on stream semaphore");
+        }
+    }
+}
+
+/** The reader grows a slot's buffer whenever the carried-over part of a word
+ *  and a whole chunk after it will not fit, keeping the first 'used' bytes.
+ *  Only the reader ever touches a slot it is waiting to fill, so the buffer
+ *  can be replaced freely. The buffer is allocated with the stream's
+ *  alignment, which 'realloc' cannot promise to keep, so it is copied by hand.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+static void reserve_slot(const struct stream_t* stream, struct stream_slot_t* slot, size_t capacity, size_t used) {
+    if (slot->capacity >= capacity) {
+        return;
+    }
+
+    char* data = NULL;
+
+    if (posix_memalign((void **) &data, MAX(stream->alignment, sizeof (void *)), capacity)) {
+        fatal_error("Memory allocation failure in reserve_slot()");
+    }
+
+    if (used) {
+        memcpy(data, slot->data, used);
+    }
+
+    FREE(slot->data);
+
+    slot->data     = data;
+    slot->capacity = capacity;
+}
+
+/** This function reads from the stream until the slot holds 'target' bytes,
+ *  since a pipe hands back no more than its own buffer's worth at a time,
+ *  returning FALSE once the stream has nothing left to read. A direct read of
+ *  a regular file only ever comes back short at the end of the file, and the
+ *  next read would not be aligned anyway, so that ends the stream right away.
+ * 
+ */
+__attribute__((nonnull(1,2,3)))
+static int fill_slot(const struct stream_t* stream, struct stream_slot_t* slot, size_t* length, size_t target) {
+    while (*length < target) {
+        ssize_t bytes_read = read(stream->file_descriptor, slot->data + *length, target - *length);
+
+        if (bytes_read == 0) {
+            return FALSE;
+        }
+
+        if (bytes_read == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "[Error] %s (%s)\n", strerror(errno), stream->filename);
+            exit(EXIT_FAILURE);
+        }
+
+        *length += (size_t) bytes_read;
+
+        if ((stream->alignment > 1) && ((size_t) bytes_read % stream->alignment)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/** This function returns the length of the longest prefix of the buffer that
+ *  ends on a word boundary, which is zero if the whole buffer is one word.
+ * 
+ */
+__attribute__((nonnull(1)))
+static size_t find_last_boundary(const char* data, size_t length) {
+    while ((length > 0) && is_word_character(data[length - 1])) {
+        --length;
+    }
+
+    return length;
+}
+
+/** Once the stream has ended, the reader fills every slot in the ring with
+ *  an empty buffer, in order, starting with the one after the last buffer it
+ *  filled. A thread that finds an empty buffer posts it right back, so that
+ *  any other thread waiting on the same slot finds it too.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void mark_end_of_stream(struct stream_t* stream, size_t position) {
+    for (size_t i = 0; i < STREAM_RING_SIZE; ++i) {
+        struct stream_slot_t* slot = &stream->slots[(position + i) % STREAM_RING_SIZE];
+
+        wait_for_semaphore(&slot->emptied);
+
+        slot->length = 0;
+
+        sem_post(&slot->filled);
+    }
+}
+
+/** The reader fills the slots in order, each with the chunk size's worth of
+ *  the stream on top of whatever was carried over from the last one. The
+ *  buffer is then cut short at its last word boundary, and the rest of it is
+ *  carried over, so no word is ever split between two buffers. Should the
+ *  buffer hold no boundary at all, it is simply grown by another chunk and
+ *  read into again, so a word longer than a chunk stays whole.
+ * 
+ *  The stream is read into each buffer at an aligned offset, in multiples of
+ *  the alignment, with the carried-over word copied in just before it, so for
+ *  direct reads, the chunk in a slot begins wherever that word does.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void* stream_reader_thread(void* arg) {
+    struct stream_t* stream = (struct stream_t *) arg;
+
+    const size_t read_size = roundup(settings_get_chunk_size(), stream->alignment);
+
+    char* carry = NULL;
+    size_t carry_length = 0;
+
+    size_t position = 0;
+
+    while (TRUE) {
+        struct stream_slot_t* slot = &stream->slots[position % STREAM_RING_SIZE];
+
+        wait_for_semaphore(&slot->emptied);
+
+        const size_t begin = roundup(carry_length, stream->alignment) - carry_length;
+
+        size_t length = begin + carry_length;
+        size_t target = length + read_size;
+
+        reserve_slot(stream, slot, target, 0);
+
+        if (carry_length) {
+            memcpy(slot->data + begin, carry, carry_length);
+        }
+
+        int more = TRUE;
+        size_t boundary = begin;
+
+        while ((more = fill_slot(stream, slot, &length, target))) {
+            if ((boundary = begin + find_last_boundary(slot->data + begin, length - begin)) > begin) {
+                break;
+            }
+
+            target += read_size;
+
+            reserve_slot(stream, slot, target, length);
+        }
+
+        if (more == FALSE) {
+            boundary = length;
+        }
+
+        carry_length = length - boundary;
+
+        if (carry_length) {
+            char* data = realloc(carry, carry_length);
+
+            if (data == NULL) {
+                fatal_error("Memory allocation failure in stream_reader_thread()");
+            }
+
+            carry = data;
+
+            memcpy(carry, slot->data + boundary, carry_length);
+        }
+
+        slot->begin  = begin;
+        slot->length = boundary - begin;
+
+        if (slot->length) {
+            sem_post(&slot->filled);
+            ++position;
+        } else {
+            sem_post(&slot->emptied);
+        }
+
+        if (more == FALSE) {
+            break;
+        }
+    }
+
+    FREE(carry);
+
+    mark_end_of_stream(stream, position);
+
+    return NULL;
+}
+
+struct stream_t* open_stream(int file_descriptor, const char* filename, size_t alignment) {
+    struct stream_t* stream = malloc(sizeof (struct stream_t));
+
+    if (stream == NULL) {
+        fatal_error("Memory allocation failure in open_stream()");
+    }
+
+    stream->filename        = filename;
+    stream->file_descriptor = file_descriptor;
+    stream->alignment       = alignment;
+    stream->next_slot       = 0;
+
+    for (size_t i = 0; i < STREAM_RING_SIZE; ++i) {
+        stream->slots[i].data     = NULL;
+        stream->slots[i].begin    = 0;
+        stream->slots[i].length   = 0;
+        stream->slots[i].capacity = 0;
+
+        if (sem_init(&stream->slots[i].filled, 0, 0) || sem_init(&stream->slots[i].emptied, 0, 1)) {
+            fatal_error("Failed to initialize stream semaphores");
+        }
+    }
+
+    if (pthread_create(&stream->reader, NULL, stream_reader_thread, stream)) {
+        fatal_error("Could not create stream reader thread");
+    }
+
+    return stream;
+}
+
+/** Two threads can end up waiting on the same slot, if one of them claimed it
+ *  a whole ring's worth of buffers after the other, and whichever of them
+ *  wakes up first gets the buffer. Every buffer is still processed exactly
+ *  once, and since the order the words are counted in makes no difference,
+ *  neither does which thread processes it.
+ * 
+ */
+int claim_stream_chunk(struct stream_t* stream, struct chunk_t* chunk) {
+    const size_t position = __atomic_fetch_add(&stream->next_slot, 1, __ATOMIC_RELAXED);
+
+    struct stream_slot_t* slot = &stream->slots[position % STREAM_RING_SIZE];
+
+    wait_for_semaphore(&slot->filled);
+
+    if (slot->length == 0) {
+        sem_post(&slot->filled);
+        return FALSE;
+    }
+
+    chunk->start  = (off_t) (position % STREAM_RING_SIZE);
+    chunk->length = slot->length;
+
+    return TRUE;
+}
+
+const char* stream_chunk_data(const struct stream_t* stream, const struct chunk_t* chunk) {
+    return stream->slots[chunk->start].data + stream->slots[chunk->start].begin;
+}
+
+void release_stream_chunk(struct stream_t* stream, const struct chunk_t* chunk) {
+    sem_post(&stream->slots[chunk->start].emptied);
+}
+
+void close_stream(struct stream_t* stream) {
+    struct chunk_t chunk;
+
+    while (claim_stream_chunk(stream, &chunk)) {
+        release_stream_chunk(stream, &chunk);
+    }
+
+    if (pthread_join(stream->reader, NULL)) {
+        fatal_error("Could not rejoin stream reader thread");
+    }
+
+    for (size_t i = 0; i < STREAM_RING_SIZE; ++i) {
+        sem_destroy(&stream->slots[i].filled);
+        sem_destroy(&stream->slots[i].emptied);
+
+        FREE(stream->slots[i].data);
+    }
+
+    FREE(stream);
+}
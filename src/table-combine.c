@@ -0,0 +1,151 @@
+#include "common.h"
+
+#ifndef COMBINING_CACHE_SIZE
+/** The number of slots in every thread's combining cache. This must be a power
+ *  of two, since the slot is taken from the bottom bits of the hash. At forty
+ *  bytes a slot, the whole cache fits comfortably in the L1 cache, and it is
+ *  still enough to hold the few hundred words that make up most of any text.
+ * 
+ */
+#define COMBINING_CACHE_SIZE (512)
+#else
+#error "COMBINING_CACHE_SIZE already defined."
+#endif // COMBINING_CACHE_SIZE
+
+#ifndef COMBINING_CACHE_MAX_HITS
+/** A word in a combining cache has to be missed this many times in a row,
+ *  net of its own hits, before another word can evict it. See 'cached_count_t'.
+ * 
+ */
+#define COMBINING_CACHE_MAX_HITS (8)
+#else
+#error "COMBINING_CACHE_MAX_HITS already defined."
+#endif // COMBINING_CACHE_MAX_HITS
+
+/** With '--combine', every thread counting into the shared table keeps a small
+ *  direct-mapped cache of the short words it has seen most recently, along
+ *  with how many times it has seen each of them in a given file since it last
+ *  added them to the table. Seeing a cached word again only bumps the pending
+ *  count in the thread's own cache, without touching the table, the table
+ *  lock, or the entry at all. The pending count is only added to the entry
+ *  when the word is evicted by another, or when the thread reaches the end of
+ *  its stretch of table access, which is to say the end of every chunk, so the
+ *  counts in the table are exact by the time every thread has been joined.
+ * 
+ *  A cached word is matched on its length and its inline copy alone, which
+ *  holds the whole of a short word, so a cached word is never compared against
+ *  its entry, and its hash is only used to pick the slot. Long words are rare
+ *  enough that they simply go straight to the table.
+ * 
+ *  Every slot also keeps a small count of its recent hits, which every miss
+ *  on the slot wears down by one, and a word is only evicted once it has worn
+ *  down to zero. Otherwise, the missing word is counted in the table directly,
+ *  so a rare word passing through never pushes a frequent one out of the
+ *  cache, and the cache mostly ends up holding exactly the words it is for.
+ *  The entries never move, even when the table grows, so the cached pointers
+ *  stay valid throughout.
+ * 
+ */
+struct cached_count_t {
+    uint64_t inline_word[INLINE_WORD_SIZE / sizeof (uint64_t)];
+    struct table_entry_t* entry;
+    uint16_t length;
+    uint16_t hits;
+    int file;
+    size_t pending;
+};
+
+struct combining_cache_t {
+    struct cached_count_t slots[COMBINING_CACHE_SIZE];
+} __attribute__((aligned(64)));
+
+static struct combining_cache_t* combining_caches = NULL;
+
+/** The caches are allocated all at once, one for every thread, and each of
+ *  them is only ever touched by the thread that claimed it.
+ * 
+ */
+void initialize_combining_caches(int number_of_threads) {
+    if (posix_memalign((void **) &combining_caches, __alignof__ (struct combining_cache_t), (size_t) number_of_threads * sizeof (struct combining_cache_t))) {
+        fatal_error("Memory allocation failure in initialize_combining_caches()");
+    }
+
+    memset(combining_caches, 0, (size_t) number_of_threads * sizeof (struct combining_cache_t));
+}
+
+__attribute__((returns_nonnull))
+struct combining_cache_t* claim_combining_cache(int thread) {
+    return &combining_caches[thread];
+}
+
+__attribute__((nonnull(1)))
+static inline void flush_cached_count(struct cached_count_t* slot) {
+    if (slot->pending) {
+        add_reference_counts(slot->entry, slot->file, slot->pending);
+        slot->pending = 0;
+    }
+}
+
+__attribute__((nonnull(1)))
+void flush_combining_cache(struct combining_cache_t* cache) {
+    for (size_t i = 0; i < COMBINING_CACHE_SIZE; ++i) {
+        flush_cached_count(&cache->slots[i]);
+    }
+}
+
+/** This function counts a short word through the calling thread's combining
+ *  cache. A word already in its slot costs a comparison and an increment. Any
+ *  other word is looked up, or inserted, in the table as usual. If the word in
+ *  its slot has not been hit recently, the new word takes its place, after the
+ *  evicted word's pending count has been added to its entry, and its count is
+ *  left pending in the cache. Otherwise, it is counted in the table right away.
+ * 
+ */
+__attribute__((hot, nonnull(1,2), returns_nonnull))
+struct table_entry_t* combine_word(struct combining_cache_t* cache, struct table_key_t* key, int file) {
+    struct cached_count_t* slot = &cache->slots[key->hash & (COMBINING_CACHE_SIZE - 1)];
+
+    if (slot->entry && (slot->length == key->length) && (slot->file == file) && (slot->inline_word[0] == key->inline_word[0]) && (slot->inline_word[1] == key->inline_word[1])) {
+        ++slot->pending;
+
+        if (slot->hits < COMBINING_CACHE_MAX_HITS) {
+            ++slot->hits;
+        }
+
+        return slot->entry;
+    }
+
+    struct table_entry_t* entry = find_or_insert_shared_word(key);
+
+    if (slot->hits) {
+        --slot->hits;
+
+        add_reference_counts(entry, file, 1);
+
+        return entry;
+    }
+
+    flush_cached_count(slot);
+
+    slot->inline_word[0] = key->inline_word[0];
+    slot->inline_word[1] = key->inline_word[1];
+    slot->entry          = entry;
+    slot->length         = (uint16_t) key->length;
+    slot->hits           = 0;
+    slot->file           = file;
+    slot->pending        = 1;
+
+    return entry;
+}
+
+void release_combining_caches(void) {
+    FREE(combining_caches);
+}
+
+#if defined(COMBINING_CACHE_MAX_HITS)
+#undef COMBINING_CACHE_MAX_HITS
+#endif
+
+#if defined(COMBINING_CACHE_SIZE)
+#undef COMBINING_CACHE_SIZE
+#endif
@@ -0,0 +1,293 @@
+#include "common.h"
+
+/** In local mode, every thread counts into a table of its own, which no other
+ *  thread touches until every thread has finished, so neither the table nor
+ *  its entries need any synchronization whatsoever. The tables are padded out
+ *  to a cache line so that one thread bumping its table's size doesn't evict
+ *  the header of its neighbor's.
+ * 
+ *  Once the counting threads have been joined, the local tables are merged in
+ *  parallel. The hash space is split into one contiguous range per thread, and
+ *  each range is merged into a table of its own by a separate thread. Those
+ *  merged tables then take the place of the shared table.
+ * 
+ */
+struct local_table_t {
+    struct hash_table_t table;
+} __attribute__((aligned(64)));
+
+static struct local_table_t* local_tables = NULL;
+
+static int number_of_local_tables = 0;
+
+/** The number of inputs is copied out of the settings along with the number of
+ *  tables, since merging an entry means adding up its whole count vector.
+ * 
+ */
+static size_t number_of_inputs = 2;
+
+/** The local tables themselves are only allocated once a thread claims one,
+ *  so a thread that never sees any input costs nothing but the header.
+ * 
+ */
+void initialize_local_tables(int number_of_threads) {
+    number_of_local_tables = number_of_threads;
+    number_of_inputs       = settings_get_number_of_inputs();
+
+    if (posix_memalign((void **) &local_tables, sizeof (struct local_table_t), (size_t) number_of_local_tables * sizeof (struct local_table_t))) {
+        fatal_error("Memory allocation failure in initialize_local_tables()");
+    }
+
+    memset(local_tables, 0, (size_t) number_of_local_tables * sizeof (struct local_table_t));
+}
+
+__attribute__((returns_nonnull))
+struct hash_table_t* claim_local_table(int thread, hash_t seed) {
+    struct hash_table_t* table = &local_tables[thread].table;
+
+    table->seed       = seed;
+    table->reseedable = TRUE;
+
+    allocate_table_storage(table, TABLE_INITIAL_CAPACITY);
+
+    return table;
+}
+
+/** A snapshot can only ever see how many entries each local table holds, since
+ *  every one of them may be growing while it looks.
+ * 
+ */
+size_t local_table_entries(void) {
+    size_t entries = 0;
+
+    for (int i = 0; i < number_of_local_tables; ++i) {
+        entries += __atomic_load_n(&local_tables[i].table.size, __ATOMIC_RELAXED);
+    }
+
+    return entries;
+}
+
+/** This is the state of a single thread merging one hash range of the local
+ *  tables. The thread builds a table of its own for the range, and finds the
+ *  best entries in it while it has the table in cache.
+ * 
+ */
+struct merge_range_t {
+    size_t range;
+    size_t ranges;
+    hash_t seed;
+    int find_words;
+    struct hash_table_t* table;
+    struct selection_t selection;
+} __attribute__((aligned(64)));
+
+/** This function folds a single entry from a local table into the merged
+ *  table. The first entry seen for a word is adopted by the merged table as
+ *  is, and the counts of every later entry for the same word are added to it.
+ *  The merged table belongs to the calling thread, so none of this needs any
+ *  synchronization.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+static void merge_entry(struct hash_table_t* table, struct table_entry_t* entry) {
+    int found = FALSE;
+
+    const struct table_key_t key = {
+        .word        = entry->word,
+        .length      = entry->length,
+        .hash        = entry->hash,
+        .seed        = table->seed,
+        .inline_word = { entry->inline_word[0], entry->inline_word[1] }
+    };
+
+    size_t slot = probe_table(table, &key, &found);
+
+    if (found) {
+        for (size_t i = 0; i < number_of_inputs; ++i) {
+            table->slots[slot]->counts[i] += entry->counts[i];
+        }
+
+        return;
+    }
+
+    if (table->size + 1 > table->growth_limit) {
+        grow_table(table);
+        slot = probe_table(table, &key, &found);
+    }
+
+    set_control_byte(table, slot, control_byte(entry->hash));
+    table->slots[slot] = entry;
+    ++table->size;
+}
+
+/** Every local table takes the home slot of an entry from the top bits of its
+ *  hash, so the entries in a given hash range all have their home slots in one
+ *  contiguous run of slots. An entry may have been displaced past the end of
+ *  that run, possibly wrapping around to the start of the table, but never
+ *  past an empty slot. Each merging thread therefore only has to scan its own
+ *  run of slots in each local table, plus however many full slots follow it,
+ *  rather than the whole table. Slots in that stretch belonging to another
+ *  range, whether displaced into it or just sharing a boundary slot, are
+ *  simply skipped.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void* merge_range_thread(void* arg) {
+    struct merge_range_t* merge = (struct merge_range_t *) arg;
+
+    const hash_t first_hash = first_hash_in_range(merge->range, merge->ranges);
+    const hash_t last_hash  = first_hash_in_range(merge->range + 1, merge->ranges) - 1;
+
+    size_t expected_size = 0;
+
+    for (int i = 0; i < number_of_local_tables; ++i) {
+        expected_size += local_tables[i].table.size;
+    }
+
+    expected_size /= merge->ranges;
+
+    size_t capacity = TABLE_INITIAL_CAPACITY;
+
+    while (capacity - (capacity / 8) < expected_size) {
+        capacity *= 2;
+    }
+
+    merge->table->scale = merge->ranges;
+    merge->table->seed  = merge->seed;
+
+    allocate_table_storage(merge->table, capacity);
+
+    for (int i = 0; i < number_of_local_tables; ++i) {
+        const struct hash_table_t* table = &local_tables[i].table;
+
+        if (table->capacity == 0) {
+            continue;
+        }
+
+        /** A local table that was reseeded no longer hashes its words the
+         *  same way as the merged tables, so its entries' hashes say nothing
+         *  about which range they belong to. Such a table is scanned in full,
+         *  rehashing every entry with the merged tables' seed. Each entry is
+         *  in exactly one range, so only one thread ever updates its hash.
+         * 
+         */
+        if (table->seed != merge->table->seed) {
+            for (size_t slot = 0; slot < table->capacity; ++slot) {
+                struct table_entry_t* entry = table->slots[slot];
+
+                if (entry == NULL) {
+                    continue;
+                }
+
+                hash_t hash = hash_word(entry->word, entry->length, merge->table->seed);
+
+                if (hash_range(hash, merge->ranges) == merge->range) {
+                    entry->hash = hash;
+                    merge_entry(merge->table, entry);
+                }
+            }
+
+            continue;
+        }
+
+        const size_t first_slot = home_slot(table, first_hash);
+        const size_t last_slot  = home_slot(table, last_hash);
+
+        for (size_t j = first_slot; j - first_slot < table->capacity; ++j) {
+            size_t slot = j & table->mask;
+
+            if (table->control[slot] == CONTROL_EMPTY) {
+                if (j > last_slot) {
+                    break;
+                }
+
+                continue;
+            }
+
+            struct table_entry_t* entry = table->slots[slot];
+
+            if (hash_range(entry->hash, merge->ranges) == merge->range) {
+                merge_entry(merge->table, entry);
+            }
+        }
+    }
+
+    if (merge->find_words) {
+        find_best_entries(merge->table, 0, merge->table->capacity, &merge->selection);
+    }
+
+    return NULL;
+}
+
+/** This function merges the local tables once every counting thread has
+ *  finished, using one thread per hash range, and unless 'find_words' is
+ *  FALSE, merges the best entries each of those threads found into the given
+ *  selection. Once the merge is complete, the local tables' slots are no
+ *  longer needed, but their entries are, since the merged tables adopted them.
+ *  The merged tables are returned, along with how many there are, and belong
+ *  to the caller from then on.
+ * 
+ *  The merged tables all share the given seed, and are never reseeded, since
+ *  every merging thread relies on the hashes of the entries it merges staying
+ *  put until it is done with them.
+ * 
+ */
+__attribute__((nonnull(2,4), returns_nonnull))
+struct hash_table_t* merge_local_tables(hash_t seed, struct selection_t* best, int find_words, size_t* number_of_merged_tables) {
+    const size_t number_of_ranges = (size_t) number_of_local_tables;
+
+    struct hash_table_t* merged_tables = calloc(number_of_ranges, sizeof (struct hash_table_t));
+
+    struct merge_range_t* merges = NULL;
+
+    if ((merged_tables == NULL) || posix_memalign((void **) &merges, sizeof (struct merge_range_t), number_of_ranges * sizeof (struct merge_range_t))) {
+        fatal_error("Memory allocation failure in merge_local_tables()");
+    }
+
+    pthread_t* threads = malloc(number_of_ranges * sizeof (pthread_t));
+
+    if (threads == NULL) {
+        fatal_error("Memory allocation failure in merge_local_tables()");
+    }
+
+    for (size_t i = 0; i < number_of_ranges; ++i) {
+        merges[i].range      = i;
+        merges[i].ranges     = number_of_ranges;
+        merges[i].seed       = seed;
+        merges[i].find_words = find_words;
+        merges[i].table      = &merged_tables[i];
+
+        initialize_selection(&merges[i].selection, best->capacity);
+
+        if (pthread_create(&threads[i], NULL, merge_range_thread, &merges[i])) {
+            fatal_error("Could not create merge thread");
+        }
+    }
+
+    for (size_t i = 0; i < number_of_ranges; ++i) {
+        if (pthread_join(threads[i], NULL)) {
+            fatal_error("Could not rejoin merge threads");
+        }
+
+        merge_selection(best, &merges[i].selection);
+        release_selection(&merges[i].selection);
+    }
+
+    for (int i = 0; i < number_of_local_tables; ++i) {
+        FREE(local_tables[i].table.control);
+        FREE(local_tables[i].table.slots);
+    }
+
+    FREE(threads);
+    FREE(merges);
+
+    *number_of_merged_tables = number_of_ranges;
+
+    return merged_tables;
+}
+
+void release_local_tables(void) {
+    FREE(local_tables);
+
+    number_of_local_tables = 0;
+}
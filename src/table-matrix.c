@@ -0,0 +1,130 @@
+#include "common.h"
+
+/** This is the pair matrix, which holds the best entry shared by every pair of
+ *  files when the user asks for the matrix, and is NULL otherwise.
+ * 
+ */
+static struct scored_entry_t* pair_words = NULL;
+
+/** The number of inputs is copied out of the settings when the matrix is
+ *  allocated, since the matrix has a row and a column for every one of them.
+ * 
+ */
+static size_t number_of_inputs = 2;
+
+/** This function offers a scored entry to a single cell of the pair matrix,
+ *  which holds the best entry for one pair of files. An empty cell has no
+ *  entry at all.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+static inline void consider_pair_entry(struct scored_entry_t* cell, const struct scored_entry_t* candidate) {
+    if ((cell->entry == NULL) || ranks_higher(candidate, cell)) {
+        *cell = *candidate;
+    }
+}
+
+/** This function finds the most common word shared by every pair of files in
+ *  the given range of slots, for the pairwise matrix. Each entry is scored for
+ *  every pair of files it appears in, with the metric applied to just those
+ *  two counts. Most words appear in only a few of the files, so the files an
+ *  entry does appear in are picked out first, and pairs it is missing from
+ *  are never even looked at.
+ * 
+ *  The matrix has a cell for every ordered pair of files, but only the cells
+ *  above the diagonal are ever used.
+ * 
+ */
+__attribute__((hot, nonnull(1,4)))
+void find_best_pairs(const struct hash_table_t* table, size_t first_slot, size_t last_slot, struct scored_entry_t* pairs) {
+    size_t* files = malloc(number_of_inputs * sizeof (size_t));
+
+    if (files == NULL) {
+        fatal_error("Memory allocation failure in find_best_pairs()");
+    }
+
+    for (size_t position = first_slot; position < last_slot; position += GROUP_WIDTH) {
+        unsigned int full = ~match_empty_slots(table->control + position) & ((1u << GROUP_WIDTH) - 1);
+
+        while (full) {
+            struct table_entry_t* entry = table->slots[position + __builtin_ctz(full)];
+
+            full &= full - 1;
+
+            size_t number_of_files = 0;
+
+            for (size_t i = 0; i < number_of_inputs; ++i) {
+                if (entry->counts[i]) {
+                    files[number_of_files++] = i;
+                }
+            }
+
+            for (size_t a = 0; a < number_of_files; ++a) {
+                for (size_t b = a + 1; b < number_of_files; ++b) {
+                    const size_t counts[2] = { entry->counts[files[a]], entry->counts[files[b]] };
+
+                    const struct scored_entry_t candidate = { entry, score_counts(counts, 2) };
+
+                    consider_pair_entry(&pairs[files[a] * number_of_inputs + files[b]], &candidate);
+                }
+            }
+        }
+    }
+
+    FREE(files);
+}
+
+__attribute__((malloc, returns_nonnull))
+struct scored_entry_t* allocate_pair_matrix(void) {
+    struct scored_entry_t* pairs = calloc(number_of_inputs * number_of_inputs, sizeof (struct scored_entry_t));
+
+    if (pairs == NULL) {
+        fatal_error("Memory allocation failure in allocate_pair_matrix()");
+    }
+
+    return pairs;
+}
+
+void initialize_pair_matrix(void) {
+    number_of_inputs = settings_get_number_of_inputs();
+
+    pair_words = allocate_pair_matrix();
+}
+
+/** This function folds the pair matrix found by one of the threads scanning
+ *  the tables into the final one, one cell at a time.
+ * 
+ */
+__attribute__((nonnull(1)))
+void merge_pair_matrix(const struct scored_entry_t* pairs) {
+    for (size_t cell = 0; cell < number_of_inputs * number_of_inputs; ++cell) {
+        if (pairs[cell].entry) {
+            consider_pair_entry(&pair_words[cell], &pairs[cell]);
+        }
+    }
+}
+
+int most_common_pair_word(int first_file, int second_file, struct shared_word_t* word) {
+    if ((pair_words == NULL) || (first_file == second_file)) {
+        return FALSE;
+    }
+
+    const size_t first  = count_index(MIN(first_file, second_file));
+    const size_t second = count_index(MAX(first_file, second_file));
+
+    const struct scored_entry_t* cell = &pair_words[first * number_of_inputs + second];
+
+    if (cell->entry == NULL) {
+        return FALSE;
+    }
+
+    word->word   = cell->entry->word;
+    word->counts = cell->entry->counts;
+    word->score  = cell->score;
+
+    return TRUE;
+}
+
+void release_pair_matrix(void) {
+    FREE(pair_words);
+}
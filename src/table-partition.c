@@ -0,0 +1,409 @@
+#include "common.h"
+
+#ifndef PARTITIONS_PER_THREAD
+/** In partitioned mode, the hash space is split into this many partitions for
+ *  every thread. More partitions make for smaller tables, which stay in cache
+ *  for longer, but every thread keeps a block of words on its way to each
+ *  partition, so the blocks in flight grow with the square of the threads.
+ * 
+ */
+#define PARTITIONS_PER_THREAD (4)
+#else
+#error "PARTITIONS_PER_THREAD already defined."
+#endif // PARTITIONS_PER_THREAD
+
+#ifndef PARTITION_BLOCK_SIZE
+/** Words are handed over to the owner of their partition in blocks of this
+ *  many bytes, so the hand-off costs one atomic operation for every hundred
+ *  or so words rather than one for every word.
+ * 
+ */
+#define PARTITION_BLOCK_SIZE (1 << 12)
+#else
+#error "PARTITION_BLOCK_SIZE already defined."
+#endif // PARTITION_BLOCK_SIZE
+
+#ifndef PARTITION_INITIAL_CAPACITY
+/** Every partition's table is a fraction of the size of a shared one, so they
+ *  start out with this many slots, rather than TABLE_INITIAL_CAPACITY, and
+ *  only grow as far as their share of the words calls for.
+ * 
+ */
+#define PARTITION_INITIAL_CAPACITY (1 << 12)
+#else
+#error "PARTITION_INITIAL_CAPACITY already defined."
+#endif // PARTITION_INITIAL_CAPACITY
+
+/** In partitioned mode, no thread ever counts a word into a table another
+ *  thread can see. The hash space is split into partitions, each of which is
+ *  owned by a single thread, and counted into a table of its own, which no
+ *  other thread ever touches. Those partition tables are simply the merged
+ *  tables from the start, so once they are complete, they are probed, scanned
+ *  and reported on exactly as the merged tables of local mode are.
+ * 
+ *  A thread tokenizing a chunk only hashes each word, and copies it, along
+ *  with its hash and file, into a block bound for the owner of the word's
+ *  partition, which it keeps one of for every partition. A full block is
+ *  pushed onto the owner's inbox with a single compare-and-swap, and every
+ *  thread counts the blocks in its inbox into its own partitions at the end
+ *  of each chunk, so the blocks in flight never outgrow a few chunks' worth
+ *  of words. Whatever is left over once every thread has been joined, partly
+ *  full blocks included, is counted by one thread per owner.
+ * 
+ *  The partition tables all share the initial seed, and are never reseeded,
+ *  since the hash a word was sent off with is the one it is counted with.
+ * 
+ */
+struct partition_record_t {
+    hash_t hash;
+    size_t length;
+    int file;
+    uint64_t word[];
+};
+
+struct partition_block_t {
+    struct partition_block_t* next;
+    size_t partition;
+    size_t size;
+    size_t capacity;
+    uint64_t records[];
+};
+
+struct partition_worker_t {
+    struct partition_block_t** outgoing;
+    struct partition_block_t* inbox __attribute__((aligned(64)));
+} __attribute__((aligned(64)));
+
+static struct partition_worker_t* partition_workers = NULL;
+
+static size_t number_of_owners = 0;
+
+static size_t number_of_partitions = 0;
+
+static struct hash_table_t* partition_tables = NULL;
+
+/** The partition tables are set up here, all but their storage, which the
+ *  thread owning each one allocates once it has a word to count in it, so
+ *  that its slots are first touched by the thread that uses them. They are
+ *  returned, along with how many there are, to take the place of the merged
+ *  tables, and belong to the caller from then on.
+ * 
+ */
+__attribute__((nonnull(3), returns_nonnull))
+struct hash_table_t* initialize_partitions(int number_of_threads, hash_t seed, size_t* number_of_tables) {
+    number_of_owners     = (size_t) number_of_threads;
+    number_of_partitions = number_of_owners * PARTITIONS_PER_THREAD;
+
+    partition_tables = calloc(number_of_partitions, sizeof (struct hash_table_t));
+
+    if ((partition_tables == NULL) || posix_memalign((void **) &partition_workers, sizeof (struct partition_worker_t), number_of_owners * sizeof (struct partition_worker_t))) {
+        fatal_error("Memory allocation failure in initialize_partitions()");
+    }
+
+    memset(partition_workers, 0, number_of_owners * sizeof (struct partition_worker_t));
+
+    for (size_t i = 0; i < number_of_partitions; ++i) {
+        partition_tables[i].scale = number_of_partitions;
+        partition_tables[i].seed  = seed;
+    }
+
+    *number_of_tables = number_of_partitions;
+
+    return partition_tables;
+}
+
+/** A thread claiming its worker gets an empty block slot for every partition,
+ *  and only allocates a block for one once it has a word to send there.
+ * 
+ */
+__attribute__((returns_nonnull))
+struct partition_worker_t* claim_partition_worker(int thread) {
+    struct partition_worker_t* worker = &partition_workers[thread];
+
+    worker->outgoing = calloc(number_of_partitions, sizeof (struct partition_block_t *));
+
+    if (worker->outgoing == NULL) {
+        fatal_error("Memory allocation failure in claim_partition_worker()");
+    }
+
+    return worker;
+}
+
+/** A record takes up its header and then the word, rounded up to a whole
+ *  number of 64-bit words so the next record's header stays aligned. Short
+ *  words are copied in full, padding and all, exactly as they are laid out in
+ *  a key, so the owner can build its key from the record without ever
+ *  zeroing or copying a byte of the word.
+ * 
+ */
+__attribute__((const))
+static inline size_t partition_record_size(size_t length) {
+    const size_t word_size = (length < INLINE_WORD_SIZE) ? INLINE_WORD_SIZE : (length + sizeof (uint64_t) - 1) & ~(sizeof (uint64_t) - 1);
+
+    return sizeof (struct partition_record_t) + word_size;
+}
+
+/** Blocks are all PARTITION_BLOCK_SIZE bytes, except for the rare one that
+ *  has to hold a word too long to fit in one, which is made just big enough.
+ * 
+ */
+__attribute__((returns_nonnull))
+static struct partition_block_t* allocate_partition_block(size_t partition, size_t record_size) {
+    const size_t capacity = MAX(PARTITION_BLOCK_SIZE - sizeof (struct partition_block_t), record_size);
+
+    struct partition_block_t* block = malloc(sizeof (struct partition_block_t) + capacity);
+
+    if (block == NULL) {
+        fatal_error("Memory allocation failure in allocate_partition_block()");
+    }
+
+    count_allocation(sizeof (struct partition_block_t) + capacity);
+
+    block->next      = NULL;
+    block->partition = partition;
+    block->size      = 0;
+    block->capacity  = capacity;
+
+    return block;
+}
+
+/** Partitions are dealt out to the threads in turn, so every thread owns as
+ *  many of them as any other, and a full block is pushed onto its owner's
+ *  inbox. Any number of threads may be pushing onto the same inbox at once,
+ *  while its owner only ever takes the whole stack at a time, so a plain
+ *  compare-and-swap on the head is all it takes.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void send_partition_block(struct partition_block_t* block) {
+    struct partition_worker_t* owner = &partition_workers[block->partition % number_of_owners];
+
+    block->next = __atomic_load_n(&owner->inbox, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&owner->inbox, &block->next, block, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        /** Just as with the list of arenas, a failed exchange has already
+         *  reloaded the head of the inbox into block->next.
+         * 
+         */
+    }
+}
+
+/** This function adds a word to the calling thread's block for the word's
+ *  partition, sending the block off to the partition's owner first if the
+ *  word does not fit in what is left of it.
+ * 
+ */
+__attribute__((hot, nonnull(1,2)))
+void scatter_word(struct partition_worker_t* worker, const struct table_key_t* key, int file) {
+    const size_t partition   = hash_range(key->hash, number_of_partitions);
+    const size_t record_size = partition_record_size(key->length);
+
+    struct partition_block_t* block = worker->outgoing[partition];
+
+    if ((block == NULL) || (block->size + record_size > block->capacity)) {
+        if (block) {
+            send_partition_block(block);
+        }
+
+        block = allocate_partition_block(partition, record_size);
+
+        worker->outgoing[partition] = block;
+    }
+
+    struct partition_record_t* record = (struct partition_record_t *) ((char *) block->records + block->size);
+
+    record->hash   = key->hash;
+    record->length = key->length;
+    record->file   = file;
+
+    if (key->length < INLINE_WORD_SIZE) {
+        record->word[0] = key->inline_word[0];
+        record->word[1] = key->inline_word[1];
+    } else {
+        memcpy(record->word, key->word, key->length);
+    }
+
+    block->size += record_size;
+}
+
+/** This function counts every word in a block into the table of the block's
+ *  partition, which belongs to the calling thread, so none of it needs any
+ *  synchronization. The table is only allocated once its first block comes
+ *  in, by the thread that will be filling it.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+static void count_partition_block(const struct partition_block_t* block) {
+    struct hash_table_t* table = &partition_tables[block->partition];
+
+    if (table->capacity == 0) {
+        allocate_table_storage(table, PARTITION_INITIAL_CAPACITY);
+    }
+
+    for (size_t offset = 0; offset < block->size; ) {
+        const struct partition_record_t* record = (const struct partition_record_t *) ((const char *) block->records + offset);
+
+        struct table_key_t key = {
+            .word        = (const char *) record->word,
+            .length      = record->length,
+            .hash        = record->hash,
+            .seed        = table->seed,
+            .inline_word = { 0, 0 }
+        };
+
+        if (record->length < INLINE_WORD_SIZE) {
+            key.inline_word[0] = record->word[0];
+            key.inline_word[1] = record->word[1];
+        }
+
+        struct table_entry_t* entry = find_or_insert_local_word(table, &key);
+
+        ++entry->counts[count_index(record->file)];
+
+        offset += partition_record_size(record->length);
+    }
+}
+
+/** The owner of an inbox takes every block in it at once, leaving it empty for
+ *  the threads still sending to it, and counts them one after the other.
+ * 
+ */
+__attribute__((nonnull(1)))
+void drain_partition_inbox(struct partition_worker_t* worker) {
+    if (__atomic_load_n(&worker->inbox, __ATOMIC_RELAXED) == NULL) {
+        return;
+    }
+
+    struct partition_block_t* block = __atomic_exchange_n(&worker->inbox, NULL, __ATOMIC_ACQUIRE);
+
+    while (block) {
+        struct partition_block_t* next = block->next;
+
+        count_partition_block(block);
+
+        FREE(block);
+
+        block = next;
+    }
+}
+
+/** Once every counting thread has been joined, whatever words never made it
+ *  into a table are counted by one thread for every owner of partitions. Each
+ *  of them counts every thread's partly full block for its own partitions,
+ *  then the blocks still in its inbox, which nothing is adding to any more,
+ *  and then, unless 'find_words' is FALSE, picks out the best entries of its
+ *  own partitions, just as the threads merging the local tables do. Those are
+ *  then merged into the given selection.
+ * 
+ */
+struct partition_drain_t {
+    size_t owner;
+    int find_words;
+    struct selection_t selection;
+} __attribute__((aligned(64)));
+
+__attribute__((nonnull(1)))
+static void* drain_partitions_thread(void* arg) {
+    struct partition_drain_t* drain = (struct partition_drain_t *) arg;
+
+    for (size_t i = 0; i < number_of_owners; ++i) {
+        struct partition_block_t** outgoing = partition_workers[i].outgoing;
+
+        if (outgoing == NULL) {
+            continue;
+        }
+
+        for (size_t partition = drain->owner; partition < number_of_partitions; partition += number_of_owners) {
+            if (outgoing[partition]) {
+                count_partition_block(outgoing[partition]);
+                FREE(outgoing[partition]);
+            }
+        }
+    }
+
+    drain_partition_inbox(&partition_workers[drain->owner]);
+
+    /** A partition that never got a single word still needs slots, since join
+     *  mode probes every partition alike.
+     * 
+     */
+    for (size_t partition = drain->owner; partition < number_of_partitions; partition += number_of_owners) {
+        struct hash_table_t* table = &partition_tables[partition];
+
+        if (table->capacity == 0) {
+            allocate_table_storage(table, PARTITION_INITIAL_CAPACITY);
+        }
+
+        if (drain->find_words) {
+            find_best_entries(table, 0, table->capacity, &drain->selection);
+        }
+    }
+
+    return NULL;
+}
+
+__attribute__((nonnull(1)))
+void drain_partitions(struct selection_t* best, int find_words) {
+    struct partition_drain_t* drains = NULL;
+
+    if (posix_memalign((void **) &drains, sizeof (struct partition_drain_t), number_of_owners * sizeof (struct partition_drain_t))) {
+        fatal_error("Memory allocation failure in drain_partitions()");
+    }
+
+    pthread_t* threads = malloc(number_of_owners * sizeof (pthread_t));
+
+    if (threads == NULL) {
+        fatal_error("Memory allocation failure in drain_partitions()");
+    }
+
+    for (size_t i = 0; i < number_of_owners; ++i) {
+        drains[i].owner      = i;
+        drains[i].find_words = find_words;
+
+        initialize_selection(&drains[i].selection, best->capacity);
+
+        if (pthread_create(&threads[i], NULL, drain_partitions_thread, &drains[i])) {
+            fatal_error("Could not create drain thread");
+        }
+    }
+
+    for (size_t i = 0; i < number_of_owners; ++i) {
+        if (pthread_join(threads[i], NULL)) {
+            fatal_error("Could not rejoin drain threads");
+        }
+
+        merge_selection(best, &drains[i].selection);
+        release_selection(&drains[i].selection);
+    }
+
+    for (size_t i = 0; i < number_of_owners; ++i) {
+        FREE(partition_workers[i].outgoing);
+    }
+
+    FREE(threads);
+    FREE(drains);
+}
+
+/** The partition tables themselves are released along with the merged tables
+ *  they became, so only the workers are left to free here.
+ * 
+ */
+void release_partitions(void) {
+    FREE(partition_workers);
+
+    partition_tables     = NULL;
+    number_of_owners     = 0;
+    number_of_partitions = 0;
+}
+
+#if defined(PARTITION_INITIAL_CAPACITY)
+#undef PARTITION_INITIAL_CAPACITY
+#endif
+
+#if defined(PARTITION_BLOCK_SIZE)
+#undef PARTITION_BLOCK_SIZE
+#endif
+
+#if defined(PARTITIONS_PER_THREAD)
+#undef PARTITIONS_PER_THREAD
+#endif
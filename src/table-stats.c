@@ -0,0 +1,134 @@
+#include "common.h"
+
+/** These are the names of the hash functions, in the order of the hash
+ *  algorithm enumeration, for the statistics printed in verbose mode.
+ * 
+ */
+static const char* hash_function_names[] = { "wyhash", "murmur", "weinberger", "sedgewick", "trivial" };
+
+/** These are the statistics reported about the final state of the table in
+ *  verbose mode. Group occupancy is the number of full slots in each aligned
+ *  group of sixteen, and a probe's length is the number of groups a lookup of
+ *  the entry has to load before it finds it. Both are summed over every table,
+ *  which is just the one in every mode but local and partitioned mode, where it
+ *  is every one of the merged tables.
+ * 
+ */
+#ifndef PROBE_HISTOGRAM_SIZE
+#define PROBE_HISTOGRAM_SIZE (6)
+#else
+#error "PROBE_HISTOGRAM_SIZE already defined."
+#endif // PROBE_HISTOGRAM_SIZE
+
+struct table_statistics_t {
+    size_t tables;
+    size_t capacity;
+    size_t size;
+    size_t groups;
+    size_t occupancy[GROUP_WIDTH + 1];
+    size_t total_probe_length;
+    size_t longest_probe;
+    size_t probe_histogram[PROBE_HISTOGRAM_SIZE];
+};
+
+/** Probes of one to four groups each get a bucket of their own in the probe
+ *  histogram, and everything longer is lumped into the last two.
+ * 
+ */
+__attribute__((const))
+static inline size_t probe_histogram_bucket(size_t probe_length) {
+    if (probe_length <= 4) {
+        return probe_length - 1;
+    }
+
+    return (probe_length <= 8) ? 4 : 5;
+}
+
+__attribute__((nonnull(1,2)))
+static void accumulate_table_statistics(const struct hash_table_t* table, struct table_statistics_t* statistics) {
+    if (table->capacity == 0) {
+        return;
+    }
+
+    statistics->tables   += 1;
+    statistics->capacity += table->capacity;
+    statistics->size     += table->size;
+    statistics->groups   += table->capacity / GROUP_WIDTH;
+
+    for (size_t position = 0; position < table->capacity; position += GROUP_WIDTH) {
+        unsigned int full = ~match_empty_slots(table->control + position) & ((1u << GROUP_WIDTH) - 1);
+
+        statistics->occupancy[__builtin_popcount(full)] += 1;
+
+        while (full) {
+            const size_t slot = position + __builtin_ctz(full);
+            const size_t probe_length = (((slot - home_slot(table, table->slots[slot]->hash)) & table->mask) / GROUP_WIDTH) + 1;
+
+            statistics->total_probe_length += probe_length;
+            statistics->longest_probe = MAX(statistics->longest_probe, probe_length);
+            statistics->probe_histogram[probe_histogram_bucket(probe_length)] += 1;
+
+            full &= full - 1;
+        }
+    }
+}
+
+/** This function prints the table statistics to standard error, so they never
+ *  get mixed up with the answer on standard output.
+ * 
+ */
+__attribute__((nonnull(1)))
+static void print_table_statistics(const struct table_statistics_t* statistics) {
+    if (statistics->tables == 0) {
+        return;
+    }
+
+    const double groups  = (double) statistics->groups;
+    const double entries = (statistics->size) ? (double) statistics->size : 1.0;
+
+    size_t sparse = 0;
+    size_t dense  = 0;
+
+    for (unsigned int i = 1; i <= GROUP_WIDTH / 2; ++i) {
+        sparse += statistics->occupancy[i];
+    }
+
+    for (unsigned int i = GROUP_WIDTH / 2 + 1; i < GROUP_WIDTH; ++i) {
+        dense += statistics->occupancy[i];
+    }
+
+    fprintf(stderr, "Hash function: %s (%zu reseeds)\n", hash_function_names[settings_get_hash_algorithm()], table_reseeds());
+    fprintf(stderr, "Table: %zu entries in %zu slots across %zu tables (load factor %.3f)\n", statistics->size, statistics->capacity, statistics->tables, (double) statistics->size / (double) statistics->capacity);
+    fprintf(stderr, "Group occupancy: empty %.1f%%, 1-8 %.1f%%, 9-15 %.1f%%, full %.1f%%\n",
+        100.0 * (double) statistics->occupancy[0] / groups,
+        100.0 * (double) sparse / groups,
+        100.0 * (double) dense / groups,
+        100.0 * (double) statistics->occupancy[GROUP_WIDTH] / groups);
+    fprintf(stderr, "Probe length: mean %.3f groups, longest %zu groups\n", (double) statistics->total_probe_length / entries, statistics->longest_probe);
+    fprintf(stderr, "Probe histogram: 1 %.2f%%, 2 %.2f%%, 3 %.2f%%, 4 %.2f%%, 5-8 %.2f%%, 9+ %.2f%%\n",
+        100.0 * (double) statistics->probe_histogram[0] / entries,
+        100.0 * (double) statistics->probe_histogram[1] / entries,
+        100.0 * (double) statistics->probe_histogram[2] / entries,
+        100.0 * (double) statistics->probe_histogram[3] / entries,
+        100.0 * (double) statistics->probe_histogram[4] / entries,
+        100.0 * (double) statistics->probe_histogram[5] / entries);
+}
+
+/** This function reports the statistics of the given tables, all together, as
+ *  though they were one table.
+ * 
+ */
+__attribute__((nonnull(1)))
+void report_table_statistics(const struct hash_table_t* tables, size_t number_of_tables) {
+    struct table_statistics_t statistics = { 0 };
+
+    for (size_t i = 0; i < number_of_tables; ++i) {
+        accumulate_table_statistics(&tables[i], &statistics);
+    }
+
+    print_table_statistics(&statistics);
+}
+
+#if defined(PROBE_HISTOGRAM_SIZE)
+#undef PROBE_HISTOGRAM_SIZE
+#endif
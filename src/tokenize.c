@@ -0,0 +1,223 @@
+
+#include "common.h"
+
+#ifndef BLOCK_SIZE
+#define BLOCK_SIZE (64)
+#else
+#error "BLOCK_SIZE already defined."
+#endif // BLOCK_SIZE
+
+/** The tokenizer used to be a loop around 'strtok_r', which checks every byte
+ *  of the input against every one of the delimiters it was given. It now works
+ *  on blocks of sixty-four bytes, first classifying every byte in the block as
+ *  alphanumeric or not, which produces a single 64-bit mask, and then finding
+ *  the words by looking at where the mask changes from zero to one and back.
+ * 
+ *  Classifying the bytes is the only part that depends on the instruction
+ *  set, so it is done through this function pointer, which is pointed at the
+ *  best implementation the processor supports the first time it is needed.
+ * 
+ */
+typedef uint64_t (*classify_function)(const char*);
+
+/** A byte is checked by way of arithmetic on the byte rather than 'isalnum',
+ *  which would depend on the locale. Setting bit five folds uppercase letters
+ *  into lowercase, and maps no non-letter into the range of lowercase letters.
+ * 
+ */
+int is_word_character(char c) {
+    int is_digit  = (unsigned char) (c - '0') < 10;
+    int is_letter = (unsigned char) (((unsigned char) c | 0x20) - 'a') < 26;
+
+    return is_digit | is_letter;
+}
+
+/** This is the portable version of the classifier, which simply checks one
+ *  byte at a time.
+ * 
+ */
+__attribute__((hot, nonnull(1)))
+static uint64_t classify_block_scalar(const char* block) {
+    uint64_t mask = 0;
+
+    for (unsigned int i = 0; i < BLOCK_SIZE; ++i) {
+        mask |= (uint64_t) is_word_character(block[i]) << i;
+    }
+
+    return mask;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/** The SSE2 version of the classifier checks sixteen bytes at a time. Since
+ *  there is no unsigned byte comparison, a byte is tested against a range by
+ *  subtracting the start of the range and checking whether the result is
+ *  unchanged by taking its unsigned minimum with the length of the range.
+ *  Letters are folded to lowercase first by setting bit five, which maps no
+ *  non-letter into the range of lowercase letters.
+ * 
+ *  SSE4.2's string instructions can test bytes against several ranges at
+ *  once, but they are considerably slower than these few simple operations.
+ * 
+ */
+__attribute__((hot, nonnull(1), target("sse2")))
+static uint64_t classify_block_sse2(const char* block) {
+    const __m128i zero       = _mm_set1_epi8('0');
+    const __m128i nine       = _mm_set1_epi8(9);
+    const __m128i lowercase  = _mm_set1_epi8(0x20);
+    const __m128i a          = _mm_set1_epi8('a');
+    const __m128i twentyfive = _mm_set1_epi8(25);
+
+    uint64_t mask = 0;
+
+    for (unsigned int i = 0; i < BLOCK_SIZE; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (block + i));
+
+        __m128i digits  = _mm_sub_epi8(bytes, zero);
+        __m128i letters = _mm_sub_epi8(_mm_or_si128(bytes, lowercase), a);
+
+        __m128i is_digit  = _mm_cmpeq_epi8(_mm_min_epu8(digits, nine), digits);
+        __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letters, twentyfive), letters);
+
+        mask |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) << i;
+    }
+
+    return mask;
+}
+
+/** The AVX2 version is the same as the SSE2 version, but with registers twice
+ *  as wide, so a block takes two iterations instead of four.
+ * 
+ */
+__attribute__((hot, nonnull(1), target("avx2")))
+static uint64_t classify_block_avx2(const char* block) {
+    const __m256i zero       = _mm256_set1_epi8('0');
+    const __m256i nine       = _mm256_set1_epi8(9);
+    const __m256i lowercase  = _mm256_set1_epi8(0x20);
+    const __m256i a          = _mm256_set1_epi8('a');
+    const __m256i twentyfive = _mm256_set1_epi8(25);
+
+    uint64_t mask = 0;
+
+    for (unsigned int i = 0; i < BLOCK_SIZE; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *) (block + i));
+
+        __m256i digits  = _mm256_sub_epi8(bytes, zero);
+        __m256i letters = _mm256_sub_epi8(_mm256_or_si256(bytes, lowercase), a);
+
+        __m256i is_digit  = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, nine), digits);
+        __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letters, twentyfive), letters);
+
+        mask |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) << i;
+    }
+
+    return mask;
+}
+
+#endif // __x86_64__ || __i386__
+
+static classify_function classify_block = NULL;
+
+/** This function picks the classifier for the processor we are running on.
+ *  Every thread races to do this on its first call to 'initialize_tokenizer',
+ *  but they all arrive at the same answer, so it doesn't matter who wins.
+ * 
+ */
+static classify_function select_classifier(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return classify_block_avx2;
+    }
+
+    if (__builtin_cpu_supports("sse2")) {
+        return classify_block_sse2;
+    }
+#endif // __x86_64__ || __i386__
+
+    return classify_block_scalar;
+}
+
+void initialize_tokenizer(struct tokenizer_t* tokenizer, const char* buffer, size_t length) {
+    if (__atomic_load_n(&classify_block, __ATOMIC_RELAXED) == NULL) {
+        __atomic_store_n(&classify_block, select_classifier(), __ATOMIC_RELAXED);
+    }
+
+    tokenizer->buffer     = buffer;
+    tokenizer->length     = length;
+    tokenizer->position   = 0;
+    tokenizer->word_start = 0;
+    tokenizer->in_word    = FALSE;
+}
+
+/** Given the mask for a block, the words are found from its transitions. A bit
+ *  is set in 'transitions' wherever a byte differs in class from the one
+ *  before it, including the last byte of the previous block, so the set bits
+ *  alternate between the start of a word and the delimiter just past its end.
+ *  Every block with no transitions at all, which is every block in the middle
+ *  of a long run of words or of delimiters, costs a single test.
+ * 
+ *  The last block of the buffer is usually short, so it is copied into a
+ *  block of zeros first. The zeros are delimiters, which conveniently also
+ *  ends any word that runs up to the end of the buffer.
+ * 
+ */
+size_t next_tokens(struct tokenizer_t* tokenizer, struct token_t* tokens, size_t capacity) {
+    const classify_function classify = classify_block;
+
+    size_t number_of_tokens = 0;
+
+    while ((tokenizer->position < tokenizer->length) && (number_of_tokens + (BLOCK_SIZE / 2) + 1 <= capacity)) {
+        const char* block = tokenizer->buffer + tokenizer->position;
+        const size_t remaining = tokenizer->length - tokenizer->position;
+
+        char last_block[BLOCK_SIZE];
+
+        if (remaining < BLOCK_SIZE) {
+            memset(last_block, 0, BLOCK_SIZE);
+            memcpy(last_block, block, remaining);
+            block = last_block;
+        }
+
+        uint64_t mask = classify(block);
+        uint64_t transitions = mask ^ ((mask << 1) | (uint64_t) tokenizer->in_word);
+
+        while (transitions) {
+            size_t offset = tokenizer->position + (size_t) __builtin_ctzll(transitions);
+
+            if (tokenizer->in_word) {
+                tokens[number_of_tokens].start  = tokenizer->buffer + tokenizer->word_start;
+                tokens[number_of_tokens].length = offset - tokenizer->word_start;
+                ++number_of_tokens;
+            } else {
+                tokenizer->word_start = offset;
+            }
+
+            tokenizer->in_word = !tokenizer->in_word;
+
+            transitions &= transitions - 1;
+        }
+
+        tokenizer->position += BLOCK_SIZE;
+    }
+
+    /** If the buffer's length is an exact multiple of the block size, a word
+     *  running up to the end of the buffer never sees a delimiter after it,
+     *  so it has to be closed off here.
+     * 
+     */
+    if ((tokenizer->position >= tokenizer->length) && tokenizer->in_word && (number_of_tokens < capacity)) {
+        tokens[number_of_tokens].start  = tokenizer->buffer + tokenizer->word_start;
+        tokens[number_of_tokens].length = tokenizer->length - tokenizer->word_start;
+        ++number_of_tokens;
+
+        tokenizer->in_word = FALSE;
+    }
+
+    return number_of_tokens;
+}
+
+#if defined(BLOCK_SIZE)
+#undef BLOCK_SIZE
+#endif
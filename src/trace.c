@@ -0,0 +1,232 @@
+
+#include "common.h"
+
+static const char* trace_kind_names[] = { "claim", "read", "tokenize", "lock wait", "phase" };
+
+/** These are the buffers of every thread processing the inputs, followed by
+ *  the main thread's, along with the time the trace began, which every event's
+ *  timestamp is relative to.
+ * 
+ */
+static struct trace_buffer_t* all_trace_buffers = NULL;
+static size_t number_of_trace_threads = 0;
+
+static uint64_t trace_origin = 0;
+
+static __thread struct trace_buffer_t* thread_trace = NULL;
+
+void initialize_trace(size_t number_of_threads) {
+    const size_t number_of_buffers = number_of_threads + 1;
+
+    if (posix_memalign((void **) &all_trace_buffers, sizeof (struct trace_buffer_t), number_of_buffers * sizeof (struct trace_buffer_t))) {
+        fatal_error("Memory allocation failure in initialize_trace()");
+    }
+
+    /** Writing to every page of every buffer now is what keeps the page faults
+     *  out of the run, since the events would otherwise fault in their pages
+     *  as the threads record them.
+     * 
+     */
+    for (size_t i = 0; i < number_of_buffers; ++i) {
+        all_trace_buffers[i].events = malloc(TRACE_BUFFER_EVENTS * sizeof (struct trace_event_t));
+
+        if (all_trace_buffers[i].events == NULL) {
+            fatal_error("Memory allocation failure in initialize_trace()");
+        }
+
+        memset(all_trace_buffers[i].events, 0, TRACE_BUFFER_EVENTS * sizeof (struct trace_event_t));
+
+        all_trace_buffers[i].number_of_events = 0;
+        all_trace_buffers[i].dropped = 0;
+    }
+
+    number_of_trace_threads = number_of_threads;
+
+    trace_origin = stats_nanoseconds();
+
+    register_trace_thread(number_of_threads);
+}
+
+void register_trace_thread(size_t worker) {
+    if (all_trace_buffers && (worker <= number_of_trace_threads)) {
+        thread_trace = &all_trace_buffers[worker];
+
+        time_thread_locks();
+    }
+}
+
+uint64_t trace_clock(void) {
+    return (thread_trace) ? stats_nanoseconds() : 0;
+}
+
+/** This function claims the next event in the calling thread's buffer, or
+ *  returns NULL if the thread is not being traced or its buffer is full.
+ * 
+ */
+static inline struct trace_event_t* next_trace_event(void) {
+    struct trace_buffer_t* buffer = thread_trace;
+
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    if (buffer->number_of_events == TRACE_BUFFER_EVENTS) {
+        buffer->dropped += 1;
+        return NULL;
+    }
+
+    return &buffer->events[buffer->number_of_events++];
+}
+
+void trace_event(trace_kind_t kind, uint64_t start, const char* filename, off_t offset, size_t length) {
+    struct trace_event_t* event = next_trace_event();
+
+    if (event == NULL) {
+        return;
+    }
+
+    event->start    = start;
+    event->end      = stats_nanoseconds();
+    event->filename = filename;
+    event->offset   = offset;
+    event->length   = length;
+    event->kind     = (uint32_t) kind;
+    event->detail   = 0;
+}
+
+void trace_phase(phase_t phase, uint64_t start) {
+    struct trace_event_t* event = next_trace_event();
+
+    if (event == NULL) {
+        return;
+    }
+
+    event->start    = start;
+    event->end      = stats_nanoseconds();
+    event->filename = NULL;
+    event->offset   = 0;
+    event->length   = 0;
+    event->kind     = TRACE_PHASE;
+    event->detail   = (uint32_t) phase;
+}
+
+void trace_lock_wait(lock_kind_t kind, uint64_t start, uint64_t end) {
+    if ((end - start) < TRACE_LOCK_WAIT_THRESHOLD) {
+        return;
+    }
+
+    struct trace_event_t* event = next_trace_event();
+
+    if (event == NULL) {
+        return;
+    }
+
+    event->start    = start;
+    event->end      = end;
+    event->filename = NULL;
+    event->offset   = 0;
+    event->length   = 0;
+    event->kind     = TRACE_LOCK_WAIT;
+    event->detail   = (uint32_t) kind;
+}
+
+/** Filenames are the only strings in the trace that did not come from this
+ *  file, so they are the only ones that need escaping.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+static void write_json_string(FILE* file, const char* string) {
+    fputc('"', file);
+
+    for (const unsigned char* c = (const unsigned char *) string; *c; ++c) {
+        if ((*c == '"') || (*c == '\\')) {
+            fprintf(file, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+
+    fputc('"', file);
+}
+
+/** Every event is a complete event, with its start and duration in the
+ *  microseconds the format calls for. Lock waits are named after their lock,
+ *  so that a convoy behind any one lock stands out, and phases after their
+ *  phase.
+ * 
+ */
+__attribute__((nonnull(1,2)))
+static void write_trace_event(FILE* file, const struct trace_event_t* event, size_t thread, int process) {
+    const char* name = trace_kind_names[event->kind];
+
+    if (event->kind == TRACE_LOCK_WAIT) {
+        name = lock_kind_name((lock_kind_t) event->detail);
+    } else if (event->kind == TRACE_PHASE) {
+        name = phase_name((phase_t) event->detail);
+    }
+
+    fprintf(file, ",\n{\"name\":\"%s%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f", name, (event->kind == TRACE_LOCK_WAIT) ? " lock" : "", trace_kind_names[event->kind], process, thread, (double) (event->start - trace_origin) / 1e3, (double) (event->end - event->start) / 1e3);
+
+    if (event->filename) {
+        fprintf(file, ",\"args\":{\"file\":");
+        write_json_string(file, event->filename);
+        fprintf(file, ",\"offset\":%lld,\"length\":%zu}", (long long) event->offset, event->length);
+    }
+
+    fprintf(file, "}");
+}
+
+void write_trace(const char* filename) {
+    if (all_trace_buffers == NULL) {
+        return;
+    }
+
+    FILE* file = open_file(filename, "w");
+
+    const int process = (int) getpid();
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"common\"}}", process);
+
+    size_t dropped = 0;
+
+    for (size_t thread = 0; thread <= number_of_trace_threads; ++thread) {
+        const struct trace_buffer_t* buffer = &all_trace_buffers[thread];
+
+        if (thread < number_of_trace_threads) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%zu,\"args\":{\"name\":\"worker %zu\"}}", process, thread, thread);
+        } else {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%zu,\"args\":{\"name\":\"main\"}}", process, thread);
+        }
+
+        for (size_t i = 0; i < buffer->number_of_events; ++i) {
+            write_trace_event(file, &buffer->events[i], thread, process);
+        }
+
+        dropped += buffer->dropped;
+    }
+
+    fprintf(file, "\n]}\n");
+
+    close_file(file);
+
+    if (dropped) {
+        fprintf(stderr, "[Warning] %s (%zu)\n", "Trace buffers were full, events dropped", dropped);
+    }
+}
+
+void release_trace(void) {
+    if (all_trace_buffers == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i <= number_of_trace_threads; ++i) {
+        FREE(all_trace_buffers[i].events);
+    }
+
+    FREE(all_trace_buffers);
+
+    number_of_trace_threads = 0;
+}
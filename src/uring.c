@@ -0,0 +1,219 @@
+
+#include "common.h"
+
+/** The io_uring header pulls in <linux/fs.h>, whose BLOCK_SIZE would clash
+ *  with the tokenizer's, so it is included here rather than in common.h. The
+ *  uring's header only ever refers to the queue entries through pointers.
+ * 
+ */
+#include <linux/io_uring.h>
+
+/** The C library has no wrappers for the io_uring system calls, so these
+ *  call straight into the kernel.
+ * 
+ */
+static inline int uring_setup(unsigned int entries, struct io_uring_params* parameters) {
+    return (int) syscall(__NR_io_uring_setup, entries, parameters);
+}
+
+static inline int uring_enter(int ring_descriptor, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+    return (int) syscall(__NR_io_uring_enter, ring_descriptor, to_submit, min_complete, flags, NULL, 0);
+}
+
+static inline int uring_register(int ring_descriptor, unsigned int opcode, const void* arg, unsigned int number_of_args) {
+    return (int) syscall(__NR_io_uring_register, ring_descriptor, opcode, arg, number_of_args);
+}
+
+int uring_supported(void) {
+    struct io_uring_params parameters;
+
+    memset(&parameters, 0, sizeof (parameters));
+
+    int ring_descriptor = uring_setup(1, &parameters);
+
+    if (ring_descriptor == -1) {
+        return FALSE;
+    }
+
+    close(ring_descriptor);
+
+    return TRUE;
+}
+
+/** This function maps one of the rings the kernel set up into memory, which
+ *  is how the queues come to be shared with it.
+ * 
+ */
+static void* map_ring(int ring_descriptor, size_t size, off_t offset) {
+    void* ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_descriptor, offset);
+
+    return (ring == MAP_FAILED) ? NULL : ring;
+}
+
+/** This function registers every buffer with the kernel, which pins their
+ *  pages once, rather than on every read. The buffers are all the same size,
+ *  and lie one after the other in a single allocation.
+ * 
+ */
+__attribute__((nonnull(1)))
+static int register_buffers(struct uring_t* uring) {
+    struct iovec* vectors = malloc(uring->depth * sizeof (struct iovec));
+
+    if (vectors == NULL) {
+        fatal_error("Memory allocation failure in register_buffers()");
+    }
+
+    for (unsigned int i = 0; i < uring->depth; ++i) {
+        vectors[i].iov_base = uring_buffer(uring, i);
+        vectors[i].iov_len  = uring->buffer_size;
+    }
+
+    int registered = (uring_register(uring->ring_descriptor, IORING_REGISTER_BUFFERS, vectors, uring->depth) == 0);
+
+    FREE(vectors);
+
+    return registered;
+}
+
+/** Newer kernels map the submission and completion rings with a single
+ *  mapping, which they advertise with IORING_FEAT_SINGLE_MMAP, in which case
+ *  the completion ring is simply the same mapping as the submission ring.
+ * 
+ */
+int create_uring(struct uring_t* uring, unsigned int depth, size_t buffer_size) {
+    struct io_uring_params parameters;
+
+    memset(&parameters, 0, sizeof (parameters));
+    memset(uring, 0, sizeof (struct uring_t));
+
+    uring->ring_descriptor = uring_setup(depth, &parameters);
+
+    if (uring->ring_descriptor == -1) {
+        return FALSE;
+    }
+
+    uring->depth                = depth;
+    uring->submission_ring_size = parameters.sq_off.array + parameters.sq_entries * sizeof (unsigned int);
+    uring->completion_ring_size = parameters.cq_off.cqes + parameters.cq_entries * sizeof (struct io_uring_cqe);
+
+    if (parameters.features & IORING_FEAT_SINGLE_MMAP) {
+        uring->submission_ring_size = MAX(uring->submission_ring_size, uring->completion_ring_size);
+    }
+
+    uring->submission_ring = map_ring(uring->ring_descriptor, uring->submission_ring_size, IORING_OFF_SQ_RING);
+
+    if (parameters.features & IORING_FEAT_SINGLE_MMAP) {
+        uring->completion_ring = uring->submission_ring;
+    } else {
+        uring->completion_ring = map_ring(uring->ring_descriptor, uring->completion_ring_size, IORING_OFF_CQ_RING);
+    }
+
+    uring->submission_entries_size = parameters.sq_entries * sizeof (struct io_uring_sqe);
+    uring->submission_entries      = map_ring(uring->ring_descriptor, uring->submission_entries_size, IORING_OFF_SQES);
+
+    if ((uring->submission_ring == NULL) || (uring->completion_ring == NULL) || (uring->submission_entries == NULL)) {
+        destroy_uring(uring);
+        return FALSE;
+    }
+
+    char* submission_ring = (char *) uring->submission_ring;
+    char* completion_ring = (char *) uring->completion_ring;
+
+    uring->submission_head  = (unsigned int *) (submission_ring + parameters.sq_off.head);
+    uring->submission_tail  = (unsigned int *) (submission_ring + parameters.sq_off.tail);
+    uring->submission_mask  = (unsigned int *) (submission_ring + parameters.sq_off.ring_mask);
+    uring->submission_array = (unsigned int *) (submission_ring + parameters.sq_off.array);
+
+    uring->completion_head    = (unsigned int *) (completion_ring + parameters.cq_off.head);
+    uring->completion_tail    = (unsigned int *) (completion_ring + parameters.cq_off.tail);
+    uring->completion_mask    = (unsigned int *) (completion_ring + parameters.cq_off.ring_mask);
+    uring->completion_entries = (struct io_uring_cqe *) (completion_ring + parameters.cq_off.cqes);
+
+    uring->buffer_size = buffer_size;
+
+    if (posix_memalign((void **) &uring->buffers, (size_t) sysconf(_SC_PAGESIZE), depth * buffer_size)) {
+        fatal_error("Memory allocation failure in create_uring()");
+    }
+
+    uring->registered = register_buffers(uring);
+
+    return TRUE;
+}
+
+char* uring_buffer(const struct uring_t* uring, unsigned int index) {
+    return uring->buffers + (size_t) index * uring->buffer_size;
+}
+
+void uring_prepare_read(struct uring_t* uring, unsigned int index, int file_descriptor, off_t offset, size_t length) {
+    const unsigned int tail = *uring->submission_tail;
+    const unsigned int slot = tail & *uring->submission_mask;
+
+    struct io_uring_sqe* entry = &uring->submission_entries[slot];
+
+    memset(entry, 0, sizeof (struct io_uring_sqe));
+
+    entry->opcode    = (uring->registered) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    entry->fd        = file_descriptor;
+    entry->off       = (__u64) offset;
+    entry->addr      = (__u64) (uintptr_t) uring_buffer(uring, index);
+    entry->len       = (__u32) length;
+    entry->buf_index = (__u16) index;
+    entry->user_data = index;
+
+    uring->submission_array[slot] = slot;
+
+    __atomic_store_n(uring->submission_tail, tail + 1, __ATOMIC_RELEASE);
+
+    ++uring->pending;
+}
+
+/** The kernel is only entered if there is nothing to reap already, or there
+ *  are reads waiting to be submitted, in which case they are submitted and
+ *  waited on in the same system call.
+ * 
+ */
+unsigned int uring_wait_for_read(struct uring_t* uring, ssize_t* result) {
+    unsigned int head = *uring->completion_head;
+
+    while ((uring->pending > 0) || (head == __atomic_load_n(uring->completion_tail, __ATOMIC_ACQUIRE))) {
+        int submitted = uring_enter(uring->ring_descriptor, uring->pending, 1, IORING_ENTER_GETEVENTS);
+
+        if (submitted == -1) {
+            if ((errno == EINTR) || (errno == EAGAIN)) {
+                continue;
+            }
+
+            fatal_error("Failed to submit reads to io_uring");
+        }
+
+        uring->pending -= MIN((unsigned int) submitted, uring->pending);
+    }
+
+    const struct io_uring_cqe* entry = &uring->completion_entries[head & *uring->completion_mask];
+
+    const unsigned int index = (unsigned int) entry->user_data;
+
+    *result = entry->res;
+
+    __atomic_store_n(uring->completion_head, head + 1, __ATOMIC_RELEASE);
+
+    return index;
+}
+
+void destroy_uring(struct uring_t* uring) {
+    if (uring->submission_entries) {
+        munmap(uring->submission_entries, uring->submission_entries_size);
+    }
+
+    if (uring->completion_ring && (uring->completion_ring != uring->submission_ring)) {
+        munmap(uring->completion_ring, uring->completion_ring_size);
+    }
+
+    if (uring->submission_ring) {
+        munmap(uring->submission_ring, uring->submission_ring_size);
+    }
+
+    close(uring->ring_descriptor);
+
+    FREE(uring->buffers);
+}
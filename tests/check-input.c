@@ -0,0 +1,244 @@
+
+#include <check.h>
+
+#include "common.h"
+
+/** This helper writes the given contents to a new temporary file, returning
+ *  its name, which the caller must unlink once it is done with it.
+ * 
+ */
+static char* create_input_file(const char* contents, size_t length) {
+    static char filename[] = "/tmp/check-input-XXXXXX";
+
+    strcpy(filename, "/tmp/check-input-XXXXXX");
+
+    int file_descriptor = mkstemp(filename);
+    ck_assert_int_ne(file_descriptor, -1);
+    ck_assert_int_eq(write(file_descriptor, contents, length), (ssize_t) length);
+    close(file_descriptor);
+
+    return filename;
+}
+
+/** This helper reads the whole input chunk by chunk, checking that the chunks
+ *  are contiguous, that none of them begins or ends in the middle of a word,
+ *  and that together they reproduce the file exactly.
+ * 
+ */
+static void check_chunks(const char* contents, size_t length, io_mode_t io_mode, size_t chunk_size) {
+    settings_set_io_mode(io_mode);
+    settings_set_chunk_size(chunk_size);
+
+    char* filename = create_input_file(contents, length);
+    struct input_t* input = open_input(filename, 1);
+
+    struct input_buffer_t buffer = { NULL, 0 };
+    struct chunk_t chunk;
+
+    size_t total = 0;
+
+    while (claim_input_chunk(input, &chunk)) {
+        const char* data = read_input_chunk(input, &chunk, &buffer);
+
+        if (chunk.length == 0) {
+            break;
+        }
+
+        ck_assert_int_eq(chunk.start, (off_t) total);
+        ck_assert_int_eq(memcmp(data, contents + total, chunk.length), 0);
+
+        total += chunk.length;
+
+        if (total < length) {
+            ck_assert(!is_word_character(contents[total]) || !is_word_character(contents[total - 1]));
+        }
+    }
+
+    ck_assert_uint_eq(total, length);
+
+    release_input_buffer(&buffer);
+    close_input(input);
+    unlink(filename);
+}
+
+/** This helper reads a stream input in full, checking that every chunk ends
+ *  on a word boundary, and that the chunks, which a single thread claims in
+ *  order, reproduce the contents exactly. The input is closed afterwards.
+ * 
+ */
+static void check_stream_input(struct input_t* input, const char* contents, size_t length) {
+    ck_assert_ptr_ne(input->stream, NULL);
+
+    struct input_buffer_t buffer = { NULL, 0 };
+    struct chunk_t chunk;
+
+    size_t total = 0;
+
+    while (claim_input_chunk(input, &chunk)) {
+        const char* data = read_input_chunk(input, &chunk, &buffer);
+
+        ck_assert_uint_gt(chunk.length, 0);
+        ck_assert_uint_le(total + chunk.length, length);
+        ck_assert_int_eq(memcmp(data, contents + total, chunk.length), 0);
+
+        total += chunk.length;
+
+        if (total < length) {
+            ck_assert(!is_word_character(contents[total]) || !is_word_character(contents[total - 1]));
+        }
+
+        release_input_chunk(input, &chunk);
+    }
+
+    ck_assert_uint_eq(total, length);
+
+    release_input_buffer(&buffer);
+    close_input(input);
+}
+
+/** This helper writes the given contents to a pipe and reads it back as a
+ *  stream. The contents must fit in the pipe's buffer.
+ * 
+ */
+static void check_stream_chunks(const char* contents, size_t length, size_t chunk_size) {
+    settings_set_chunk_size(chunk_size);
+
+    int pipe_descriptors[2];
+    ck_assert_int_eq(pipe(pipe_descriptors), 0);
+    ck_assert_int_eq(write(pipe_descriptors[1], contents, length), (ssize_t) length);
+    close(pipe_descriptors[1]);
+
+    char filename[32];
+    snprintf(filename, sizeof (filename), "/dev/fd/%d", pipe_descriptors[0]);
+
+    struct input_t* input = open_input(filename, 1);
+    close(pipe_descriptors[0]);
+
+    check_stream_input(input, contents, length);
+}
+
+/** This helper writes the given contents to a file and reads it back in the
+ *  direct input mode, which streams regular files with O_DIRECT wherever the
+ *  file system allows it.
+ * 
+ */
+static void check_direct_chunks(const char* contents, size_t length, size_t chunk_size) {
+    settings_set_io_mode(IO_DIRECT);
+    settings_set_chunk_size(chunk_size);
+
+    char* filename = create_input_file(contents, length);
+
+    check_stream_input(open_input(filename, 1), contents, length);
+
+    unlink(filename);
+}
+
+START_TEST(ChunksNeverSplitWords)
+{
+    const char* contents = "the quick brown fox, jumped over\nthe lazy dog's 42 bones";
+
+    for (size_t chunk_size = 1; chunk_size < 16; ++chunk_size) {
+        check_chunks(contents, strlen(contents), IO_MMAP, chunk_size);
+        check_chunks(contents, strlen(contents), IO_PREAD, chunk_size);
+    }
+}
+END_TEST
+
+START_TEST(WordLongerThanChunkStaysWhole)
+{
+    static char contents[1000];
+    memset(contents, 'w', sizeof (contents));
+    contents[10] = ' ';
+
+    check_chunks(contents, sizeof (contents), IO_MMAP, 16);
+    check_chunks(contents, sizeof (contents), IO_PREAD, 16);
+}
+END_TEST
+
+START_TEST(FileEndingInWordIsReadInFull)
+{
+    const char* contents = "no trailing delimiter";
+
+    check_chunks(contents, strlen(contents), IO_MMAP, 4);
+    check_chunks(contents, strlen(contents), IO_PREAD, 4);
+    check_chunks(contents, strlen(contents), IO_PREAD, 4096);
+}
+END_TEST
+
+START_TEST(StreamChunksNeverSplitWords)
+{
+    const char* contents = "the quick brown fox, jumped over\nthe lazy dog's 42 bones";
+
+    for (size_t chunk_size = 1; chunk_size < 16; ++chunk_size) {
+        check_stream_chunks(contents, strlen(contents), chunk_size);
+    }
+}
+END_TEST
+
+START_TEST(StreamWordLongerThanChunkStaysWhole)
+{
+    static char contents[1000];
+    memset(contents, 'w', sizeof (contents));
+    contents[10] = ' ';
+
+    check_stream_chunks(contents, sizeof (contents), 16);
+    check_stream_chunks("", 0, 16);
+}
+END_TEST
+
+START_TEST(DirectChunksNeverSplitWords)
+{
+    static char contents[20000];
+
+    for (size_t i = 0; i < sizeof (contents); ++i) {
+        contents[i] = ((i % 7) == 6) ? ' ' : (char) ('a' + (i % 26));
+    }
+
+    memset(contents + 9000, 'w', 5000);
+
+    for (size_t chunk_size = 1; chunk_size <= 16384; chunk_size *= 4) {
+        check_direct_chunks(contents, sizeof (contents), chunk_size);
+        check_direct_chunks(contents, 4097, chunk_size);
+    }
+
+    check_direct_chunks("", 0, 4096);
+}
+END_TEST
+
+START_TEST(EmptyFileHasNoChunks)
+{
+    check_chunks("", 0, IO_MMAP, 4096);
+    check_chunks("", 0, IO_PREAD, 4096);
+}
+END_TEST
+
+__attribute__((returns_nonnull))
+Suite* input_suite(void)
+{
+    Suite* suite = suite_create("Input Suite");
+
+    /* Create core test case */
+    TCase* core_test_case = tcase_create("Core Test Case");
+    tcase_add_test(core_test_case, ChunksNeverSplitWords);
+    tcase_add_test(core_test_case, WordLongerThanChunkStaysWhole);
+    tcase_add_test(core_test_case, FileEndingInWordIsReadInFull);
+    tcase_add_test(core_test_case, EmptyFileHasNoChunks);
+    tcase_add_test(core_test_case, StreamChunksNeverSplitWords);
+    tcase_add_test(core_test_case, StreamWordLongerThanChunkStaysWhole);
+    tcase_add_test(core_test_case, DirectChunksNeverSplitWords);
+    suite_add_tcase(suite, core_test_case);
+
+    return suite;
+}
+
+int main(void)
+{
+    Suite* input_test_suite = input_suite();
+    SRunner* runner = srunner_create(input_test_suite);
+
+    srunner_run_all(runner, CK_NORMAL);
+    int failed_tests = srunner_ntests_failed(runner);
+    srunner_free(runner);
+
+    return (failed_tests) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+
+#include <check.h>
+
+#include "common.h"
+
+START_TEST(ArenaAllocationsAreAligned)
+{
+    struct arena_t arena;
+    initialize_arena(&arena, 4096);
+
+    for (size_t alignment = 1; alignment <= 64; alignment *= 2) {
+        void* allocation = arena_allocate(&arena, 3, alignment);
+
+        ck_assert_uint_eq((uintptr_t) allocation % alignment, 0);
+    }
+
+    release_arena(&arena);
+}
+END_TEST
+
+START_TEST(AlignedAllocationNearBlockEndStaysInBlock)
+{
+    struct arena_t arena;
+    initialize_arena(&arena, 256);
+
+    arena_allocate(&arena, 250, 1);
+    unsigned char* allocation = arena_allocate(&arena, 1, 64);
+
+    ck_assert_uint_eq((uintptr_t) allocation % 64, 0);
+    ck_assert(allocation >= arena.end - arena.block_size);
+    ck_assert(allocation < arena.end);
+
+    release_arena(&arena);
+}
+END_TEST
+
+START_TEST(ArenaAllocationsAreContiguous)
+{
+    struct arena_t arena;
+    initialize_arena(&arena, 4096);
+
+    char* first = arena_allocate(&arena, 5, 1);
+    char* second = arena_allocate(&arena, 7, 1);
+
+    ck_assert_ptr_eq(second, first + 5);
+
+    release_arena(&arena);
+}
+END_TEST
+
+START_TEST(LargeAllocationKeepsCurrentBlock)
+{
+    struct arena_t arena;
+    initialize_arena(&arena, 4096);
+
+    char* first = arena_allocate(&arena, 16, 1);
+    char* large = arena_allocate(&arena, 100000, 1);
+    char* second = arena_allocate(&arena, 16, 1);
+
+    memset(large, 'x', 100000);
+
+    ck_assert_ptr_eq(second, first + 16);
+
+    release_arena(&arena);
+}
+END_TEST
+
+START_TEST(ReleasedArenaCanBeReused)
+{
+    struct arena_t arena;
+    initialize_arena(&arena, 64);
+
+    for (int i = 0; i < 1000; ++i) {
+        memset(arena_allocate(&arena, 24, 8), 0, 24);
+    }
+
+    release_arena(&arena);
+
+    ck_assert_ptr_eq(arena.blocks, NULL);
+
+    char* allocation = arena_allocate(&arena, 24, 8);
+    memset(allocation, 0, 24);
+
+    release_arena(&arena);
+}
+END_TEST
+
+__attribute__((returns_nonnull))
+Suite* mem_suite(void)
+{
+    Suite* suite = suite_create("Mem Suite");
+
+    /* Create core test case */
+    TCase* core_test_case = tcase_create("Core Test Case");
+    tcase_add_test(core_test_case, ArenaAllocationsAreAligned);
+    tcase_add_test(core_test_case, AlignedAllocationNearBlockEndStaysInBlock);
+    tcase_add_test(core_test_case, ArenaAllocationsAreContiguous);
+    tcase_add_test(core_test_case, LargeAllocationKeepsCurrentBlock);
+    tcase_add_test(core_test_case, ReleasedArenaCanBeReused);
+    suite_add_tcase(suite, core_test_case);
+
+    return suite;
+}
+
+int main(void)
+{
+    Suite* mem_test_suite = mem_suite();
+    SRunner* runner = srunner_create(mem_test_suite);
+
+    srunner_run_all(runner, CK_NORMAL);
+    int failed_tests = srunner_ntests_failed(runner);
+    srunner_free(runner);
+
+    return (failed_tests) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+
+#include <check.h>
+
+#include "common.h"
+
+/** This helper writes the given number of bytes of space-separated words to a
+ *  new temporary file and opens it as the given input number. The file is
+ *  unlinked right away, since the open input keeps it alive.
+ * 
+ */
+static struct input_t* create_input(size_t length, int file) {
+    char filename[] = "/tmp/check-schedule-XXXXXX";
+
+    int file_descriptor = mkstemp(filename);
+    ck_assert_int_ne(file_descriptor, -1);
+
+    for (size_t i = 0; i < length; ++i) {
+        char c = ((i % 8) == 7) ? ' ' : 'w';
+        ck_assert_int_eq(write(file_descriptor, &c, 1), 1);
+    }
+
+    close(file_descriptor);
+
+    struct input_t* input = open_input(filename, file);
+    unlink(filename);
+
+    return input;
+}
+
+/** This helper records the bytes covered by a task, checking that none of them
+ *  had already been handed out by an earlier task.
+ * 
+ */
+static void mark_task(const struct task_t* task, char* covered) {
+    for (size_t i = 0; i < task->chunk.length; ++i) {
+        ck_assert_int_eq(covered[task->chunk.start + i], 0);
+        covered[task->chunk.start + i] = 1;
+    }
+}
+
+START_TEST(EveryChunkIsHandedOutOnce)
+{
+    settings_set_io_mode(IO_MMAP);
+    settings_set_chunk_size(64);
+
+    static char covered1[5000];
+    static char covered2[300];
+
+    struct input_t* inputs[2] = { create_input(sizeof (covered1), 1), create_input(sizeof (covered2), 2) };
+    struct scheduler_t* scheduler = create_scheduler(inputs, 2, 3);
+
+    struct task_t task;
+
+    for (size_t worker = 0; next_task(scheduler, worker, &task); worker = (worker + 1) % 3) {
+        mark_task(&task, (task.input == inputs[0]) ? covered1 : covered2);
+    }
+
+    ck_assert_ptr_eq(memchr(covered1, 0, sizeof (covered1)), NULL);
+    ck_assert_ptr_eq(memchr(covered2, 0, sizeof (covered2)), NULL);
+
+    free_scheduler(scheduler);
+    close_input(inputs[0]);
+    close_input(inputs[1]);
+}
+END_TEST
+
+START_TEST(WorkerMovesOnToOtherInput)
+{
+    settings_set_io_mode(IO_PREAD);
+    settings_set_chunk_size(16);
+
+    static char covered1[100];
+    static char covered2[2000];
+
+    struct input_t* inputs[2] = { create_input(sizeof (covered1), 1), create_input(sizeof (covered2), 2) };
+    struct scheduler_t* scheduler = create_scheduler(inputs, 2, 2);
+
+    struct task_t task;
+
+    while (next_task(scheduler, 0, &task)) {
+        mark_task(&task, (task.input == inputs[0]) ? covered1 : covered2);
+    }
+
+    ck_assert_ptr_eq(memchr(covered1, 0, sizeof (covered1)), NULL);
+    ck_assert_ptr_eq(memchr(covered2, 0, sizeof (covered2)), NULL);
+
+    ck_assert(!next_task(scheduler, 1, &task));
+
+    free_scheduler(scheduler);
+    close_input(inputs[0]);
+    close_input(inputs[1]);
+}
+END_TEST
+
+START_TEST(IdleWorkerStealsQueuedChunks)
+{
+    settings_set_io_mode(IO_MMAP);
+    settings_set_chunk_size(64);
+
+    static char covered[64 * TASK_DEQUE_CAPACITY];
+
+    struct input_t* inputs[1] = { create_input(sizeof (covered), 1) };
+    struct scheduler_t* scheduler = create_scheduler(inputs, 1, 2);
+
+    struct task_t task;
+
+    ck_assert(next_task(scheduler, 0, &task));
+    ck_assert_int_eq(task.chunk.start, 0);
+    mark_task(&task, covered);
+
+    ck_assert(next_task(scheduler, 1, &task));
+    ck_assert_int_gt(task.chunk.start, 0);
+    mark_task(&task, covered);
+
+    while (next_task(scheduler, 0, &task)) {
+        mark_task(&task, covered);
+    }
+
+    ck_assert_ptr_eq(memchr(covered, 0, sizeof (covered)), NULL);
+
+    free_scheduler(scheduler);
+    close_input(inputs[0]);
+}
+END_TEST
+
+START_TEST(AvailableProcessorsIsPositive)
+{
+    ck_assert_int_gt(available_processors(), 0);
+}
+END_TEST
+
+__attribute__((returns_nonnull))
+Suite* schedule_suite(void)
+{
+    Suite* suite = suite_create("Schedule Suite");
+
+    /* Create core test case */
+    TCase* core_test_case = tcase_create("Core Test Case");
+    tcase_add_test(core_test_case, EveryChunkIsHandedOutOnce);
+    tcase_add_test(core_test_case, WorkerMovesOnToOtherInput);
+    tcase_add_test(core_test_case, IdleWorkerStealsQueuedChunks);
+    tcase_add_test(core_test_case, AvailableProcessorsIsPositive);
+    suite_add_tcase(suite, core_test_case);
+
+    return suite;
+}
+
+int main(void)
+{
+    Suite* schedule_test_suite = schedule_suite();
+    SRunner* runner = srunner_create(schedule_test_suite);
+
+    srunner_run_all(runner, CK_NORMAL);
+    int failed_tests = srunner_ntests_failed(runner);
+    srunner_free(runner);
+
+    return (failed_tests) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -12,6 +12,15 @@ START_TEST(EmptyStringsMatch)
 }
 END_TEST
 
+START_TEST(ParseSizeAppliesSuffixes)
+{
+    ck_assert_uint_eq(parse_size("4096"), 4096);
+    ck_assert_uint_eq(parse_size("64K"), 64 * 1024);
+    ck_assert_uint_eq(parse_size("3m"), 3 * 1024 * 1024);
+    ck_assert_uint_eq(parse_size("2G"), 2ULL * 1024 * 1024 * 1024);
+}
+END_TEST
+
 __attribute__((returns_nonnull))
 Suite* string_suite(void)
 {
@@ -20,6 +29,7 @@ Suite* string_suite(void)
     /* Create core test case */
     TCase* core_test_case = tcase_create("Core Test Case");
     tcase_add_test(core_test_case, EmptyStringsMatch);
+    tcase_add_test(core_test_case, ParseSizeAppliesSuffixes);
     suite_add_tcase(suite, core_test_case);
 
     return suite;
@@ -0,0 +1,170 @@
+
+#include <check.h>
+
+#include "common.h"
+
+/** This helper runs the tokenizer over the whole buffer in batches of the
+ *  given capacity, collecting every token into the caller's array.
+ * 
+ */
+static size_t tokenize_all(const char* buffer, size_t length, struct token_t* tokens, size_t capacity) {
+    struct tokenizer_t tokenizer;
+    initialize_tokenizer(&tokenizer, buffer, length);
+
+    size_t total = 0;
+    size_t found = 0;
+
+    while ((found = next_tokens(&tokenizer, tokens + total, capacity)) != 0) {
+        total += found;
+    }
+
+    return total;
+}
+
+/** This is the definition of a word straight out of the program spec, applied
+ *  one byte at a time, to check the tokenizer against.
+ * 
+ */
+static int is_word_byte(char c) {
+    return ((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'));
+}
+
+static size_t reference_tokenize(const char* buffer, size_t length, struct token_t* tokens) {
+    size_t total = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        if (is_word_byte(buffer[i]) && ((i == 0) || !is_word_byte(buffer[i - 1]))) {
+            tokens[total].start = buffer + i;
+            tokens[total].length = 0;
+            ++total;
+        }
+
+        if (is_word_byte(buffer[i])) {
+            ++tokens[total - 1].length;
+        }
+    }
+
+    return total;
+}
+
+START_TEST(EmptyBufferHasNoTokens)
+{
+    struct token_t tokens[TOKEN_BATCH_SIZE];
+
+    ck_assert_uint_eq(tokenize_all("", 0, tokens, TOKEN_BATCH_SIZE), 0);
+}
+END_TEST
+
+START_TEST(DelimitersOnlyHaveNoTokens)
+{
+    const char* buffer = " \n\t!?-_~\"\x01\x7f\x80\xff";
+    struct token_t tokens[TOKEN_BATCH_SIZE];
+
+    ck_assert_uint_eq(tokenize_all(buffer, strlen(buffer), tokens, TOKEN_BATCH_SIZE), 0);
+}
+END_TEST
+
+START_TEST(WordsAreSplitOnNonAlphanumerics)
+{
+    const char* buffer = "apple,banana\r\nCherry_42\xe9tude";
+    struct token_t tokens[TOKEN_BATCH_SIZE];
+
+    ck_assert_uint_eq(tokenize_all(buffer, strlen(buffer), tokens, TOKEN_BATCH_SIZE), 5);
+    ck_assert_uint_eq(tokens[0].length, 5);
+    ck_assert_int_eq(strncmp(tokens[0].start, "apple", 5), 0);
+    ck_assert_uint_eq(tokens[1].length, 6);
+    ck_assert_int_eq(strncmp(tokens[1].start, "banana", 6), 0);
+    ck_assert_uint_eq(tokens[2].length, 6);
+    ck_assert_int_eq(strncmp(tokens[2].start, "Cherry", 6), 0);
+    ck_assert_uint_eq(tokens[3].length, 2);
+    ck_assert_int_eq(strncmp(tokens[3].start, "42", 2), 0);
+    ck_assert_uint_eq(tokens[4].length, 4);
+    ck_assert_int_eq(strncmp(tokens[4].start, "tude", 4), 0);
+}
+END_TEST
+
+START_TEST(WordsSpanBlockBoundaries)
+{
+    char buffer[200];
+    memset(buffer, 'x', sizeof (buffer));
+    buffer[10] = ' ';
+    buffer[130] = ' ';
+
+    struct token_t tokens[TOKEN_BATCH_SIZE];
+
+    ck_assert_uint_eq(tokenize_all(buffer, sizeof (buffer), tokens, TOKEN_BATCH_SIZE), 3);
+    ck_assert_uint_eq(tokens[0].length, 10);
+    ck_assert_uint_eq(tokens[1].length, 119);
+    ck_assert_uint_eq(tokens[2].length, 69);
+}
+END_TEST
+
+START_TEST(WordEndingAtEndOfFullBlock)
+{
+    char buffer[128];
+    memset(buffer, 'y', sizeof (buffer));
+    buffer[0] = ' ';
+
+    struct token_t tokens[TOKEN_BATCH_SIZE];
+
+    ck_assert_uint_eq(tokenize_all(buffer, sizeof (buffer), tokens, TOKEN_BATCH_SIZE), 1);
+    ck_assert_ptr_eq(tokens[0].start, buffer + 1);
+    ck_assert_uint_eq(tokens[0].length, 127);
+}
+END_TEST
+
+START_TEST(MatchesReferenceInSmallBatches)
+{
+    static char buffer[100003];
+    static struct token_t expected[sizeof (buffer)];
+    static struct token_t actual[sizeof (buffer)];
+
+    unsigned int state = 12345;
+    const char* alphabet = "aZ09 .\n\x80";
+
+    for (size_t i = 0; i < sizeof (buffer); ++i) {
+        state = state * 1103515245 + 12345;
+        buffer[i] = alphabet[(state >> 16) % 8];
+    }
+
+    size_t expected_total = reference_tokenize(buffer, sizeof (buffer), expected);
+    size_t actual_total = tokenize_all(buffer, sizeof (buffer), actual, 33);
+
+    ck_assert_uint_eq(actual_total, expected_total);
+
+    for (size_t i = 0; i < expected_total; ++i) {
+        ck_assert_ptr_eq(actual[i].start, expected[i].start);
+        ck_assert_uint_eq(actual[i].length, expected[i].length);
+    }
+}
+END_TEST
+
+__attribute__((returns_nonnull))
+Suite* tokenize_suite(void)
+{
+    Suite* suite = suite_create("Tokenize Suite");
+
+    /* Create core test case */
+    TCase* core_test_case = tcase_create("Core Test Case");
+    tcase_add_test(core_test_case, EmptyBufferHasNoTokens);
+    tcase_add_test(core_test_case, DelimitersOnlyHaveNoTokens);
+    tcase_add_test(core_test_case, WordsAreSplitOnNonAlphanumerics);
+    tcase_add_test(core_test_case, WordsSpanBlockBoundaries);
+    tcase_add_test(core_test_case, WordEndingAtEndOfFullBlock);
+    tcase_add_test(core_test_case, MatchesReferenceInSmallBatches);
+    suite_add_tcase(suite, core_test_case);
+
+    return suite;
+}
+
+int main(void)
+{
+    Suite* tokenize_test_suite = tokenize_suite();
+    SRunner* runner = srunner_create(tokenize_test_suite);
+
+    srunner_run_all(runner, CK_NORMAL);
+    int failed_tests = srunner_ntests_failed(runner);
+    srunner_free(runner);
+
+    return (failed_tests) ? EXIT_FAILURE : EXIT_SUCCESS;
+}